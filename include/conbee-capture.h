@@ -0,0 +1,85 @@
+#ifndef __CONNBEE_CAPTURE_H__
+#define __CONNBEE_CAPTURE_H__
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file */
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+
+/// magic number at the start of a capture ("CBCP")
+#define CONBEE_CAPTURE_MAGIC          0x50434243
+
+/// version of the capture format
+#define CONBEE_CAPTURE_VERSION        1
+
+/**
+* @brief header at the start of a capture file, followed by the records
+*
+* a capture is a stream of records, each one a conbee_capture_record directly followed
+* by its raw bytes. The direction of a record is CONBEE_TRACE_TX or CONBEE_TRACE_RX.
+*/
+struct conbee_capture_header
+{
+  /// CONBEE_CAPTURE_MAGIC
+  uint32_t magic;
+
+  /// CONBEE_CAPTURE_VERSION
+  uint16_t version;
+
+  /// number of bytes of this header, the first record starts right after it
+  uint16_t header_size;
+
+  /// wall clock time the capture was started in nanoseconds since the epoch
+  uint64_t start_realtime_ns;
+};
+
+/**
+* @brief header of one record of a capture
+*/
+struct conbee_capture_record
+{
+  /// microseconds since the previous record or the start of the capture
+  uint32_t delta_us;
+
+  /// number of raw bytes following the record header
+  uint16_t length;
+
+  /// CONBEE_TRACE_TX or CONBEE_TRACE_RX
+  uint8_t direction;
+
+  /// reserved, always 0
+  uint8_t reserved;
+};
+
+/**
+* @brief a capture recorded by the worker of a device
+*/
+struct conbee_capture
+{
+  /// the capture file
+  FILE *file;
+
+  /// monotonic time of the previous record in microseconds
+  uint64_t last_us;
+
+  /// a write to the file failed, nothing is recorded anymore
+  uint8_t failed;
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef __CONNBEE_DISPATCH_H__
+#define __CONNBEE_DISPATCH_H__
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file */
+#include <stdint.h>
+#include <pthread.h>
+
+struct conbee_device;
+struct conbee_aps_indication;
+
+/// number of buckets of the aps handler hash table, has to be a power of two
+#define APS_HANDLER_BUCKETS           256
+
+/// number of different wildcard combinations of (src endpoint, dst endpoint, profile, cluster)
+#define APS_HANDLER_PATTERNS          16
+
+/**
+* @brief one registered aps handler, chained within a hash bucket
+*/
+struct conbee_aps_handler
+{
+  /// the key (src endpoint, dst endpoint, profile, cluster and wildcard pattern) of the handler
+  uint64_t key;
+
+  /// the function called for every matching aps indication
+  int32_t (*cb)(struct conbee_device *dev, struct conbee_aps_indication *indication, void *userdata);
+
+  /// user supplied pointer handed to the callback
+  void *userdata;
+
+  /// next handler within the same bucket
+  struct conbee_aps_handler *next;
+};
+
+/**
+* @brief hash table of aps handlers keyed by (src endpoint, dst endpoint, profile, cluster)
+*
+* wildcard fields are zeroed in the key and the wildcard pattern is stored in the
+* upper bits of the key. A lookup therefore costs one hash probe per wildcard pattern
+* in use, the exact match is always probed first.
+*/
+struct conbee_aps_handler_table
+{
+  /// the hash buckets
+  struct conbee_aps_handler *buckets[APS_HANDLER_BUCKETS];
+
+  /// number of registered handlers per wildcard pattern
+  uint32_t patterns[APS_HANDLER_PATTERNS];
+
+  /// read/write lock protecting the table, dispatching only requires the read lock
+  pthread_rwlock_t lock;
+};
+
+/**
+* @brief initialize an aps handler table
+*
+* @param table - pointer to the table
+*/
+void conbee_aps_handler_table_init(struct conbee_aps_handler_table *table);
+
+/**
+* @brief free all handlers of an aps handler table
+*
+* @param table - pointer to the table
+*/
+void conbee_aps_handler_table_free(struct conbee_aps_handler_table *table);
+
+#endif
@@ -20,6 +20,12 @@
 /** @file */
 #include <stdint.h>
 #include <conbee.h>
+#include <sys/uio.h>
+
+struct slip_decoder;
+
+/// the maximum number of bytes of a slip encoded frame including checksum and END bytes
+#define CONBEE_FRAME_MAX_ENCODED      (2 * (1000 + 2) + 2)
 
 /**
 * @brief helper function to transmit one byte through the tty to the conbee stick
@@ -46,6 +52,122 @@ int32_t conbee_write_byte(struct conbee_device *dev, uint8_t c);
 */
 int32_t conbee_read_byte(struct conbee_device *dev, uint8_t *c);
 
+/**
+* @brief helper function to transmit a buffer through the tty to the conbee stick
+*
+* @param dev    - pointer to a conbee_device structure, please make sure the device is already connected
+* @param buffer - the bytes to transfer
+* @param length - the number of bytes to transfer
+*
+* @return 0   - everything went fine
+* @return -1  - error occured, use errno to find out what
+* @return -2  - conbee device is not connected
+*/
+int32_t conbee_write_buffer(struct conbee_device *dev, uint8_t *buffer, uint32_t length);
+
+/**
+* @brief helper function to transmit many buffers at once through the transport to the conbee stick
+*
+* @param dev    - pointer to a conbee_device structure, please make sure the device is already connected
+* @param iov    - the buffers to transfer, modified while transferring
+* @param iovcnt - the number of buffers
+*
+* @return 0   - everything went fine
+* @return -1  - error occured, use errno to find out what
+* @return -2  - conbee device is not connected
+*/
+int32_t conbee_write_iov(struct conbee_device *dev, struct iovec *iov, int iovcnt);
+
+/**
+* @brief reserve consecutive sequence numbers for requests
+*
+* @param dev - the device to reserve the sequence numbers at
+* @param n   - the number of sequence numbers to reserve
+*
+* @return the first reserved sequence number
+*/
+uint8_t conbee_reserve_sequence_numbers(struct conbee_device *dev, uint16_t n);
+
+/**
+* @brief push a frame with an already assigned sequence number to the send queue and wake up the worker
+*
+* @param dev   - the device to send the frame with
+* @param frame - the frame to send, it is freed after transmission
+*/
+void conbee_push_frame(struct conbee_device *dev, struct conbee_frame *frame);
+
+/**
+* @brief push frames with already assigned sequence numbers to the send queue and wake up the worker once
+*
+* @param dev    - the device to send the frames with
+* @param frames - array of n frames to send, they are freed after transmission
+* @param n      - the number of frames
+*/
+void conbee_push_frames(struct conbee_device *dev, struct conbee_frame **frames, uint16_t n);
+
+/**
+* @brief look up a parameter in the parameter cache
+*
+* @param dev       - the device
+* @param parameter - the parameter id
+* @param value     - the cached value
+*
+* @return   0 - the value was found
+* @return  -1 - the cache is disabled or does not contain the value
+*/
+int32_t conbee_parameter_cache_get(struct conbee_device *dev, uint8_t parameter, uint64_t *value);
+
+/**
+* @brief return the current generation of the parameter cache
+*
+* fetch the generation before requesting a value from the stick and hand it to
+* conbee_parameter_cache_store, so values overtaken by an invalidation are not stored
+*
+* @param dev - the device
+*
+* @return the current generation
+*/
+uint32_t conbee_parameter_cache_generation(struct conbee_device *dev);
+
+/**
+* @brief store a value read from the stick in the parameter cache
+*
+* @param dev        - the device
+* @param parameter  - the parameter id
+* @param value      - the value read from the stick
+* @param generation - the cache generation fetched before the value was requested
+*/
+void conbee_parameter_cache_store(struct conbee_device *dev, uint8_t parameter, uint64_t value, uint32_t generation);
+
+/**
+* @brief return the raw device state byte carried by a frame
+*
+* @param  frame      - pointer to the frame to parse
+* @param  state_byte - the device state byte as sent by the stick
+*
+* @return   0 - everything worked fine
+* @return  -1 - no state information could be found
+*/
+int32_t conbee_device_state_byte(struct conbee_frame *frame, uint8_t *state_byte);
+
+/**
+* @brief split a raw device state byte into a device state structure
+*
+* @param  stateByte - the device state byte as sent by the stick
+* @param  state     - pointer to the state to save the state in
+*/
+void conbee_device_state_decode(uint8_t stateByte, struct conbee_device_state *state);
+
+/**
+* @brief update the tracked device state, only called by the worker
+*
+* calls the device state callback if the state changed
+*
+* @param dev        - the device the state was received from
+* @param state_byte - the device state byte as sent by the stick
+*/
+void conbee_device_state_update(struct conbee_device *dev, uint8_t state_byte);
+
 /**
 * @brief write one frame to the conbee stick
 *
@@ -70,4 +192,257 @@ int32_t conbee_write_frame(struct conbee_device *dev, struct conbee_frame *frame
 */
 int32_t conbee_read_frame(struct conbee_device *dev, struct conbee_frame *frame);
 
+/**
+* @brief serialize a frame including checksum and slip encode it
+*
+* @param frame  - the frame to encode, the status is set to zero as on all requests
+* @param output - buffer of CONBEE_FRAME_MAX_ENCODED bytes receiving the encoded frame
+*
+* @return the number of bytes written to output
+*/
+uint32_t conbee_encode_frame(struct conbee_frame *frame, uint8_t *output);
+
+/**
+* @brief check the checksum of a received slip decoded packet and create the frame from it
+*
+* @param dev    - the conbee_device the packet was received from
+* @param buffer - the slip decoded packet
+* @param length - the length of the packet including the checksum
+* @param frame  - the frame, the function allocates enough space for the payload if required, free it with conbee_free_frame
+*
+* @return   0 - everything went fine
+* @return  -1 - the packet is too short or its checksum is wrong
+*/
+int32_t conbee_decode_frame(struct conbee_device *dev, uint8_t *buffer, uint32_t length, struct conbee_frame *frame);
+
+/**
+* @brief read from the file descriptor of a transport
+*
+* @return  >0 - the number of bytes read
+* @return   0 - the transport has been closed by the other side
+* @return  -1 - error occured, use errno to find out what
+*/
+ssize_t conbee_transport_fd_read(struct conbee_transport *transport, uint8_t *buffer, uint32_t length);
+
+/**
+* @brief write to the file descriptor of a transport
+*
+* @return >=0 - the number of bytes written
+* @return  -1 - error occured, use errno to find out what
+*/
+ssize_t conbee_transport_fd_writev(struct conbee_transport *transport, const struct iovec *iov, int iovcnt);
+
+/**
+* @brief return the file descriptor of a transport
+*/
+int32_t conbee_transport_fd(struct conbee_transport *transport);
+
+/**
+* @brief close the file descriptor of a transport
+*/
+void conbee_transport_fd_close(struct conbee_transport *transport);
+
+/**
+* @brief send a watchdog refresh if it is due, called by the worker on every iteration
+*
+* @param dev - the device
+*/
+void conbee_watchdog_poll(struct conbee_device *dev);
+
+/**
+* @brief consume the response to a watchdog refresh, called by the worker for every received frame
+*
+* @param dev   - the device
+* @param frame - the received frame
+*
+* @return   1 - the frame was the response to a refresh and has been freed
+* @return   0 - the frame is no response to a refresh
+*/
+int32_t conbee_watchdog_response(struct conbee_device *dev, struct conbee_frame *frame);
+
+/**
+* @brief check if the worker reopens the transport once it fails
+*
+* @param dev - the device
+*
+* @return 1 - reconnecting is enabled
+* @return 0 - reconnecting is disabled
+*/
+uint8_t conbee_reconnect_enabled(struct conbee_device *dev);
+
+/**
+* @brief keep a copy of the requests about to be written to the stick, only called by the worker
+*
+* @param dev   - the device
+* @param iov   - the slip encoded bytes of every frame, may contain many frames each
+* @param count - the number of buffers
+*/
+void conbee_reconnect_record(struct conbee_device *dev, struct iovec *iov, int count);
+
+/**
+* @brief drop the copy of the request a received frame answers, only called by the worker
+*
+* @param dev   - the device
+* @param frame - the received frame
+*/
+void conbee_reconnect_response(struct conbee_device *dev, struct conbee_frame *frame);
+
+/**
+* @brief close the failed transport and handle the unanswered requests, only called by the worker
+*
+* @param dev - the device
+*/
+void conbee_reconnect_link_down(struct conbee_device *dev);
+
+/**
+* @brief try to reopen the transport if an attempt is due, only called by the worker
+*
+* @param dev     - the device
+* @param decoder - the slip decoder of the device, reset after reopening
+*
+* @return   0 - the transport has been reopened
+* @return  -1 - the link is still down
+*/
+int32_t conbee_reconnect_poll(struct conbee_device *dev, struct slip_decoder *decoder);
+
+/**
+* @brief free the copies of the unanswered requests, the worker has to be stopped already
+*
+* @param dev - the device
+*/
+void conbee_reconnect_free(struct conbee_device *dev);
+
+/**
+* @brief change the depth of a queue and track its high-water mark
+*
+* call it while holding the mutex of the queue, readers do not need the mutex
+*
+* @param depth      - the depth counter of the queue
+* @param high_water - the high-water mark of the queue
+* @param delta      - the number of frames added, negative for removed frames
+*/
+void conbee_stats_queue_depth(uint32_t *depth, uint32_t *high_water, int32_t delta);
+
+/**
+* @brief count frames about to be written to the stick, only called by the worker
+*
+* @param dev    - the device
+* @param frames - the frames
+* @param iov    - the slip encoded bytes of every frame, may contain many frames each
+* @param count  - the number of frames and buffers
+*/
+void conbee_stats_transmitted(struct conbee_device *dev, struct conbee_frame **frames, struct iovec *iov, int count);
+
+/**
+* @brief count frames whose write to the stick failed, only called by the worker
+*
+* @param dev    - the device
+* @param frames - the frames, pre-encoded frames may contain many frames each
+* @param count  - the number of frames
+*/
+void conbee_stats_write_failure(struct conbee_device *dev, struct conbee_frame **frames, int count);
+
+/**
+* @brief count a valid frame received from the stick, only called by the worker
+*
+* @param dev     - the device
+* @param frame   - the received frame
+* @param length  - the number of slip encoded bytes of the frame
+* @param escapes - the number of escaped bytes within the frame
+*/
+void conbee_stats_received(struct conbee_device *dev, struct conbee_frame *frame, uint32_t length, uint32_t escapes);
+
+/**
+* @brief count a received frame dropped because of a wrong checksum or length, only called by the worker
+*
+* @param dev - the device
+*/
+void conbee_stats_checksum_failure(struct conbee_device *dev);
+
+/**
+* @brief count an attempt to reopen the transport, only called by the worker
+*
+* @param dev     - the device
+* @param err     - 0 if the transport has been reopened, -1 if not
+* @param down_us - the time the link has been down in microseconds
+*/
+void conbee_stats_reconnect(struct conbee_device *dev, int32_t err, uint64_t down_us);
+
+/**
+* @brief count the requests written again or failed because the link went down, only called by the worker
+*
+* @param dev     - the device
+* @param retried - the number of requests written again
+* @param failed  - the number of requests answered with STATUS_ERROR
+*/
+void conbee_stats_requests_resolved(struct conbee_device *dev, uint32_t retried, uint32_t failed);
+
+/**
+* @brief return the monotonic time in microseconds
+*/
+uint64_t conbee_now_us();
+
+/**
+* @brief return the monotonic time in nanoseconds if timestamps are enabled
+*
+* @param dev - the device
+*
+* @return the time, 0 if timestamps are disabled
+*/
+uint64_t conbee_timestamp(struct conbee_device *dev);
+
+/**
+* @brief remember the timestamps of requests written to the stick, only called by the worker
+*
+* @param dev        - the device
+* @param frames     - the written frames
+* @param count      - the number of frames
+* @param written_ns - the time the write completed
+*/
+void conbee_timestamps_written(struct conbee_device *dev, struct conbee_frame **frames, int count, uint64_t written_ns);
+
+/**
+* @brief attach the timestamps of its request to a received frame, only called by the worker
+*
+* @param dev         - the device
+* @param frame       - the received frame
+* @param received_ns - the time the first bytes of the frame were read
+*/
+void conbee_timestamps_received(struct conbee_device *dev, struct conbee_frame *frame, uint64_t received_ns);
+
+/**
+* @brief record the wakeup of the waiter of a frame and call the trace callback
+*
+* @param dev   - the device
+* @param frame - the frame picked up by the waiter
+*/
+void conbee_timestamps_woken(struct conbee_device *dev, struct conbee_frame *frame);
+
+/**
+* @brief record raw bytes written to or read from the stick, only called by the worker
+*
+* @param dev       - the device
+* @param direction - CONBEE_TRACE_TX or CONBEE_TRACE_RX
+* @param data      - the raw bytes
+* @param length    - the number of raw bytes
+*/
+void conbee_wire_trace_record(struct conbee_device *dev, uint8_t direction, uint8_t *data, uint32_t length);
+
+/**
+* @brief stop recording and free the wire trace, the worker has to be stopped already
+*
+* @param dev - the device
+*/
+void conbee_wire_trace_free(struct conbee_device *dev);
+
+/**
+* @brief record raw bytes written to or read from the stick into the capture, only called by the worker
+*
+* @param dev       - the device
+* @param direction - CONBEE_TRACE_TX or CONBEE_TRACE_RX
+* @param data      - the raw bytes
+* @param length    - the number of raw bytes
+*/
+void conbee_capture_record(struct conbee_device *dev, uint8_t direction, uint8_t *data, uint32_t length);
+
 #endif
@@ -0,0 +1,75 @@
+#ifndef __CONNBEE_POOL_H__
+#define __CONNBEE_POOL_H__
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file */
+#include <stdint.h>
+#include <pthread.h>
+
+struct conbee_device;
+
+/// the maximum number of devices of a pool
+#define POOL_MAX_DEVICES              16
+
+/// number of frames waiting for transmission from which a device counts as saturated
+#define POOL_QUEUE_LIMIT              64
+
+/**
+* @brief one device of a pool
+*/
+struct conbee_pool_member
+{
+  /// the device, owned by the user
+  struct conbee_device *dev;
+
+  /// hash of the device name, the weight of the device for the rendezvous hashing
+  uint64_t seed;
+
+  /// number of requests routed to the device, accessed atomically
+  uint64_t routed;
+};
+
+/**
+* @brief several sticks of the same network sharing the outbound aps traffic
+*
+* every destination is ranked against the devices by rendezvous hashing and is sent with the
+* first stick of its ranking. Adding or removing a stick only moves the destinations of that
+* stick. A destination moves to the next stick of its ranking while its own stick is down or
+* saturated (POOL_QUEUE_LIMIT frames waiting or no free request slots), which happens under
+* load. The order of the requests to a destination is only kept as long as it does not move,
+* spills and failovers count the moved requests.
+*/
+struct conbee_pool
+{
+  /// the devices of the pool
+  struct conbee_pool_member members[POOL_MAX_DEVICES];
+
+  /// number of devices
+  uint32_t nr_members;
+
+  /// number of requests routed away from a stick which is down, accessed atomically
+  uint64_t failovers;
+
+  /// number of requests routed away from a saturated stick, accessed atomically
+  uint64_t spills;
+
+  /// read/write lock protecting the members, routing only requires the read lock
+  pthread_rwlock_t lock;
+};
+
+#endif
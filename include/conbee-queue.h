@@ -59,6 +59,14 @@ void conbee_queue_init(struct conbee_queue_root* queue);
 */
 void conbee_queue_push(struct conbee_queue_root* queue, void *content);
 
+/**
+* @brief push contents to the front of the queue, it is popped next
+*
+* @param queue - pointer to the head of the queue
+* @param contents - the content to enqueue
+*/
+void conbee_queue_push_front(struct conbee_queue_root* queue, void *content);
+
 /**
 * @brief pop content from the queue
 *
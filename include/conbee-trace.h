@@ -0,0 +1,120 @@
+#ifndef __CONNBEE_TRACE_H__
+#define __CONNBEE_TRACE_H__
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file */
+#include <stdint.h>
+
+/// magic number at the start of a wire trace ("CBTR")
+#define CONBEE_TRACE_MAGIC            0x52544243
+
+/// version of the wire trace format
+#define CONBEE_TRACE_VERSION          1
+
+/// alignment of the records within the ring, a padding record always fits
+#define CONBEE_TRACE_ALIGN            16
+
+/// minimum number of bytes of the ring
+#define CONBEE_TRACE_MIN_SIZE         16384
+
+/// padding record filling the end of the ring, its bytes have no meaning
+#define CONBEE_TRACE_PAD              0
+
+/// bytes written to the stick
+#define CONBEE_TRACE_TX               1
+
+/// bytes read from the stick
+#define CONBEE_TRACE_RX               2
+
+/**
+* @brief header of a wire trace, followed by the ring of records
+*
+* positions count all bytes ever written, the offset of a position within the ring is
+* position % size. The records from tail to head are complete, the worker advances the
+* tail before it overwrites the oldest records.
+*/
+struct conbee_trace_header
+{
+  /// CONBEE_TRACE_MAGIC
+  uint32_t magic;
+
+  /// CONBEE_TRACE_VERSION
+  uint16_t version;
+
+  /// number of bytes of this header, the ring starts right after it
+  uint16_t header_size;
+
+  /// number of bytes of the ring, a multiple of CONBEE_TRACE_ALIGN
+  uint64_t size;
+
+  /// position the next record is written to
+  uint64_t head;
+
+  /// position of the oldest complete record
+  uint64_t tail;
+
+  /// add to a record timestamp to get the wall clock time in nanoseconds since the epoch
+  int64_t realtime_offset_ns;
+
+  /// number of records written since the trace was started, including overwritten ones
+  uint64_t records;
+};
+
+/**
+* @brief header of one record, followed by the raw bytes padded to CONBEE_TRACE_ALIGN
+*/
+struct conbee_trace_record
+{
+  /// number of raw bytes following the record header
+  uint32_t length;
+
+  /// CONBEE_TRACE_TX, CONBEE_TRACE_RX or CONBEE_TRACE_PAD
+  uint8_t direction;
+
+  /// reserved, always 0
+  uint8_t reserved[3];
+
+  /// monotonic time the bytes were written or read in nanoseconds
+  uint64_t timestamp_ns;
+};
+
+/**
+* @brief a wire trace recorded by the worker of a device
+*/
+struct conbee_wire_trace
+{
+  /// the header, directly followed by the ring
+  struct conbee_trace_header *header;
+
+  /// the ring
+  uint8_t *ring;
+
+  /// number of bytes mapped for header and ring
+  uint64_t mapped;
+};
+
+/**
+* @brief return the number of ring bytes used by a record with the given number of raw bytes
+*
+* @param length - the number of raw bytes of the record
+*
+* @return the number of bytes including record header and padding
+*/
+uint64_t conbee_trace_record_size(uint32_t length);
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef __CONNBEE_TRANSPORT_H__
+#define __CONNBEE_TRANSPORT_H__
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file */
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+struct conbee_transport;
+
+/**
+* @brief the operations of a transport, the byte stream between the library and a stick
+*
+* a transport moves already slip encoded bytes, framing is done by the library
+*/
+struct conbee_transport_ops
+{
+  /// the address prefix selecting the transport, e.g. "tcp://", the tty transport has "tty://" and is used for addresses without prefix as well
+  const char *prefix;
+
+  /**
+  * @brief open the transport
+  *
+  * @param transport - the transport to open
+  * @param address   - the address without prefix, e.g. the tty device or host:port
+  *
+  * @return   0 - everything went fine
+  * @return  -1 - error occured, use errno to find out what
+  */
+  int32_t (*open)(struct conbee_transport *transport, const char *address);
+
+  /**
+  * @brief read the bytes available, blocks only if none are available
+  *
+  * @return  >0 - the number of bytes read
+  * @return   0 - the transport has been closed by the other side
+  * @return  -1 - error occured, use errno to find out what
+  */
+  ssize_t (*read)(struct conbee_transport *transport, uint8_t *buffer, uint32_t length);
+
+  /**
+  * @brief write the given buffers, may write less than requested like writev(2)
+  *
+  * @return >=0 - the number of bytes written
+  * @return  -1 - error occured, use errno to find out what
+  */
+  ssize_t (*writev)(struct conbee_transport *transport, const struct iovec *iov, int iovcnt);
+
+  /**
+  * @brief return the file descriptor to wait for received data with select(2)
+  */
+  int32_t (*fd)(struct conbee_transport *transport);
+
+  /**
+  * @brief close the transport
+  */
+  void (*close)(struct conbee_transport *transport);
+};
+
+/**
+* @brief an opened transport
+*/
+struct conbee_transport
+{
+  /// the operations of the transport
+  const struct conbee_transport_ops *ops;
+
+  /// file descriptor of the transport
+  int32_t fd;
+
+  /// transport specific data
+  void *priv;
+};
+
+/// transport for a stick attached to a local tty, used for addresses without prefix
+extern const struct conbee_transport_ops conbee_transport_tty;
+
+/// transport for a stick exported by a tcp server like ser2net, address "tcp://host:port"
+extern const struct conbee_transport_ops conbee_transport_tcp;
+
+/// in process transport for emulators and tests, address "loopback://"
+extern const struct conbee_transport_ops conbee_transport_loopback;
+
+/// transport for a stick shared by a local daemon, address "unix:///path/of/socket"
+extern const struct conbee_transport_ops conbee_transport_unix;
+
+/// transport replaying the bytes received in a capture, address "replay://file" or "replay://file?fast"
+extern const struct conbee_transport_ops conbee_transport_replay;
+
+/**
+* @brief find the transport for an address
+*
+* @param address - the address, e.g. /dev/ttyACM0 or tcp://host:port
+* @param rest    - receives a pointer to the address without the transport prefix, may be NULL
+*
+* @return the transport operations, the tty transport if no prefix matches
+*/
+const struct conbee_transport_ops * conbee_transport_lookup(const char *address, const char **rest);
+
+#endif
@@ -21,6 +21,11 @@
 
 #include <stdint.h>
 #include <conbee-queue.h>
+#include <conbee-dispatch.h>
+#include <conbee-transport.h>
+#include <conbee-trace.h>
+#include <conbee-capture.h>
+#include <conbee-pool.h>
 #include <pthread.h>
 #include <unistd.h>
 
@@ -71,6 +76,9 @@
 
 /// the device is leaving the network at the moment
 #define NETWORK_LEAVING       0x03
+
+/// set in conbee_device::device_state as soon as the stick reported its state
+#define DEVICE_STATE_KNOWN    0x100
 /** @} */
 
 
@@ -187,6 +195,46 @@
 /// the watchdog time to live
 #define PARAM_WATCHDOG_TTL            0x26
 
+/// number of parameter ids covered by the parameter cache, all PARAM_* ids are below
+#define PARAMETER_CACHE_SIZE          0x40
+
+/// maximum number of bytes of a parameter value, the network key is the largest one
+#define PARAMETER_MAX_LENGTH          16
+
+/** @} */
+
+/**
+ * @defgroup CONNBEE parameter descriptor flags
+ *
+ * @{
+ */
+
+/// the parameter can be read from the stick
+#define PARAMETER_READABLE            0x01
+
+/// the parameter can be written to the stick
+#define PARAMETER_WRITABLE            0x02
+
+/// the parameter is transmitted most significant byte first
+#define PARAMETER_BIG_ENDIAN          0x04
+
+/// the parameter is a byte array without integer representation
+#define PARAMETER_RAW                 0x08
+
+/** @} */
+
+/**
+ * @defgroup CONNBEE batch parameter write flags
+ *
+ * @{
+ */
+
+/// read back every written parameter and compare it with the written value
+#define WRITE_PARAMETERS_VERIFY       0x01
+
+/// restore the previous values if any write or verification fails
+#define WRITE_PARAMETERS_ROLLBACK     0x02
+
 /** @} */
 
 /**
@@ -225,6 +273,20 @@
 /// use IEEE addressing, sometimes referred to as MAC addressing
 #define DEST_ADDR_IEEE                0x03
 
+/// NWK and IEEE address are both present, only used as source address mode of indications
+#define SRC_ADDR_NWK_IEEE             0x04
+
+/** @} */
+
+/**
+ * @defgroup CONNBEE aps handler matching
+ *
+ * @{
+ */
+
+/// wildcard for conbee_register_aps_handler, matches every endpoint, profile or cluster
+#define APS_MATCH_ANY                 -1
+
 /** @} */
 
 /**
@@ -253,6 +315,292 @@
  /** @} */
 
 
+struct conbee_device_state;
+struct conbee_frame;
+
+/**
+* @brief cache of device parameters which rarely change
+*/
+struct conbee_parameter_cache
+{
+  /// is the cache enabled
+  uint8_t enabled;
+
+  /// incremented on every invalidation, values read before an invalidation are not stored
+  uint32_t generation;
+
+  /// which parameters have a valid cached value
+  uint8_t valid[PARAMETER_CACHE_SIZE];
+
+  /// the cached values indexed by parameter id
+  uint64_t value[PARAMETER_CACHE_SIZE];
+
+  /// mutex protecting the cache
+  pthread_mutex_t mutex;
+};
+
+/**
+* @brief statistics of the watchdog refresher
+*
+* the jitter is the time a refresh was sent later than scheduled, it grows if the
+* worker is overloaded
+*/
+struct conbee_watchdog_stats
+{
+  /// number of refreshes sent to the stick
+  uint64_t refreshes;
+
+  /// number of refreshes the stick did not acknowledge successfully
+  uint64_t failures;
+
+  /// jitter of the last refresh in microseconds
+  uint64_t last_jitter_us;
+
+  /// maximum jitter in microseconds
+  uint64_t max_jitter_us;
+
+  /// mean jitter in microseconds
+  uint64_t mean_jitter_us;
+};
+
+/**
+* @brief state of the watchdog refresher run by the worker
+*/
+struct conbee_watchdog
+{
+  /// the time to live written to the stick in seconds, 0 if the refresher is disabled
+  uint32_t ttl;
+
+  /// refresh period in milliseconds
+  uint64_t period_ms;
+
+  /// monotonic time of the next refresh in microseconds
+  uint64_t deadline_us;
+
+  /// sequence number of the unanswered refresh, -1 if there is none
+  int16_t pending;
+
+  /// function called whenever a refresh fails
+  void (*cb)(struct conbee_device *dev, uint8_t status, void *userdata);
+
+  /// user supplied pointer handed to cb
+  void *userdata;
+
+  /// sum of all jitters in microseconds, for the mean
+  uint64_t total_jitter_us;
+
+  /// the statistics
+  struct conbee_watchdog_stats stats;
+
+  /// mutex protecting the watchdog
+  pthread_mutex_t mutex;
+};
+
+/// the transport is not reopened after it failed, the default
+#define RECONNECT_DISABLED            0
+
+/// requests written before the link went down are written again after reconnecting
+#define RECONNECT_RETRY               1
+
+/// requests written before the link went down are answered with STATUS_ERROR right away
+#define RECONNECT_FAIL                2
+
+/// unanswered requests written this long before the link went down are failed instead of retried in milliseconds
+#define RECONNECT_MAX_AGE_MS          10000
+
+/**
+* @brief state of the automatic reconnect run by the worker
+*/
+struct conbee_reconnect
+{
+  /// what happens to the requests written before the link went down, RECONNECT_DISABLED if disabled
+  uint8_t policy;
+
+  /// time between two attempts to reopen the transport in milliseconds
+  uint32_t interval_ms;
+
+  /// mutex protecting policy and interval_ms
+  pthread_mutex_t mutex;
+
+  /// monotonic time the link went down in microseconds, only used by the worker
+  uint64_t down_us;
+
+  /// monotonic time of the next attempt in microseconds, only used by the worker
+  uint64_t next_attempt_us;
+
+  /// slip encoded copy of every unanswered request indexed by sequence number, NULL if none, only used by the worker
+  uint8_t *inflight[256];
+
+  /// number of bytes of every copy
+  uint32_t inflight_length[256];
+
+  /// command of every copy, a response has to match it
+  uint8_t inflight_command[256];
+
+  /// monotonic time every copy was written in microseconds
+  uint64_t inflight_us[256];
+};
+
+/**
+* @brief monotonic timestamps of the life of a request and its response in nanoseconds
+*
+* only recorded while enabled with conbee_enable_frame_timestamps, unrecorded steps are 0.
+* A received response carries the timestamps of its request as well.
+*/
+struct conbee_frame_timestamps
+{
+  /// the request was pushed to the send queue
+  uint64_t enqueued_ns;
+
+  /// the worker took the request from the send queue
+  uint64_t dequeued_ns;
+
+  /// the request has been written to the transport
+  uint64_t written_ns;
+
+  /// the first bytes of the response have been read from the transport
+  uint64_t received_ns;
+
+  /// the response has been decoded
+  uint64_t decoded_ns;
+
+  /// the waiter of the response has been woken up and found it
+  uint64_t woken_ns;
+};
+
+/// number of buckets of the latency histograms, see struct conbee_stats
+#define STATS_HISTOGRAM_BUCKETS       24
+
+/// number of commands with own frame counters, indexed by the command id
+#define STATS_COMMANDS                32
+
+/**
+* @brief frame counters of one command
+*/
+struct conbee_command_stats
+{
+  /// number of frames written to the stick
+  uint64_t tx_frames;
+
+  /// number of slip encoded bytes written to the stick
+  uint64_t tx_bytes;
+
+  /// number of valid frames received from the stick
+  uint64_t rx_frames;
+
+  /// number of slip encoded bytes of the valid frames received from the stick
+  uint64_t rx_bytes;
+};
+
+/**
+* @brief statistics of a device, as returned by conbee_get_stats
+*
+* bucket 0 of the latency histograms counts latencies below 1 microsecond, bucket i
+* latencies from 2^(i-1) to below 2^i microseconds. The last bucket counts everything above.
+*/
+struct conbee_stats
+{
+  /// counters per command, commands from STATS_COMMANDS on are counted at index 0
+  struct conbee_command_stats commands[STATS_COMMANDS];
+
+  /// number of frames written to the stick
+  uint64_t tx_frames;
+
+  /// number of slip encoded bytes written to the stick
+  uint64_t tx_bytes;
+
+  /// number of valid frames received from the stick
+  uint64_t rx_frames;
+
+  /// number of slip encoded bytes of the valid frames received from the stick
+  uint64_t rx_bytes;
+
+  /// number of bytes escaped by the slip encoding of transmitted frames
+  uint64_t tx_escapes;
+
+  /// number of escaped bytes within received frames
+  uint64_t rx_escapes;
+
+  /// number of frames counted as written to the stick whose write failed
+  uint64_t tx_failures;
+
+  /// number of received frames dropped because of a wrong checksum or length
+  uint64_t checksum_failures;
+
+  /// number of received frames no request is waiting for, e.g. responses to timed out requests
+  uint64_t unmatched_responses;
+
+  /// number of received frames with status STATUS_BUSY
+  uint64_t busy_statuses;
+
+  /// number of frames waiting for transmission
+  uint32_t send_queue_depth;
+
+  /// maximum number of frames waiting for transmission
+  uint32_t send_queue_high_water;
+
+  /// number of received frames nobody has picked up yet
+  uint32_t receive_queue_depth;
+
+  /// maximum number of received frames nobody has picked up yet
+  uint32_t receive_queue_high_water;
+
+  /// histogram of the time from enqueueing a frame until it is written to the stick
+  uint64_t enqueue_to_wire[STATS_HISTOGRAM_BUCKETS];
+
+  /// histogram of the time from writing a request until its response is received
+  uint64_t request_to_response[STATS_HISTOGRAM_BUCKETS];
+
+  /// number of times the transport has been reopened after it failed
+  uint64_t reconnects;
+
+  /// number of failed attempts to reopen the transport
+  uint64_t reconnect_failures;
+
+  /// time the link was down before the last reconnect in microseconds
+  uint64_t last_reconnect_us;
+
+  /// maximum time the link was down before a reconnect in microseconds
+  uint64_t max_reconnect_us;
+
+  /// number of requests written again after reconnecting
+  uint64_t retried_requests;
+
+  /// number of requests answered with STATUS_ERROR because the link went down
+  uint64_t failed_requests;
+};
+
+/**
+* @brief statistics state of a device
+*
+* the counters are only written by the worker and read through a sequence lock, so
+* neither side ever waits for the other. The queue depths are updated atomically by
+* whoever holds the mutex of the queue anyway.
+*/
+struct conbee_stats_state
+{
+  /// the counters written by the worker
+  struct conbee_stats counters;
+
+  /// sequence lock of counters, odd while the worker updates them
+  uint32_t sequence;
+
+  /// monotonic time each outstanding request was written in microseconds, 0 if none, indexed by sequence number
+  uint64_t sent_us[256];
+
+  /// number of frames waiting for transmission
+  uint32_t send_queue_depth;
+
+  /// maximum number of frames waiting for transmission
+  uint32_t send_queue_high_water;
+
+  /// number of received frames nobody has picked up yet
+  uint32_t receive_queue_depth;
+
+  /// maximum number of received frames nobody has picked up yet
+  uint32_t receive_queue_high_water;
+};
+
 /**
 * @brief a conbee device represented by the name of the uart/tty device
 *
@@ -262,9 +610,12 @@ struct conbee_device
   /// the name of the tty device the conbee stick is connected to like /dev/ttyACM0
   char tty[200];
 
-  /// file descriptor to the opened tty device
+  /// file descriptor to the opened tty device, the file descriptor of the transport
   int32_t fd;
 
+  /// the transport carrying the frames to and from the stick
+  struct conbee_transport transport;
+
   /// status of the tty
   int8_t tty_status;
 
@@ -308,12 +659,93 @@ struct conbee_device
   /// mutex to protext worker_running and worker_stop
   pthread_mutex_t mutex_worker;
 
+  /// cleared by the worker once the transport failed or has been closed, accessed atomically
+  uint8_t link_up;
+
   /// counter for request sequence numbers
   uint8_t sequence_number;
 
   /// mutex to protect sequence_number
   pthread_mutex_t mutex_sequence_number;
 
+  /// handlers for received aps indications
+  struct conbee_aps_handler_table aps_handlers;
+
+  /// cache for the conbee_get_* parameter functions
+  struct conbee_parameter_cache parameter_cache;
+
+  /// last device state byte reported by the stick, DEVICE_STATE_KNOWN is set once a state was received, accessed atomically
+  uint32_t device_state;
+
+  /// function called by the worker whenever the reported device state changes
+  void (*device_state_cb)(struct conbee_device *dev, struct conbee_device_state *state, void *userdata);
+
+  /// user supplied pointer handed to device_state_cb
+  void *device_state_userdata;
+
+  /// mutex protecting device_state_cb, device_state_userdata and device_state_cb_running
+  pthread_mutex_t mutex_device_state_cb;
+
+  /// the worker is calling device_state_cb
+  uint8_t device_state_cb_running;
+
+  /// condition variable signalling that device_state_cb returned
+  pthread_cond_t cond_device_state_cb;
+
+  /// the watchdog refresher, run by the worker
+  struct conbee_watchdog watchdog;
+
+  /// the automatic reconnect, run by the worker
+  struct conbee_reconnect reconnect;
+
+  /// the statistics of the device
+  struct conbee_stats_state stats;
+
+  /// record frame timestamps, accessed atomically
+  uint8_t timestamps_enabled;
+
+  /// timestamps of the outstanding requests indexed by sequence number, only used by the worker
+  struct conbee_frame_timestamps timestamps[256];
+
+  /// function called whenever a waiter picks up a received frame while timestamps are enabled
+  void (*trace_cb)(struct conbee_device *dev, struct conbee_frame *frame, void *userdata);
+
+  /// user supplied pointer handed to trace_cb
+  void *trace_userdata;
+
+  /// mutex protecting trace_cb and trace_userdata
+  pthread_mutex_t mutex_trace_cb;
+
+  /// the ring recording the raw bytes written and read by the worker, NULL while disabled, accessed atomically
+  struct conbee_wire_trace *wire_trace;
+
+  /// the capture file recording the raw bytes written and read by the worker, NULL while disabled
+  struct conbee_capture *capture;
+
+  /// mutex protecting capture
+  pthread_mutex_t mutex_capture;
+
+  /// function taking every received frame before it is queued
+  int32_t (*subscriber_cb)(struct conbee_device *dev, struct conbee_frame *frame, void *userdata);
+
+  /// user supplied pointer handed to subscriber_cb
+  void *subscriber_userdata;
+
+  /// mutex protecting subscriber_cb, subscriber_userdata, subscriber_running and the subscriber filter
+  pthread_mutex_t mutex_subscriber;
+
+  /// the worker is calling subscriber_cb
+  uint8_t subscriber_running;
+
+  /// condition variable signalling that subscriber_cb returned
+  pthread_cond_t cond_subscriber;
+
+  /// bitmap of the commands offered to subscriber_cb, bit (command % 8) of byte (command / 8)
+  uint8_t subscriber_commands[32];
+
+  /// the cluster of the aps data indications offered to subscriber_cb or APS_MATCH_ANY
+  int32_t subscriber_cluster;
+
 };
 
 
@@ -341,6 +773,21 @@ struct conbee_frame
   /// the buffer for sending a payload
   uint8_t *payload;
 
+  /// already slip encoded bytes which are written to the tty as they are, NULL for normal frames
+  uint8_t *wire;
+
+  /// the number of bytes in wire
+  uint32_t wire_length;
+
+  /// monotonic time the frame was pushed to the send queue in microseconds
+  uint64_t enqueued_us;
+
+  /// the number of frames within wire, 0 for normal frames
+  uint16_t wire_frames;
+
+  /// the lifecycle timestamps of the frame
+  struct conbee_frame_timestamps timestamps;
+
 };
 
 /**
@@ -383,9 +830,168 @@ struct conbee_device_state
   uint8_t apsde_data_request_free_slots;
 };
 
+/**
+* @brief a decoded APSDE-DATA.indication
+*
+*/
+struct conbee_aps_indication
+{
+  /// the device state reported together with the indication
+  uint8_t device_state;
+
+  /// the destination address mode (DEST_ADDR_*)
+  uint8_t dst_addr_mode;
+
+  /// the group or NWK destination address
+  uint16_t dst_addr;
+
+  /// the IEEE destination address, only valid for DEST_ADDR_IEEE
+  uint64_t dst_ieee_addr;
+
+  /// the destination endpoint, zero for group addressing
+  uint8_t dst_endpoint;
+
+  /// the source address mode (DEST_ADDR_NWK, DEST_ADDR_IEEE or SRC_ADDR_NWK_IEEE)
+  uint8_t src_addr_mode;
+
+  /// the NWK source address
+  uint16_t src_addr;
+
+  /// the IEEE source address, only valid for DEST_ADDR_IEEE and SRC_ADDR_NWK_IEEE
+  uint64_t src_ieee_addr;
+
+  /// the source endpoint
+  uint8_t src_endpoint;
+
+  /// the zigbee profile id
+  uint16_t profile_id;
+
+  /// the zigbee cluster id
+  uint16_t cluster_id;
+
+  /// the number of bytes of the asdu
+  uint16_t asdu_length;
+
+  /// pointer to the asdu, points into the payload of the parsed frame
+  uint8_t *asdu;
+
+  /// link quality of the received frame
+  uint8_t lqi;
+
+  /// received signal strength of the frame in dBm
+  int8_t rssi;
+};
+
+/**
+* @brief a device parameter together with the status of reading or writing it
+*/
+struct conbee_parameter
+{
+  /// the parameter id (PARAM_*)
+  uint8_t id;
+
+  /// the status returned by the stick (STATUS_*)
+  uint8_t status;
+
+  /// the number of valid bytes of the value
+  uint8_t length;
+
+  /// the value as transmitted by the stick (little endian)
+  union
+  {
+    /// 8 bit view of the value
+    uint8_t  u8;
+
+    /// 16 bit view of the value
+    uint16_t u16;
+
+    /// 32 bit view of the value
+    uint32_t u32;
+
+    /// 64 bit view of the value
+    uint64_t u64;
+
+    /// raw bytes of the value, e.g. for the network key
+    uint8_t  bytes[PARAMETER_MAX_LENGTH];
+  } value;
+};
+
+/**
+* @brief description of a device parameter, drives the generic parameter functions
+*/
+struct conbee_parameter_descriptor
+{
+  /// the parameter id (PARAM_*)
+  uint8_t id;
+
+  /// short name of the parameter, e.g. for command line tools
+  const char *name;
+
+  /// the number of bytes of the value
+  uint8_t length;
+
+  /// PARAMETER_READABLE, PARAMETER_WRITABLE, PARAMETER_BIG_ENDIAN and PARAMETER_RAW
+  uint8_t flags;
+};
+
+/**
+* @brief destination of an aps data request
+*/
+struct conbee_aps_address
+{
+  /// the destination address mode (DEST_ADDR_*)
+  uint8_t addr_mode;
+
+  /// the group or NWK address, used for DEST_ADDR_GROUP and DEST_ADDR_NWK
+  uint16_t addr;
+
+  /// the IEEE address, used for DEST_ADDR_IEEE
+  uint64_t ieee_addr;
+
+  /// the destination endpoint, ignored for group addressing
+  uint8_t endpoint;
+};
+
+/**
+* @brief an APSDE-DATA.request
+*/
+struct conbee_aps_request
+{
+  /// id to match the APSDE-DATA.confirm, conbee_aps_send_many uses the sequence number of each frame
+  uint8_t request_id;
+
+  /// the destination of the request
+  struct conbee_aps_address dst;
+
+  /// the zigbee profile id
+  uint16_t profile_id;
+
+  /// the zigbee cluster id
+  uint16_t cluster_id;
+
+  /// the source endpoint
+  uint8_t src_endpoint;
+
+  /// the number of bytes of the asdu
+  uint16_t asdu_length;
+
+  /// the asdu to transmit
+  uint8_t *asdu;
+
+  /// the transmission options
+  uint8_t tx_options;
+
+  /// the maximum number of hops, ROUTE_HOP_COUNT_UNLIMITED for no limit
+  uint8_t radius;
+};
+
 /**
 * @brief function to connect to the conbee stick on the given tty
 *
+* the transport is selected by the prefix of the name, "tcp://host:port" connects to a
+* stick exported by a tcp server, "loopback://" creates an in process transport, every
+* other name is opened as tty.
+*
 * @param dev     - pointer to a conbee_device structure, please make memory is already allocated
 * @param ttyname - c string containing the full path to the tty device of the conbee stick
 *
@@ -394,6 +1000,41 @@ struct conbee_device_state
 */
 int32_t conbee_connect(struct conbee_device *dev, char *ttyname);
 
+/**
+* @brief function to connect to the conbee stick using the given transport
+*
+* @param dev      - pointer to a conbee_device structure, please make memory is already allocated
+* @param ops      - the transport to use
+* @param address  - the address of the stick, the prefix of the transport is optional
+*
+* @return < 0 - an error occured, use errno to get the error code of the system
+* @return   0 - everything went fine
+*/
+int32_t conbee_connect_transport(struct conbee_device *dev, const struct conbee_transport_ops *ops, const char *address);
+
+/**
+* @brief take the other end of a loopback transport, e.g. to attach an emulator to it
+*
+* @param dev - a device connected with the loopback transport
+*
+* @return >=0 - the file descriptor, it is owned by the caller from now on
+* @return  -1 - the device is not connected with the loopback transport or the peer was already taken
+*/
+int32_t conbee_loopback_peer(struct conbee_device *dev);
+
+/**
+* @brief check whether a replayed capture has been read completely
+*
+* all frames of the capture are in the receive queue once this returns 1
+*
+* @param dev - a device connected with the replay transport
+*
+* @return   1 - the whole capture has been read
+* @return   0 - the replay is still running
+* @return  -1 - the device is not connected with the replay transport
+*/
+int32_t conbee_replay_finished(struct conbee_device *dev);
+
 
 /**
 * @brief function to close the connection to the conbee stick
@@ -437,6 +1078,71 @@ int32_t conbee_enqueue_frame(struct conbee_device *dev, struct conbee_frame *fra
 int32_t conbee_wait_for_frame(struct conbee_device *dev, struct conbee_frame **frame, uint8_t sequence_number, uint8_t command);
 
 
+/**
+* @brief wait for the reception of many frames at once
+*
+* returns as soon as a frame for every sequence number has been received, the frames are
+* stored in the order of the sequence numbers. Free the frames after processing !!!
+*
+* @param dev              - the conbee_device to read the frames from, make sure it is already connected
+* @param frames           - array of n pointers receiving the frames
+* @param sequence_numbers - array of n distinct sequence numbers to wait for
+* @param n                - the number of frames to wait for, at most 256
+* @param command          - wait for this command type or COMMAND_ANY
+*
+* @return   0 - everything went fine, all frames are received
+* @return  -1 - error occured, use ernno to find out what
+*/
+int32_t conbee_wait_for_frames(struct conbee_device *dev, struct conbee_frame **frames, uint8_t *sequence_numbers, uint16_t n, uint8_t command);
+
+/**
+* @brief take the oldest received frame without waiting
+*
+* free the frame after processing !!!
+*
+* @param dev   - the conbee_device to read the frame from, make sure it is already connected
+* @param frame - the frame received
+*
+* @return   1 - a frame has been taken
+* @return   0 - no frame has been received
+*/
+int32_t conbee_poll_frame(struct conbee_device *dev, struct conbee_frame **frame);
+
+/**
+* @brief set a function taking every received frame before it is queued
+*
+* the subscriber is called by the worker for every received frame except the responses
+* to watchdog refreshes. If it returns 1 it owns the frame and the frame is not queued,
+* so it is never returned by conbee_wait_for_frame. It must not block, the worker does
+* not read or write while the subscriber runs. The subscriber may replace or remove itself.
+* When this function returns the old subscriber is not called anymore, unless this function
+* is called from the subscriber itself.
+*
+* @param dev      - the device, make sure it is already connected
+* @param cb       - the function to call or NULL to remove the subscriber
+* @param userdata - pointer handed to the subscriber
+*/
+void conbee_set_frame_subscriber(struct conbee_device *dev,
+                                 int32_t (*cb)(struct conbee_device *dev, struct conbee_frame *frame, void *userdata),
+                                 void *userdata);
+
+/**
+* @brief restrict the frames offered to the subscriber
+*
+* the worker checks the filter before calling the subscriber, frames not passing it take
+* the normal way as if no subscriber is set. The cluster is only checked for aps data
+* indications, frames of all other accepted commands pass regardless of it.
+*
+* @param dev         - the device, make sure it is already connected
+* @param commands    - array of the accepted commands, NULL to accept all commands
+* @param nr_commands - the number of commands within the array
+* @param cluster     - the accepted cluster of aps data indications or APS_MATCH_ANY
+*
+* @return   0 - everything went fine
+* @return  -1 - the cluster is out of range, errno is set to EINVAL
+*/
+int32_t conbee_set_frame_subscriber_filter(struct conbee_device *dev, const uint8_t *commands, uint16_t nr_commands, int32_t cluster);
+
 /**
 * @brief check if the frame status is success
 *
@@ -664,6 +1370,40 @@ struct conbee_frame * conbee_device_network_leave_request();
 */
 struct conbee_frame * conbee_device_get_aps_data_request();
 
+/**
+* @brief create a frame for an aps data request
+*
+* make sure to *free* the returned frame after using it! Otherwise you will get memory leaks
+*
+* @param request - the request to send
+*
+* @return pointer to the frame for the aps data request, NULL if the request is invalid
+*/
+struct conbee_frame * conbee_aps_data_request(struct conbee_aps_request *request);
+
+/**
+* @brief send the same aps data request to many destinations
+*
+* the request is serialized and slip encoded once, only the destination, sequence number,
+* request id and checksum are patched for each destination. All frames are handed to the
+* worker as one buffer and written to the tty back to back.
+*
+* All destinations have to use the same address mode, the destination of the request
+* itself is ignored. Make sure the stick has enough free request slots for n requests.
+*
+* @param dev              - the device to send the requests with, make sure it is already connected
+* @param request          - the request template
+* @param destinations     - array of n destinations
+* @param n                - the number of destinations, at most 255
+* @param sequence_numbers - array receiving the sequence number used for each destination, may be NULL
+*
+* @return   0 - everything went fine, all requests are enqueued
+* @return  -1 - error occured, use errno to find out what
+* @return  -2 - conbee device is not connected
+*/
+int32_t conbee_aps_send_many(struct conbee_device *dev, struct conbee_aps_request *request, struct conbee_aps_address *destinations,
+                             uint16_t n, uint8_t *sequence_numbers);
+
 /**
 * @brief parse a read_parameter_response into a uint64_t
 *
@@ -705,6 +1445,17 @@ int32_t conbee_read_parameter_response_uint16(struct conbee_frame *frame, uint16
 int32_t conbee_read_parameter_response_uint8(struct conbee_frame *frame, uint8_t *data);
 
 
+/**
+* @brief parse a read_parameter_response into a conbee_parameter
+*
+* @param frame     - the read parameter response
+* @param parameter - the parameter to fill, the status is set even if the frame carries no value
+*
+* @return   0 - everything worked fine
+* @return  -1 - no value available in frame
+*/
+int32_t conbee_read_parameter_response(struct conbee_frame *frame, struct conbee_parameter *parameter);
+
 /**
 * @brief parse a device state response and return a device state structure
 *
@@ -716,7 +1467,491 @@ int32_t conbee_read_parameter_response_uint8(struct conbee_frame *frame, uint8_t
 */
 int32_t conbee_device_state_response(struct conbee_frame *frame, struct conbee_device_state *state);
 
+/**
+* @brief parse an aps data indication response
+*
+* the asdu pointer of the indication points into the payload of the frame, so the frame
+* has to be kept until the indication is no longer used
+*
+* @param  frame      - pointer to the frame to parse
+* @param  indication - pointer to the indication to fill
+*
+* @return   0 - everything worked fine
+* @return  -1 - the frame is no valid aps data indication
+*/
+int32_t conbee_aps_indication_response(struct conbee_frame *frame, struct conbee_aps_indication *indication);
+
+/**
+* @brief register a handler for aps indications
+*
+* every key field can be set to APS_MATCH_ANY. Registering a handler for an already
+* registered key replaces the old handler. If more than one handler matches an indication
+* the most specific one is called, the exact match is always looked up first.
+*
+* @param dev          - the device to register the handler at, make sure it is already connected
+* @param src_endpoint - the source endpoint to match or APS_MATCH_ANY
+* @param dst_endpoint - the destination endpoint to match or APS_MATCH_ANY
+* @param profile      - the profile id to match or APS_MATCH_ANY
+* @param cluster      - the cluster id to match or APS_MATCH_ANY
+* @param cb           - the function to call for matching indications
+* @param userdata     - pointer handed to the callback
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+*/
+int32_t conbee_register_aps_handler(struct conbee_device *dev, int32_t src_endpoint, int32_t dst_endpoint, int32_t profile, int32_t cluster,
+                                    int32_t (*cb)(struct conbee_device *dev, struct conbee_aps_indication *indication, void *userdata), void *userdata);
 
+/**
+* @brief remove a handler registered with conbee_register_aps_handler
+*
+* @param dev          - the device the handler is registered at
+* @param src_endpoint - the source endpoint of the handler or APS_MATCH_ANY
+* @param dst_endpoint - the destination endpoint of the handler or APS_MATCH_ANY
+* @param profile      - the profile id of the handler or APS_MATCH_ANY
+* @param cluster      - the cluster id of the handler or APS_MATCH_ANY
+*
+* @return   0 - handler removed
+* @return  -1 - no such handler registered
+*/
+int32_t conbee_unregister_aps_handler(struct conbee_device *dev, int32_t src_endpoint, int32_t dst_endpoint, int32_t profile, int32_t cluster);
+
+/**
+* @brief decode an aps data indication frame and call the matching handler
+*
+* @param dev   - the device the frame was received from
+* @param frame - the received aps data indication frame, still owned by the caller
+*
+* @return   1 - a handler was called
+* @return   0 - no handler matches the indication
+* @return  -1 - the frame is no valid aps data indication
+*/
+int32_t conbee_dispatch_aps_indication(struct conbee_device *dev, struct conbee_frame *frame);
+
+
+
+/**
+* @brief read many parameters in one pipelined batch
+*
+* all read requests are sent back to back and the responses are collected at once, so
+* reading n parameters costs one round trip instead of n. Values read are stored in
+* the parameter cache if it is enabled.
+*
+* @param dev     - the device to read from, make sure it is already connected
+* @param ids     - array of n parameter ids (PARAM_*)
+* @param n       - the number of parameters to read, at most 255
+* @param results - array of n parameters receiving id, status and value of each parameter
+*
+* @return   0 - all parameters have been read
+* @return  -1 - with errno EIO at least one parameter could not be read, check the status of each result,
+*               with any other errno the request failed as a whole and the results are not set
+* @return  -2 - conbee device is not connected
+*/
+int32_t conbee_read_parameters(struct conbee_device *dev, uint8_t *ids, uint16_t n, struct conbee_parameter *results);
+
+/**
+* @brief return the descriptor of a parameter
+*
+* @param id - the parameter id (PARAM_*)
+*
+* @return pointer to the descriptor, NULL if the parameter is unknown
+*/
+const struct conbee_parameter_descriptor * conbee_parameter_descriptor(uint8_t id);
+
+/**
+* @brief return the descriptors of all parameters known to the library
+*
+* @param n - the number of descriptors
+*
+* @return pointer to the first of n descriptors, sorted by id
+*/
+const struct conbee_parameter_descriptor * conbee_parameter_descriptors(uint16_t *n);
+
+/**
+* @brief convert the value of a parameter into an integer
+*
+* @param descriptor - the descriptor of the parameter
+* @param parameter  - the parameter as read from the stick
+* @param value      - the integer value
+*
+* @return   0 - everything went fine
+* @return  -1 - the parameter is no integer or its length does not match the descriptor
+*/
+int32_t conbee_parameter_decode(const struct conbee_parameter_descriptor *descriptor, struct conbee_parameter *parameter, uint64_t *value);
+
+/**
+* @brief convert an integer into the value of a parameter
+*
+* @param descriptor - the descriptor of the parameter
+* @param value      - the integer value
+* @param parameter  - the parameter to write to the stick, id, length and value are set
+*
+* @return   0 - everything went fine
+* @return  -1 - the parameter is no integer
+*/
+int32_t conbee_parameter_encode(const struct conbee_parameter_descriptor *descriptor, uint64_t value, struct conbee_parameter *parameter);
+
+/**
+* @brief read one parameter, using the parameter cache if enabled
+*
+* @param dev       - the device to read from, make sure it is already connected
+* @param parameter - the parameter to read, the id has to be set, status, length and value are set on return
+*
+* @return   0 - everything went fine
+* @return  -1 - the parameter could not be read, check its status
+* @return  -2 - conbee device is not connected
+*/
+int32_t conbee_get_parameter(struct conbee_device *dev, struct conbee_parameter *parameter);
+
+/**
+* @brief write one parameter
+*
+* @param dev       - the device to write to, make sure it is already connected
+* @param parameter - the parameter to write with id, length and value set, the status is set on return
+*
+* @return   0 - everything went fine
+* @return  -1 - the parameter could not be written, check its status
+* @return  -2 - conbee device is not connected
+*/
+int32_t conbee_set_parameter(struct conbee_device *dev, struct conbee_parameter *parameter);
+
+/**
+* @brief read an integer parameter known to the library
+*
+* @param dev   - the device to read from, make sure it is already connected
+* @param id    - the parameter id (PARAM_*)
+* @param value - the value read
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+* @return  -2 - conbee device is not connected
+*/
+int32_t conbee_get_parameter_uint(struct conbee_device *dev, uint8_t id, uint64_t *value);
+
+/**
+* @brief write an integer parameter known to the library
+*
+* @param dev   - the device to write to, make sure it is already connected
+* @param id    - the parameter id (PARAM_*)
+* @param value - the value to write, truncated to the width of the parameter
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+* @return  -2 - conbee device is not connected
+*/
+int32_t conbee_set_parameter_uint(struct conbee_device *dev, uint8_t id, uint64_t value);
+
+/**
+* @brief write many parameters in one pipelined batch
+*
+* all write requests are sent back to back. With WRITE_PARAMETERS_VERIFY the written
+* parameters are read back in a second batch and compared. With WRITE_PARAMETERS_ROLLBACK
+* the current values are read before writing and every successfully written parameter is
+* restored if any write or verification fails, nothing is written if the current values
+* can not be read.
+*
+* Parameters known to the library as read only are refused before anything is written.
+*
+* @param dev        - the device to write to, make sure it is already connected
+* @param parameters - array of n parameters with id, length and value set, the status of each parameter is set on return
+* @param n          - the number of parameters to write, at most 255
+* @param flags      - WRITE_PARAMETERS_VERIFY and/or WRITE_PARAMETERS_ROLLBACK
+*
+* @return   0 - all parameters have been written (and verified)
+* @return  -1 - at least one parameter could not be written or verified, rolled back if requested
+* @return  -2 - conbee device is not connected
+* @return  -3 - the rollback failed, the configuration is partially applied
+*/
+int32_t conbee_write_parameters(struct conbee_device *dev, struct conbee_parameter *parameters, uint16_t n, uint8_t flags);
+
+/**
+* @brief return the device state last reported by the stick without asking the stick
+*
+* the worker tracks the state reported in device state responses, device state changed
+* notifications and aps data indications, reading it is lock free
+*
+* @param dev   - the device, make sure it is already connected
+* @param state - pointer to the state to save the state in
+*
+* @return   0 - everything worked fine
+* @return  -1 - the stick did not report its state yet
+*/
+int32_t conbee_device_state_snapshot(struct conbee_device *dev, struct conbee_device_state *state);
+
+/**
+* @brief check if the transport to the stick still works
+*
+* the worker clears the flag as soon as reading from the transport fails, e.g. because
+* the stick has been unplugged. Requests enqueued afterwards are never answered.
+*
+* @param dev - the device
+*
+* @return 1 - the device is connected and its transport works
+* @return 0 - the device is not connected or its transport failed
+*/
+uint8_t conbee_link_up(struct conbee_device *dev);
+
+/**
+* @brief set a function called whenever the device state reported by the stick changes
+*
+* the callback is called from the worker thread, so it must not block and must not wait
+* for frames of the same device. It may replace or remove itself. When this function returns
+* the old callback is not running anymore, unless it is called from the callback itself.
+*
+* @param dev      - the device, make sure it is already connected
+* @param cb       - the function to call or NULL to remove the callback
+* @param userdata - pointer handed to the callback
+*/
+void conbee_set_device_state_callback(struct conbee_device *dev,
+                                      void (*cb)(struct conbee_device *dev, struct conbee_device_state *state, void *userdata),
+                                      void *userdata);
+
+/**
+* @brief enable or disable the parameter cache of a device
+*
+* with the cache enabled the conbee_get_* parameter functions only ask the stick if the
+* value is not cached yet. The cache is invalidated by every conbee_set_* function and
+* whenever the stick reports a configuration change in its device state. The cache is
+* disabled after connecting, disabling it drops all cached values.
+*
+* @param dev    - the device, make sure it is already connected
+* @param enable - 1 to enable the cache, 0 to disable it
+*/
+void conbee_enable_parameter_cache(struct conbee_device *dev, uint8_t enable);
+
+/**
+* @brief drop all values of the parameter cache of a device
+*
+* @param dev - the device, make sure it is already connected
+*/
+void conbee_invalidate_parameter_cache(struct conbee_device *dev);
+
+/**
+* @brief let the worker keep the watchdog of the stick alive
+*
+* the worker writes the time to live to PARAM_WATCHDOG_TTL right away and again every
+* time the given percentage of the time to live has passed. The refreshes are sent from
+* the worker itself, no additional thread or blocking round trip is required.
+*
+* the callback is called from the worker thread with the status returned by the stick,
+* STATUS_TIMEOUT if the stick did not answer until the next refresh or STATUS_ERROR
+* if the refresh could not be sent. It must not block and must not wait for frames.
+*
+* @param dev      - the device, make sure it is already connected
+* @param ttl      - the time to live in seconds, 0 stops refreshing
+* @param percent  - refresh after this percentage of the time to live, 1 to 100
+* @param cb       - the function to call for failed refreshes, may be NULL
+* @param userdata - pointer handed to the callback
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+* @return  -2 - conbee device is not connected
+*/
+int32_t conbee_enable_watchdog(struct conbee_device *dev, uint32_t ttl, uint8_t percent,
+                               void (*cb)(struct conbee_device *dev, uint8_t status, void *userdata), void *userdata);
+
+/**
+* @brief return the statistics of the watchdog refresher
+*
+* @param dev   - the device, make sure it is already connected
+* @param stats - the statistics
+*/
+void conbee_get_watchdog_stats(struct conbee_device *dev, struct conbee_watchdog_stats *stats);
+
+/**
+* @brief let the worker reopen the transport once it fails, e.g. after the stick was unplugged
+*
+* the worker closes the failed transport and tries to open the address given to conbee_connect
+* again every interval_ms, a tty gets its attributes set up again. Use a stable path like
+* /dev/serial/by-id/... for a tty, the stick may come back with another number. Frames enqueued
+* while the link is down stay in the send queue and are written once it is up again.
+*
+* requests written but not answered before the link went down are written again with
+* RECONNECT_RETRY or answered with a frame of status STATUS_ERROR with RECONNECT_FAIL, so
+* their waiters do not hang. Requests older than RECONNECT_MAX_AGE_MS are answered with
+* STATUS_ERROR with both policies.
+* Reconnects are not supported by the loopback and replay transports.
+*
+* @param dev         - the device, make sure it is already connected
+* @param interval_ms - time between two attempts to reopen the transport in milliseconds
+* @param policy      - RECONNECT_RETRY, RECONNECT_FAIL or RECONNECT_DISABLED to stop reconnecting
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+* @return  -2 - conbee device is not connected
+*/
+int32_t conbee_enable_reconnect(struct conbee_device *dev, uint32_t interval_ms, uint8_t policy);
+
+/**
+* @brief return a consistent snapshot of the statistics of a device
+*
+* taking the snapshot never blocks the worker, it can be polled at any rate
+*
+* @param dev   - the device, make sure it is already connected
+* @param stats - the statistics
+*/
+void conbee_get_stats(struct conbee_device *dev, struct conbee_stats *stats);
+
+/**
+* @brief enable or disable recording the lifecycle timestamps of frames
+*
+* the timestamps are stored in the timestamps member of the frames returned by
+* conbee_wait_for_frame and conbee_wait_for_frames. While disabled recording costs
+* nothing but a check of the flag.
+*
+* @param dev    - the device, make sure it is already connected
+* @param enable - 1 to enable, 0 to disable
+*/
+void conbee_enable_frame_timestamps(struct conbee_device *dev, uint8_t enable);
+
+/**
+* @brief set a function called whenever a waiter picks up a received frame
+*
+* the callback is only called while timestamps are enabled. It is called from the thread
+* waiting for the frame, e.g. within conbee_get_* functions, so it must not block.
+*
+* @param dev      - the device, make sure it is already connected
+* @param cb       - the function to call or NULL to remove the callback
+* @param userdata - pointer handed to the callback
+*/
+void conbee_set_frame_trace_callback(struct conbee_device *dev,
+                                     void (*cb)(struct conbee_device *dev, struct conbee_frame *frame, void *userdata),
+                                     void *userdata);
+
+/**
+* @brief start recording the raw bytes written to and read from the stick
+*
+* the worker records every chunk with a timestamp into a ring of the given size, the
+* oldest records are overwritten. With a path the ring is a shared mapping of that file,
+* so it survives a crash of the process. Decode a trace with conbee-tracedump.
+* The trace is recorded until the device is closed.
+*
+* @param dev  - the device, make sure it is already connected
+* @param size - the number of bytes of the ring, at least CONBEE_TRACE_MIN_SIZE and a multiple of CONBEE_TRACE_ALIGN
+* @param path - the file to map the ring to, NULL to keep it in memory only
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+*/
+int32_t conbee_enable_wire_trace(struct conbee_device *dev, uint32_t size, const char *path);
+
+/**
+* @brief write a consistent copy of the wire trace of a device to a file
+*
+* the worker is not stopped while copying, records overwritten during the copy are
+* left out. Decode the file with conbee-tracedump.
+*
+* @param dev  - the device with an enabled wire trace
+* @param path - the file to write
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+*/
+int32_t conbee_dump_wire_trace(struct conbee_device *dev, const char *path);
+
+/**
+* @brief start recording the raw bytes written to and read from the stick into a capture file
+*
+* unlike the wire trace a capture is not limited in size, it is meant for recording traffic
+* to replay it later with the replay transport. Records are buffered, the file is complete
+* after conbee_disable_capture or conbee_close.
+*
+* @param dev  - the device, make sure it is already connected
+* @param path - the capture file to write
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+*/
+int32_t conbee_enable_capture(struct conbee_device *dev, const char *path);
+
+/**
+* @brief stop recording and close the capture file
+*
+* @param dev - the device
+*
+* @return   0 - everything went fine, the capture is complete
+* @return  -1 - writing the capture failed, use errno to find out what
+*/
+int32_t conbee_disable_capture(struct conbee_device *dev);
+
+/**
+* @brief initialize an empty pool
+*
+* @param pool - the pool
+*/
+void conbee_pool_init(struct conbee_pool *pool);
+
+/**
+* @brief free a pool, the devices are neither closed nor freed
+*
+* @param pool - the pool
+*/
+void conbee_pool_free(struct conbee_pool *pool);
+
+/**
+* @brief add a device to a pool
+*
+* @param pool - the pool
+* @param dev  - the device, make sure it is already connected and stays valid while it is part of the pool
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+*/
+int32_t conbee_pool_add(struct conbee_pool *pool, struct conbee_device *dev);
+
+/**
+* @brief remove a device from a pool, its destinations move to the other devices
+*
+* @param pool - the pool
+* @param dev  - the device
+*
+* @return   0 - device removed
+* @return  -1 - the device is no member of the pool
+*/
+int32_t conbee_pool_remove(struct conbee_pool *pool, struct conbee_device *dev);
+
+/**
+* @brief return the device of the pool the requests to a destination are sent with
+*
+* @param pool - the pool
+* @param dst  - the destination
+*
+* @return the device, NULL if no device of the pool is up
+*/
+struct conbee_device * conbee_pool_select(struct conbee_pool *pool, struct conbee_aps_address *dst);
+
+/**
+* @brief send an aps data request with the device responsible for its destination
+*
+* @param pool    - the pool
+* @param request - the request, its destination selects the device
+* @param dev     - receives the device the request has been sent with, wait for the response there
+*
+* @return >=0 - the sequence number of the request
+* @return  -1 - error occured, use errno to find out what
+*/
+int32_t conbee_pool_send(struct conbee_pool *pool, struct conbee_aps_request *request, struct conbee_device **dev);
+
+/**
+* @brief send the same aps data request to many destinations, spread over the devices of the pool
+*
+* the destinations of every device are sent with one conbee_aps_send_many call, so every
+* stick gets its requests as one burst. If sending fails with one of the devices, the bursts
+* of the devices before it are already enqueued. devices[i] is NULL for every destination
+* which has not been sent, wait for the responses of the others.
+*
+* @param pool             - the pool
+* @param request          - the request template
+* @param destinations     - array of n destinations, all with the same address mode
+* @param n                - the number of destinations
+* @param devices          - array receiving the device used for each destination, NULL if it has not been sent
+* @param sequence_numbers - array receiving the sequence number used for each destination
+*
+* @return   0 - everything went fine, all requests are enqueued
+* @return  -1 - error occured, use errno to find out what
+*/
+int32_t conbee_pool_send_many(struct conbee_pool *pool, struct conbee_aps_request *request, struct conbee_aps_address *destinations,
+                              uint16_t n, struct conbee_device **devices, uint8_t *sequence_numbers);
 
 /**
 * @brief return the firmware version of the conbee stick
@@ -886,4 +2121,94 @@ int32_t conbee_get_security_mode(struct conbee_device *dev, uint8_t *mode);
 */
 int32_t conbee_set_security_mode(struct conbee_device *dev, uint8_t mode);
 
+/**
+* @brief return the network key
+*
+* @param dev - the device from to request the network key
+* @param key - array containing the network key after calling
+*
+* @return -1 - an error occured
+* @return 0  - everything was fine
+*/
+int32_t conbee_get_network_key(struct conbee_device *dev, uint8_t key[16]);
+
+/**
+* @brief set the network key
+*
+* @param dev - the device for which to set the network key
+* @param key - the key to set
+*
+* @return -1 - an error occured
+* @return 0  - everything was fine
+*/
+int32_t conbee_set_network_key(struct conbee_device *dev, uint8_t key[16]);
+
+/**
+* @brief return the channel the stick is currently operating on
+*
+* @param dev     - the device from to request the current channel
+* @param channel - pointer to the returned channel
+*
+* @return -1 - an error occured
+* @return 0  - everything was fine
+*/
+int32_t conbee_get_current_channel(struct conbee_device *dev, uint8_t *channel);
+
+/**
+* @brief return the protocol version implemented by the firmware of the stick
+*
+* @param dev     - the device from to request the protocol version
+* @param version - pointer to the returned protocol version
+*
+* @return -1 - an error occured
+* @return 0  - everything was fine
+*/
+int32_t conbee_get_protocol_version(struct conbee_device *dev, uint16_t *version);
+
+/**
+* @brief return the network update id
+*
+* @param dev - the device from to request the network update id
+* @param id  - pointer to the returned network update id
+*
+* @return -1 - an error occured
+* @return 0  - everything was fine
+*/
+int32_t conbee_get_nwk_update_id(struct conbee_device *dev, uint8_t *id);
+
+/**
+* @brief set the network update id
+*
+* @param dev - the device for which to set the network update id
+* @param id  - the network update id to set
+*
+* @return -1 - an error occured
+* @return 0  - everything was fine
+*/
+int32_t conbee_set_nwk_update_id(struct conbee_device *dev, uint8_t id);
+
+/**
+* @brief return the watchdog time to live
+*
+* @param dev - the device from to request the watchdog time to live
+* @param ttl - pointer to the returned time to live in seconds
+*
+* @return -1 - an error occured
+* @return 0  - everything was fine
+*/
+int32_t conbee_get_watchdog_ttl(struct conbee_device *dev, uint32_t *ttl);
+
+/**
+* @brief set the watchdog time to live
+*
+* the stick resets itself if the time to live is not refreshed before it expires
+*
+* @param dev - the device for which to set the watchdog time to live
+* @param ttl - the time to live in seconds
+*
+* @return -1 - an error occured
+* @return 0  - everything was fine
+*/
+int32_t conbee_set_watchdog_ttl(struct conbee_device *dev, uint32_t ttl);
+
 #endif
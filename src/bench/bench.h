@@ -0,0 +1,145 @@
+#ifndef __CONNBEE_BENCH_H__
+#define __CONNBEE_BENCH_H__
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file */
+#include <stdint.h>
+#include <stdio.h>
+#include <emulator/emulator.h>
+
+/// maximum number of results of one benchmark run
+#define BENCH_MAX_RESULTS             64
+
+/// version of the machine readable output, increase on incompatible changes
+#define BENCH_FORMAT_VERSION          1
+
+/**
+* @brief the result of one benchmark
+*
+* micro benchmarks fill in the time per operation, latency benchmarks the percentiles
+* and throughput benchmarks the operations per second, unused fields stay zero
+*/
+struct bench_result
+{
+  /// name of the benchmark, e.g. "crc16/64"
+  char name[64];
+
+  /// number of measured operations
+  uint64_t iterations;
+
+  /// mean time of one operation in nanoseconds
+  double ns_per_op;
+
+  /// processed payload in megabytes per second
+  double mb_per_s;
+
+  /// operations per second
+  double ops_per_s;
+
+  /// median latency in microseconds
+  double p50_us;
+
+  /// 90th percentile of the latency in microseconds
+  double p90_us;
+
+  /// 99th percentile of the latency in microseconds
+  double p99_us;
+
+  /// maximum latency in microseconds
+  double max_us;
+
+  /// number of requests answered with an error status
+  uint64_t errors;
+
+  /// number of requests answered with STATUS_BUSY
+  uint64_t busy;
+};
+
+/**
+* @brief all results of one benchmark run
+*/
+struct bench_report
+{
+  /// the results in the order they were measured
+  struct bench_result results[BENCH_MAX_RESULTS];
+
+  /// number of results
+  uint32_t nr_results;
+};
+
+/**
+* @brief return the monotonic time in nanoseconds
+*/
+uint64_t bench_now_ns();
+
+/**
+* @brief append a result to the report
+*
+* @param report - the report
+*
+* @return pointer to the zeroed result, NULL if the report is full
+*/
+struct bench_result * bench_add_result(struct bench_report *report, const char *name);
+
+/**
+* @brief fill in the latency percentiles of a result
+*
+* @param result  - the result
+* @param samples - the latencies in nanoseconds, sorted by the function
+* @param n       - the number of samples
+*/
+void bench_set_latencies(struct bench_result *result, uint64_t *samples, uint32_t n);
+
+/**
+* @brief run the micro benchmarks of the codec, the queue and the frame allocation
+*
+* @param report     - the report receiving the results
+* @param iterations - the number of operations per benchmark
+*/
+void bench_micro(struct bench_report *report, uint64_t iterations);
+
+/**
+* @brief run the round trip and throughput benchmarks against one device
+*
+* @param report  - the report receiving the results
+* @param label   - label of the device within the result names
+* @param dev     - the device, make sure it is already connected
+* @param samples - the number of round trips and aps requests to measure
+*
+* @return   0 - everything went fine
+* @return  -1 - a request failed
+*/
+int32_t bench_macro(struct bench_report *report, const char *label, struct conbee_device *dev, uint32_t samples);
+
+/**
+* @brief print the report as json
+*
+* @param report - the report
+* @param out    - the stream to print to
+*/
+void bench_print_json(struct bench_report *report, FILE *out);
+
+/**
+* @brief print the report as human readable table
+*
+* @param report - the report
+* @param out    - the stream to print to
+*/
+void bench_print_text(struct bench_report *report, FILE *out);
+
+#endif
@@ -0,0 +1,184 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <bench/bench.h>
+#include <conbee.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// number of aps data requests in flight during the throughput benchmark
+#define MACRO_APS_WINDOW              32
+
+/// number of parameters read with one pipelined batch
+#define MACRO_BATCH_SIZE              8
+
+/**
+* @brief measure the round trip of firmware version requests
+*/
+static int32_t macro_rtt_version(struct bench_report *report, const char *label, struct conbee_device *dev, uint32_t samples)
+{
+  uint64_t *latencies = malloc(samples * sizeof(uint64_t));
+  struct conbee_version version;
+  char name[64];
+
+  if (latencies == NULL)
+  {
+    return -1;
+  }
+
+  for(uint32_t i = 0; i < samples; i++)
+  {
+    uint64_t start = bench_now_ns();
+
+    if (conbee_get_firmware_version(dev, &version) < 0)
+    {
+      free(latencies);
+      return -1;
+    }
+
+    latencies[i] = bench_now_ns() - start;
+  }
+
+  snprintf(name, sizeof(name), "rtt/version/%s", label);
+  bench_set_latencies(bench_add_result(report, name), latencies, samples);
+  free(latencies);
+
+  return 0;
+}
+
+/**
+* @brief measure the round trip of pipelined batches of parameter reads
+*/
+static int32_t macro_rtt_batch(struct bench_report *report, const char *label, struct conbee_device *dev, uint32_t samples)
+{
+  uint8_t ids[MACRO_BATCH_SIZE] = { PARAM_MAC_ADDRESS, PARAM_NWK_PANID, PARAM_NWK_ADDRESS, PARAM_NWK_EXT_PANID,
+                                    PARAM_APS_COORDINATOR, PARAM_CHANNEL_MASK, PARAM_APS_EXT_PANID, PARAM_SECURITY_MODE };
+  struct conbee_parameter results[MACRO_BATCH_SIZE];
+  uint64_t *latencies = malloc(samples * sizeof(uint64_t));
+  char name[64];
+
+  if (latencies == NULL)
+  {
+    return -1;
+  }
+
+  for(uint32_t i = 0; i < samples; i++)
+  {
+    uint64_t start = bench_now_ns();
+
+    if (conbee_read_parameters(dev, ids, MACRO_BATCH_SIZE, results) < 0)
+    {
+      free(latencies);
+      return -1;
+    }
+
+    latencies[i] = bench_now_ns() - start;
+  }
+
+  snprintf(name, sizeof(name), "rtt/read_parameters_%u/%s", MACRO_BATCH_SIZE, label);
+  bench_set_latencies(bench_add_result(report, name), latencies, samples);
+  free(latencies);
+
+  return 0;
+}
+
+/**
+* @brief measure the aps data request throughput with MACRO_APS_WINDOW requests in flight
+*/
+static int32_t macro_aps_throughput(struct bench_report *report, const char *label, struct conbee_device *dev, uint32_t samples)
+{
+  struct conbee_aps_address destinations[MACRO_APS_WINDOW];
+  struct conbee_frame *frames[MACRO_APS_WINDOW];
+  uint8_t sequence_numbers[MACRO_APS_WINDOW];
+  struct conbee_aps_request request;
+  uint8_t asdu[32];
+  uint64_t sent = 0;
+  char name[64];
+
+  memset(&request, 0, sizeof(request));
+  memset(asdu, 0x55, sizeof(asdu));
+  request.profile_id    = 0x0104;
+  request.cluster_id    = 0x0006;
+  request.src_endpoint  = 1;
+  request.asdu_length   = sizeof(asdu);
+  request.asdu          = asdu;
+  request.radius        = ROUTE_HOP_COUNT_UNLIMITED;
+
+  for(uint32_t i = 0; i < MACRO_APS_WINDOW; i++)
+  {
+    destinations[i].addr_mode = DEST_ADDR_NWK;
+    destinations[i].addr      = 0x1000 + i;
+    destinations[i].endpoint  = 1;
+  }
+
+  uint64_t start = bench_now_ns();
+  while(sent < samples)
+  {
+    if (conbee_aps_send_many(dev, &request, destinations, MACRO_APS_WINDOW, sequence_numbers) < 0 ||
+        conbee_wait_for_frames(dev, frames, sequence_numbers, MACRO_APS_WINDOW, COMMAND_APS_DATA_REQUEST) < 0)
+    {
+      return -1;
+    }
+
+    for(uint32_t i = 0; i < MACRO_APS_WINDOW; i++)
+    {
+      conbee_free_frame(frames[i]);
+    }
+
+    sent += MACRO_APS_WINDOW;
+  }
+  uint64_t ns = bench_now_ns() - start;
+
+  snprintf(name, sizeof(name), "aps/throughput/%s", label);
+  struct bench_result *result = bench_add_result(report, name);
+  if (result != NULL)
+  {
+    result->iterations = sent;
+    result->ns_per_op  = (double) ns / sent;
+    result->ops_per_s  = sent * 1e9 / ns;
+    result->mb_per_s   = (double) sent * sizeof(asdu) * 1e3 / ns;
+  }
+
+  return 0;
+}
+
+/**
+* @brief run the round trip and throughput benchmarks against one device
+*
+* @param report  - the report receiving the results
+* @param label   - label of the device within the result names
+* @param dev     - the device, make sure it is already connected
+* @param samples - the number of round trips and aps requests to measure
+*
+* @return   0 - everything went fine
+* @return  -1 - a request failed
+*/
+int32_t bench_macro(struct bench_report *report, const char *label, struct conbee_device *dev, uint32_t samples)
+{
+  // every request has to reach the stick
+  conbee_enable_parameter_cache(dev, 0);
+
+  if (macro_rtt_version(report, label, dev, samples) < 0 ||
+      macro_rtt_batch(report, label, dev, samples) < 0 ||
+      macro_aps_throughput(report, label, dev, samples) < 0)
+  {
+    return -1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,185 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <argparse.h>
+#include <bench/bench.h>
+#include <conbee.h>
+#include <conbee-transport.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+* @brief run the macro benchmarks against an emulator
+*
+* @param report  - the report receiving the results
+* @param address - "loopback://" to run the emulator in process, otherwise a pty is used
+* @param config  - the configuration of the emulator
+* @param samples - the number of samples per benchmark
+*
+* @return   0 - everything went fine
+* @return  -1 - the benchmark failed
+*/
+static int32_t bench_emulated(struct bench_report *report, char *address, struct conbee_emulator_config *config, uint32_t samples)
+{
+  struct conbee_emulator emulator;
+  struct conbee_device dev;
+  char pty_name[200];
+  int32_t err;
+
+  if (strcmp(address, "loopback://") == 0)
+  {
+    if (conbee_connect(&dev, address) < 0)
+    {
+      return -1;
+    }
+
+    err = conbee_emulator_start(&emulator, conbee_loopback_peer(&dev), config);
+  }
+  else
+  {
+    int32_t fd = conbee_emulator_open_pty(pty_name, sizeof(pty_name));
+    if (fd < 0)
+    {
+      return -1;
+    }
+
+    err = conbee_emulator_start(&emulator, fd, config);
+    if (err == 0 && conbee_connect(&dev, pty_name) < 0)
+    {
+      conbee_emulator_stop(&emulator);
+      return -1;
+    }
+  }
+
+  if (err < 0)
+  {
+    fprintf(stderr,"error: starting emulator failed\n");
+    return -1;
+  }
+
+  err = bench_macro(report, strcmp(address, "loopback://") == 0 ? "loopback" : "pty", &dev, samples);
+
+  conbee_close(&dev);
+  conbee_emulator_stop(&emulator);
+
+  return err;
+}
+
+int main(int argc, char **argv)
+{
+  struct arg_parse_ctx *argparse_ctx = argparse_init();
+  struct conbee_emulator_config config;
+  struct bench_report report;
+  char device_name[200] = "";
+  char format[10]       = "json";
+  char mode[10]         = "all";
+  int iterations        = 1000000;
+  int samples           = 2000;
+  int latency           = 0;
+  int jitter            = 0;
+  int err               = 0;
+
+  // argument for a real stick instead of the emulator
+  struct arg_str device_arg = {
+      {ARG_STR,0,0},
+      'd',
+      "device",
+      device_name,
+      199,
+      "run the macro benchmarks against this device instead of the emulator"
+  };
+  argparse_add_string(argparse_ctx, &device_arg);
+
+  struct arg_str format_arg = {{ARG_STR,0,0}, 'f', "format", format, 9, "output format, json or text (default: json)"};
+  struct arg_str mode_arg   = {{ARG_STR,0,0}, 'm', "mode", mode, 9, "benchmarks to run, all, micro or macro (default: all)"};
+  argparse_add_string(argparse_ctx, &format_arg);
+  argparse_add_string(argparse_ctx, &mode_arg);
+
+  struct arg_int iterations_arg = {{ARG_INT,0,0}, 'n', "iterations", "operations per micro benchmark (default: 1000000)", &iterations};
+  struct arg_int samples_arg    = {{ARG_INT,0,0}, 's', "samples",    "samples per macro benchmark (default: 2000)", &samples};
+  struct arg_int latency_arg    = {{ARG_INT,0,0}, 'L', "latency",    "response latency of the emulator in microseconds", &latency};
+  struct arg_int jitter_arg     = {{ARG_INT,0,0}, 'J', "jitter",     "response jitter of the emulator in microseconds", &jitter};
+  argparse_add_int(argparse_ctx, &iterations_arg);
+  argparse_add_int(argparse_ctx, &samples_arg);
+  argparse_add_int(argparse_ctx, &latency_arg);
+  argparse_add_int(argparse_ctx, &jitter_arg);
+
+  /// parse the commandline
+  argparse_parse(argparse_ctx, argc, argv);
+
+  memset(&report, 0, sizeof(report));
+  memset(&config, 0, sizeof(config));
+  config.latency_us = latency;
+  config.jitter_us  = jitter;
+
+  if (iterations < 8 || samples < 1)
+  {
+    fprintf(stderr,"error: at least 8 iterations and 1 sample are required\n");
+    argparse_free(argparse_ctx);
+    return -1;
+  }
+
+  if (strcmp(mode, "macro") != 0)
+  {
+    bench_micro(&report, iterations);
+  }
+
+  if (strcmp(mode, "micro") != 0)
+  {
+    if (device_name[0] != 0)
+    {
+      struct conbee_device dev;
+
+      if (conbee_connect(&dev, device_name) < 0)
+      {
+        argparse_free(argparse_ctx);
+        return -1;
+      }
+
+      err = bench_macro(&report, "device", &dev, samples);
+      conbee_close(&dev);
+    }
+    else
+    {
+      err = bench_emulated(&report, "pty", &config, samples);
+      if (err == 0)
+      {
+        err = bench_emulated(&report, "loopback://", &config, samples);
+      }
+    }
+
+    if (err < 0)
+    {
+      fprintf(stderr,"error: macro benchmark failed\n");
+    }
+  }
+
+  if (strcmp(format, "text") == 0)
+  {
+    bench_print_text(&report, stdout);
+  }
+  else
+  {
+    bench_print_json(&report, stdout);
+  }
+
+  /// free context
+  argparse_free(argparse_ctx);
+
+  return err < 0 ? -1 : 0;
+}
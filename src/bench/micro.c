@@ -0,0 +1,312 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <bench/bench.h>
+#include <conbee.h>
+#include <conbee-internal.h>
+#include <conbee-queue.h>
+#include <slip.h>
+#include <crc16.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// size of the in memory line used by the slip benchmarks
+#define MICRO_LINE_SIZE               4096
+
+/// the in memory line slip_transmit_packet writes to and slip_receive_packet reads from
+static uint8_t micro_line[MICRO_LINE_SIZE];
+
+/// number of bytes in the in memory line
+static uint32_t micro_line_length;
+
+/// read position within the in memory line
+static uint32_t micro_line_position;
+
+/// sink keeping the compiler from optimizing benchmarked code away
+static volatile uint64_t micro_sink;
+
+/// the item pushed through the queue
+static uint8_t micro_item;
+
+/**
+* @brief write_byte hook of the benchmark device, appends to the in memory line
+*/
+static int32_t micro_write_byte(struct conbee_device *dev, uint8_t c)
+{
+  (void) dev;
+
+  micro_line[micro_line_length++ % MICRO_LINE_SIZE] = c;
+  return 0;
+}
+
+/**
+* @brief read_byte hook of the benchmark device, replays the in memory line
+*/
+static int32_t micro_read_byte(struct conbee_device *dev, uint8_t *c)
+{
+  (void) dev;
+
+  *c = micro_line[micro_line_position++];
+  if (micro_line_position == micro_line_length)
+  {
+    micro_line_position = 0;
+  }
+  return 0;
+}
+
+/**
+* @brief fill a buffer with bytes of a typical frame, including some bytes to escape
+*/
+static void micro_fill(uint8_t *buffer, uint32_t length)
+{
+  for(uint32_t i = 0; i < length; i++)
+  {
+    buffer[i] = (i * 37) & 0xFF;
+  }
+}
+
+/**
+* @brief store the time per operation and the throughput of a micro benchmark
+*/
+static void micro_result(struct bench_report *report, const char *name, uint64_t iterations, uint64_t ns, uint32_t bytes)
+{
+  struct bench_result *result = bench_add_result(report, name);
+
+  if (result == NULL)
+  {
+    return;
+  }
+
+  result->iterations = iterations;
+  result->ns_per_op  = (double) ns / iterations;
+  result->ops_per_s  = iterations * 1e9 / ns;
+  if (bytes > 0)
+  {
+    result->mb_per_s = (double) bytes * iterations * 1e3 / ns;
+  }
+}
+
+/**
+* @brief benchmark the byte wise slip functions used by the original read and write path
+*/
+static void micro_slip_packet(struct bench_report *report, uint64_t iterations, uint32_t length)
+{
+  struct conbee_device dev;
+  uint8_t buffer[1000];
+  uint64_t start;
+  char name[64];
+
+  memset(&dev, 0, sizeof(dev));
+  dev.write_byte = &micro_write_byte;
+  dev.read_byte  = &micro_read_byte;
+  micro_fill(buffer, length);
+
+  start = bench_now_ns();
+  for(uint64_t i = 0; i < iterations; i++)
+  {
+    micro_line_length = 0;
+    slip_transmit_packet(&dev, buffer, length);
+  }
+  snprintf(name, sizeof(name), "slip_transmit_packet/%u", length);
+  micro_result(report, name, iterations, bench_now_ns() - start, length);
+
+  // the line now holds exactly one encoded packet, which is replayed over and over
+  micro_line_position = 0;
+  start = bench_now_ns();
+  for(uint64_t i = 0; i < iterations; i++)
+  {
+    micro_sink += slip_receive_packet(&dev, buffer, sizeof(buffer));
+  }
+  snprintf(name, sizeof(name), "slip_receive_packet/%u", length);
+  micro_result(report, name, iterations, bench_now_ns() - start, length);
+}
+
+/**
+* @brief benchmark the buffer based slip encoder and the incremental decoder
+*/
+static void micro_slip_buffer(struct bench_report *report, uint64_t iterations, uint32_t length)
+{
+  struct slip_decoder decoder;
+  uint8_t buffer[1000];
+  uint8_t packet[1000];
+  uint8_t encoded[2002];
+  uint32_t encoded_length = 0;
+  uint64_t start;
+  char name[64];
+
+  micro_fill(buffer, length);
+
+  start = bench_now_ns();
+  for(uint64_t i = 0; i < iterations; i++)
+  {
+    encoded[0] = END;
+    encoded_length = 1 + slip_encode(buffer, length, &encoded[1]);
+    encoded[encoded_length++] = END;
+    micro_sink += encoded_length;
+  }
+  snprintf(name, sizeof(name), "slip_encode/%u", length);
+  micro_result(report, name, iterations, bench_now_ns() - start, length);
+
+  slip_decoder_init(&decoder, packet, sizeof(packet));
+  start = bench_now_ns();
+  for(uint64_t i = 0; i < iterations; i++)
+  {
+    uint32_t offset = 0;
+
+    while(offset < encoded_length)
+    {
+      uint32_t packet_length = 0;
+
+      offset += slip_decode(&decoder, &encoded[offset], encoded_length - offset, &packet_length);
+      micro_sink += packet_length;
+    }
+  }
+  snprintf(name, sizeof(name), "slip_decode/%u", length);
+  micro_result(report, name, iterations, bench_now_ns() - start, length);
+}
+
+/**
+* @brief benchmark the frame checksum
+*/
+static void micro_crc16(struct bench_report *report, uint64_t iterations, uint32_t length)
+{
+  uint8_t buffer[1000];
+  uint64_t start;
+  char name[64];
+
+  micro_fill(buffer, length);
+
+  start = bench_now_ns();
+  for(uint64_t i = 0; i < iterations; i++)
+  {
+    buffer[0] = i;
+    micro_sink += crc16(buffer, length);
+  }
+  snprintf(name, sizeof(name), "crc16/%u", length);
+  micro_result(report, name, iterations, bench_now_ns() - start, length);
+}
+
+/**
+* @brief benchmark the send and receive queue operations
+*/
+static void micro_queue(struct bench_report *report, uint64_t iterations)
+{
+  struct conbee_queue_root queue;
+  uint64_t start;
+
+  conbee_queue_init(&queue);
+
+  start = bench_now_ns();
+  for(uint64_t i = 0; i < iterations; i++)
+  {
+    conbee_queue_push(&queue, &micro_item);
+    micro_sink += (uintptr_t) conbee_queue_pop(&queue) & 1;
+  }
+  micro_result(report, "queue/push_pop", iterations, bench_now_ns() - start, 0);
+
+  // a full queue as seen during pipelined requests
+  uint64_t rounds = iterations / 256 > 0 ? iterations / 256 : 1;
+  start = bench_now_ns();
+  for(uint64_t i = 0; i < rounds; i++)
+  {
+    for(uint32_t j = 0; j < 256; j++)
+    {
+      conbee_queue_push(&queue, &micro_item);
+    }
+    while(conbee_queue_pop(&queue) != NULL);
+  }
+  micro_result(report, "queue/fill_drain_256", rounds * 256, bench_now_ns() - start, 0);
+}
+
+/**
+* @brief benchmark allocating, encoding and decoding frames
+*/
+static void micro_frame(struct bench_report *report, uint64_t iterations)
+{
+  struct conbee_device dev;
+  uint8_t encoded[CONBEE_FRAME_MAX_ENCODED];
+  uint8_t packet[CONBEE_FRAME_MAX_ENCODED];
+  uint64_t start;
+
+  memset(&dev, 0, sizeof(dev));
+
+  start = bench_now_ns();
+  for(uint64_t i = 0; i < iterations; i++)
+  {
+    struct conbee_frame *frame = conbee_read_parameter_request(PARAM_NWK_PANID);
+    micro_sink += frame->length;
+    conbee_free_frame(frame);
+  }
+  micro_result(report, "frame/alloc_free", iterations, bench_now_ns() - start, 0);
+
+  struct conbee_frame *request = conbee_read_parameter_request(PARAM_NWK_PANID);
+  uint32_t encoded_length = 0;
+
+  start = bench_now_ns();
+  for(uint64_t i = 0; i < iterations; i++)
+  {
+    request->sequence_number = i;
+    encoded_length = conbee_encode_frame(request, encoded);
+    micro_sink += encoded_length;
+  }
+  micro_result(report, "frame/encode", iterations, bench_now_ns() - start, 0);
+  conbee_free_frame(request);
+
+  // decode the request as if it had been received, without the framing END bytes
+  struct slip_decoder decoder;
+  uint32_t packet_length = 0;
+  uint32_t offset = 0;
+
+  slip_decoder_init(&decoder, packet, sizeof(packet));
+  while(packet_length == 0 && offset < encoded_length)
+  {
+    offset += slip_decode(&decoder, &encoded[offset], encoded_length - offset, &packet_length);
+  }
+
+  start = bench_now_ns();
+  for(uint64_t i = 0; i < iterations; i++)
+  {
+    struct conbee_frame frame;
+
+    frame.payload = NULL;
+    if (conbee_decode_frame(&dev, packet, packet_length, &frame) == 0)
+    {
+      micro_sink += frame.length;
+      free(frame.payload);
+    }
+  }
+  micro_result(report, "frame/decode", iterations, bench_now_ns() - start, 0);
+}
+
+/**
+* @brief run the micro benchmarks of the codec, the queue and the frame allocation
+*
+* @param report     - the report receiving the results
+* @param iterations - the number of operations per benchmark
+*/
+void bench_micro(struct bench_report *report, uint64_t iterations)
+{
+  micro_slip_packet(report, iterations, 64);
+  micro_slip_packet(report, iterations / 8, 1000);
+  micro_slip_buffer(report, iterations, 64);
+  micro_slip_buffer(report, iterations / 8, 1000);
+  micro_crc16(report, iterations, 64);
+  micro_crc16(report, iterations / 8, 1000);
+  micro_queue(report, iterations);
+  micro_frame(report, iterations);
+}
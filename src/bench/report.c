@@ -0,0 +1,155 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <bench/bench.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+* @brief return the monotonic time in nanoseconds
+*/
+uint64_t bench_now_ns()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return ((uint64_t) now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+/**
+* @brief append a result to the report
+*
+* @param report - the report
+*
+* @return pointer to the zeroed result, NULL if the report is full
+*/
+struct bench_result * bench_add_result(struct bench_report *report, const char *name)
+{
+  if (report->nr_results == BENCH_MAX_RESULTS)
+  {
+    return NULL;
+  }
+
+  struct bench_result *result = &report->results[report->nr_results++];
+
+  memset(result, 0, sizeof(struct bench_result));
+  strncpy(result->name, name, sizeof(result->name) - 1);
+
+  return result;
+}
+
+/**
+* @brief compare two latencies for qsort
+*/
+static int bench_compare(const void *a, const void *b)
+{
+  uint64_t x = *(const uint64_t *) a;
+  uint64_t y = *(const uint64_t *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+/**
+* @brief fill in the latency percentiles of a result
+*
+* @param result  - the result
+* @param samples - the latencies in nanoseconds, sorted by the function
+* @param n       - the number of samples
+*/
+void bench_set_latencies(struct bench_result *result, uint64_t *samples, uint32_t n)
+{
+  uint64_t total = 0;
+
+  if (result == NULL || n == 0)
+  {
+    return;
+  }
+
+  qsort(samples, n, sizeof(uint64_t), bench_compare);
+
+  for(uint32_t i = 0; i < n; i++)
+  {
+    total += samples[i];
+  }
+
+  result->iterations = n;
+  result->ns_per_op  = (double) total / n;
+  result->ops_per_s  = n * 1e9 / total;
+  result->p50_us     = samples[(n - 1) * 50 / 100] / 1e3;
+  result->p90_us     = samples[(n - 1) * 90 / 100] / 1e3;
+  result->p99_us     = samples[(n - 1) * 99 / 100] / 1e3;
+  result->max_us     = samples[n - 1] / 1e3;
+}
+
+/**
+* @brief print the report as json
+*
+* @param report - the report
+* @param out    - the stream to print to
+*/
+void bench_print_json(struct bench_report *report, FILE *out)
+{
+  fprintf(out, "{\n  \"format\": %u,\n  \"timestamp\": %ld,\n  \"results\": [\n", BENCH_FORMAT_VERSION, (long) time(NULL));
+
+  for(uint32_t i = 0; i < report->nr_results; i++)
+  {
+    struct bench_result *result = &report->results[i];
+
+    fprintf(out, "    { \"name\": \"%s\", \"iterations\": %lu, \"ns_per_op\": %.1f, \"ops_per_s\": %.1f",
+            result->name, result->iterations, result->ns_per_op, result->ops_per_s);
+
+    if (result->mb_per_s > 0)
+    {
+      fprintf(out, ", \"mb_per_s\": %.2f", result->mb_per_s);
+    }
+
+    if (result->max_us > 0)
+    {
+      fprintf(out, ", \"p50_us\": %.1f, \"p90_us\": %.1f, \"p99_us\": %.1f, \"max_us\": %.1f",
+              result->p50_us, result->p90_us, result->p99_us, result->max_us);
+      fprintf(out, ", \"errors\": %lu, \"busy\": %lu", (unsigned long) result->errors, (unsigned long) result->busy);
+    }
+
+    fprintf(out, " }%s\n", i + 1 < report->nr_results ? "," : "");
+  }
+
+  fprintf(out, "  ]\n}\n");
+}
+
+/**
+* @brief print the report as human readable table
+*
+* @param report - the report
+* @param out    - the stream to print to
+*/
+void bench_print_text(struct bench_report *report, FILE *out)
+{
+  fprintf(out, "%-36s %12s %12s %10s %10s %10s %10s %10s %8s %8s\n", "benchmark", "ns/op", "ops/s", "MB/s", "p50 us", "p90 us",
+          "p99 us", "max us", "errors", "busy");
+
+  for(uint32_t i = 0; i < report->nr_results; i++)
+  {
+    struct bench_result *result = &report->results[i];
+
+    fprintf(out, "%-36s %12.1f %12.0f %10.2f %10.1f %10.1f %10.1f %10.1f %8lu %8lu\n", result->name, result->ns_per_op,
+            result->ops_per_s, result->mb_per_s, result->p50_us, result->p90_us, result->p99_us, result->max_us,
+            (unsigned long) result->errors, (unsigned long) result->busy);
+  }
+}
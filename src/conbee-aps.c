@@ -0,0 +1,283 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <conbee.h>
+#include <conbee-internal.h>
+#include <slip.h>
+#include <crc16.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/// the maximum number of bytes of a serialized aps data request
+#define APS_REQUEST_MAX_LENGTH    1000
+
+/// offset of the request id within a serialized aps data request
+#define APS_REQUEST_ID_OFFSET     7
+
+/// offset of the destination address within a serialized aps data request
+#define APS_REQUEST_DST_OFFSET    10
+
+/**
+* @brief return the number of bytes of an address in the given mode
+*
+* @return >0 - the number of bytes
+* @return  0 - the address mode is not supported for aps data requests
+*/
+static uint8_t aps_address_width(uint8_t addr_mode)
+{
+  switch(addr_mode)
+  {
+    case DEST_ADDR_GROUP:
+    case DEST_ADDR_NWK:
+                          return 2;
+    case DEST_ADDR_IEEE:
+                          return 8;
+    default:
+                          return 0;
+  }
+}
+
+/**
+* @brief write the destination address and endpoint at the given position
+*
+* @return the number of bytes written
+*/
+static uint16_t aps_address_serialize(struct conbee_aps_address *dst, uint8_t *buffer)
+{
+  uint16_t index = 0;
+  uint64_t addr  = dst->addr_mode == DEST_ADDR_IEEE ? dst->ieee_addr : dst->addr;
+
+  for(uint8_t i = 0; i < aps_address_width(dst->addr_mode); i++)
+  {
+    buffer[index++] = (addr >> (8*i)) & 0xFF;
+  }
+
+  // group addressed requests do not have a destination endpoint
+  if (dst->addr_mode != DEST_ADDR_GROUP)
+  {
+    buffer[index++] = dst->endpoint;
+  }
+
+  return index;
+}
+
+/**
+* @brief serialize an aps data request including the frame header but without checksum
+*
+* @param request - the request to serialize
+* @param dst     - the destination to use instead of the one of the request
+* @param buffer  - buffer of APS_REQUEST_MAX_LENGTH bytes
+*
+* @return >0 - the number of bytes written
+* @return  0 - the request is invalid
+*/
+static uint16_t aps_request_serialize(struct conbee_aps_request *request, struct conbee_aps_address *dst, uint8_t *buffer)
+{
+  uint16_t index = 0;
+
+  if (aps_address_width(dst->addr_mode) == 0 || request->asdu_length + 30 > APS_REQUEST_MAX_LENGTH)
+  {
+    return 0;
+  }
+
+  buffer[index++] = COMMAND_APS_DATA_REQUEST;
+  buffer[index++] = 0;                        // sequence number
+  buffer[index++] = 0;                        // status
+  index += 4;                                 // frame and payload length, filled in below
+  buffer[index++] = request->request_id;
+  buffer[index++] = 0;                        // flags
+  buffer[index++] = dst->addr_mode;
+  index += aps_address_serialize(dst, &buffer[index]);
+  buffer[index++] = request->profile_id & 0xFF;
+  buffer[index++] = request->profile_id >> 8;
+  buffer[index++] = request->cluster_id & 0xFF;
+  buffer[index++] = request->cluster_id >> 8;
+  buffer[index++] = request->src_endpoint;
+  buffer[index++] = request->asdu_length & 0xFF;
+  buffer[index++] = request->asdu_length >> 8;
+  if (request->asdu_length > 0)
+  {
+    memcpy(&buffer[index], request->asdu, request->asdu_length);
+    index += request->asdu_length;
+  }
+  buffer[index++] = request->tx_options;
+  buffer[index++] = request->radius;
+
+  // frame length and payload length (bytes following the payload length field)
+  buffer[3] = index & 0xFF;
+  buffer[4] = index >> 8;
+  buffer[5] = (index - 7) & 0xFF;
+  buffer[6] = (index - 7) >> 8;
+
+  return index;
+}
+
+/**
+* @brief create a frame for an aps data request
+*
+* make sure to *free* the returned frame after using it! Otherwise you will get memory leaks
+*
+* @param request - the request to send
+*
+* @return pointer to the frame for the aps data request, NULL if the request is invalid
+*/
+struct conbee_frame * conbee_aps_data_request(struct conbee_aps_request *request)
+{
+  uint8_t buffer[APS_REQUEST_MAX_LENGTH];
+  uint16_t length = aps_request_serialize(request, &request->dst, buffer);
+
+  if (length == 0)
+  {
+    return NULL;
+  }
+
+  struct conbee_frame *frame = conbee_init_frame();
+
+  frame->command          = COMMAND_APS_DATA_REQUEST;
+  frame->sequence_number  = 0;
+  frame->status           = 0;
+  frame->length           = length;
+  frame->payload_length   = length - 7;
+  frame->payload          = malloc(frame->payload_length);
+  memcpy(frame->payload, &buffer[7], frame->payload_length);
+
+  return frame;
+}
+
+/**
+* @brief send the same aps data request to many destinations
+*
+* the request is serialized and slip encoded once, only the destination, sequence number,
+* request id and checksum are patched for each destination. All frames are handed to the
+* worker as one buffer and written to the tty back to back.
+*
+* All destinations have to use the same address mode, the destination of the request
+* itself is ignored. Make sure the stick has enough free request slots for n requests.
+*
+* @param dev              - the device to send the requests with, make sure it is already connected
+* @param request          - the request template
+* @param destinations     - array of n destinations
+* @param n                - the number of destinations, at most 255
+* @param sequence_numbers - array receiving the sequence number used for each destination, may be NULL
+*
+* @return   0 - everything went fine, all requests are enqueued
+* @return  -1 - error occured, use errno to find out what
+* @return  -2 - conbee device is not connected
+*/
+int32_t conbee_aps_send_many(struct conbee_device *dev, struct conbee_aps_request *request, struct conbee_aps_address *destinations,
+                             uint16_t n, uint8_t *sequence_numbers)
+{
+  uint8_t buffer[APS_REQUEST_MAX_LENGTH];
+
+  if (dev->tty_status == TTY_DISCONNECTED)
+  {
+    return -2;
+  }
+
+  if (n == 0 || n > 255)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  // all destinations have to share the layout of the template
+  for(uint16_t i = 1; i < n; i++)
+  {
+    if (destinations[i].addr_mode != destinations[0].addr_mode)
+    {
+      errno = EINVAL;
+      return -1;
+    }
+  }
+
+  uint16_t length = aps_request_serialize(request, &destinations[0], buffer);
+  if (length == 0)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  /*
+  * the frame is split into a prefix holding everything which changes per destination
+  * and a suffix which is summed up and slip encoded only once
+  */
+  uint16_t prefix_length = APS_REQUEST_DST_OFFSET + aps_address_width(destinations[0].addr_mode) +
+                           (destinations[0].addr_mode == DEST_ADDR_GROUP ? 0 : 1);
+  uint16_t suffix_length = length - prefix_length;
+  uint16_t suffix_sum    = crc16_update(0, &buffer[prefix_length], suffix_length);
+
+  uint8_t *suffix = malloc(2 * suffix_length);
+  if (suffix == NULL)
+  {
+    return -1;
+  }
+  uint32_t suffix_encoded = slip_encode(&buffer[prefix_length], suffix_length, suffix);
+
+  // worst case size of one encoded frame: END, prefix, suffix, checksum, END
+  uint32_t frame_max = 2 + 2 * prefix_length + suffix_encoded + 2 * sizeof(uint16_t);
+
+  struct conbee_frame *frame = conbee_init_frame();
+  frame->wire = malloc(frame_max * n);
+  if (frame->wire == NULL)
+  {
+    free(suffix);
+    conbee_free_frame(frame);
+    return -1;
+  }
+
+  uint8_t first = conbee_reserve_sequence_numbers(dev, n);
+  uint8_t *out  = frame->wire;
+
+  for(uint16_t i = 0; i < n; i++)
+  {
+    uint8_t sequence_number = first + i;
+    uint8_t crc[2];
+
+    buffer[1]                     = sequence_number;
+    buffer[APS_REQUEST_ID_OFFSET] = sequence_number;
+    aps_address_serialize(&destinations[i], &buffer[APS_REQUEST_DST_OFFSET]);
+
+    uint16_t checksum = crc16_finish(crc16_update(suffix_sum, buffer, prefix_length));
+    crc[0] = checksum & 0xFF;
+    crc[1] = checksum >> 8;
+
+    *out++ = END;
+    out   += slip_encode(buffer, prefix_length, out);
+    memcpy(out, suffix, suffix_encoded);
+    out   += suffix_encoded;
+    out   += slip_encode(crc, sizeof(crc), out);
+    *out++ = END;
+
+    if (sequence_numbers != NULL)
+    {
+      sequence_numbers[i] = sequence_number;
+    }
+  }
+
+  free(suffix);
+
+  frame->command          = COMMAND_APS_DATA_REQUEST;
+  frame->sequence_number  = first;
+  frame->wire_length      = out - frame->wire;
+  frame->wire_frames      = n;
+
+  conbee_push_frame(dev, frame);
+
+  return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <conbee.h>
+#include <conbee-internal.h>
+#include <string.h>
+
+/**
+* @brief enable or disable the parameter cache of a device
+*
+* @param dev    - the device, make sure it is already connected
+* @param enable - 1 to enable the cache, 0 to disable it
+*/
+void conbee_enable_parameter_cache(struct conbee_device *dev, uint8_t enable)
+{
+  struct conbee_parameter_cache *cache = &dev->parameter_cache;
+
+  pthread_mutex_lock(&cache->mutex);
+  cache->enabled = enable ? 1 : 0;
+  cache->generation++;
+  memset(cache->valid, 0, sizeof(cache->valid));
+  pthread_mutex_unlock(&cache->mutex);
+}
+
+/**
+* @brief drop all values of the parameter cache of a device
+*
+* @param dev - the device, make sure it is already connected
+*/
+void conbee_invalidate_parameter_cache(struct conbee_device *dev)
+{
+  struct conbee_parameter_cache *cache = &dev->parameter_cache;
+
+  pthread_mutex_lock(&cache->mutex);
+  cache->generation++;
+  memset(cache->valid, 0, sizeof(cache->valid));
+  pthread_mutex_unlock(&cache->mutex);
+}
+
+/**
+* @brief look up a parameter in the parameter cache
+*
+* @param dev       - the device
+* @param parameter - the parameter id
+* @param value     - the cached value
+*
+* @return   0 - the value was found
+* @return  -1 - the cache is disabled or does not contain the value
+*/
+int32_t conbee_parameter_cache_get(struct conbee_device *dev, uint8_t parameter, uint64_t *value)
+{
+  struct conbee_parameter_cache *cache = &dev->parameter_cache;
+  int32_t err = -1;
+
+  if (parameter >= PARAMETER_CACHE_SIZE)
+  {
+    return -1;
+  }
+
+  pthread_mutex_lock(&cache->mutex);
+  if (cache->enabled && cache->valid[parameter])
+  {
+    *value = cache->value[parameter];
+    err = 0;
+  }
+  pthread_mutex_unlock(&cache->mutex);
+
+  return err;
+}
+
+/**
+* @brief return the current generation of the parameter cache
+*
+* @param dev - the device
+*
+* @return the current generation
+*/
+uint32_t conbee_parameter_cache_generation(struct conbee_device *dev)
+{
+  struct conbee_parameter_cache *cache = &dev->parameter_cache;
+  uint32_t generation;
+
+  pthread_mutex_lock(&cache->mutex);
+  generation = cache->generation;
+  pthread_mutex_unlock(&cache->mutex);
+
+  return generation;
+}
+
+/**
+* @brief store a value read from the stick in the parameter cache
+*
+* @param dev        - the device
+* @param parameter  - the parameter id
+* @param value      - the value read from the stick
+* @param generation - the cache generation fetched before the value was requested
+*/
+void conbee_parameter_cache_store(struct conbee_device *dev, uint8_t parameter, uint64_t value, uint32_t generation)
+{
+  struct conbee_parameter_cache *cache = &dev->parameter_cache;
+
+  if (parameter >= PARAMETER_CACHE_SIZE)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&cache->mutex);
+  if (cache->enabled && cache->generation == generation)
+  {
+    cache->value[parameter] = value;
+    cache->valid[parameter] = 1;
+  }
+  pthread_mutex_unlock(&cache->mutex);
+}
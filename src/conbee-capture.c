@@ -0,0 +1,182 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <conbee.h>
+#include <conbee-internal.h>
+#include <conbee-capture.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+
+/**
+* @brief start recording the raw bytes written to and read from the stick into a capture file
+*
+* unlike the wire trace a capture is not limited in size, it is meant for recording traffic
+* to replay it later with the replay transport. Records are buffered, the file is complete
+* after conbee_disable_capture or conbee_close.
+*
+* @param dev  - the device, make sure it is already connected
+* @param path - the capture file to write
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+*/
+int32_t conbee_enable_capture(struct conbee_device *dev, const char *path)
+{
+  struct conbee_capture_header header;
+  struct timespec now;
+
+  pthread_mutex_lock(&dev->mutex_capture);
+  if (dev->capture != NULL)
+  {
+    pthread_mutex_unlock(&dev->mutex_capture);
+    errno = EBUSY;
+    return -1;
+  }
+
+  struct conbee_capture *capture = malloc(sizeof(struct conbee_capture));
+  if (capture == NULL)
+  {
+    pthread_mutex_unlock(&dev->mutex_capture);
+    return -1;
+  }
+
+  capture->file = fopen(path, "w");
+  if (capture->file == NULL)
+  {
+    pthread_mutex_unlock(&dev->mutex_capture);
+    free(capture);
+    return -1;
+  }
+
+  clock_gettime(CLOCK_REALTIME, &now);
+
+  header.magic              = CONBEE_CAPTURE_MAGIC;
+  header.version            = CONBEE_CAPTURE_VERSION;
+  header.header_size        = sizeof(header);
+  header.start_realtime_ns  = ((uint64_t) now.tv_sec) * 1000000000 + now.tv_nsec;
+
+  if (fwrite(&header, sizeof(header), 1, capture->file) != 1)
+  {
+    pthread_mutex_unlock(&dev->mutex_capture);
+    fclose(capture->file);
+    free(capture);
+    return -1;
+  }
+
+  capture->last_us  = conbee_now_us();
+  capture->failed   = 0;
+
+  __atomic_store_n(&dev->capture, capture, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&dev->mutex_capture);
+
+  return 0;
+}
+
+/**
+* @brief stop recording and close the capture file
+*
+* @param dev - the device
+*
+* @return   0 - everything went fine, the capture is complete
+* @return  -1 - writing the capture failed, use errno to find out what
+*/
+int32_t conbee_disable_capture(struct conbee_device *dev)
+{
+  int32_t err = 0;
+
+  pthread_mutex_lock(&dev->mutex_capture);
+  struct conbee_capture *capture = dev->capture;
+  __atomic_store_n(&dev->capture, NULL, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&dev->mutex_capture);
+
+  if (capture == NULL)
+  {
+    return 0;
+  }
+
+  if (capture->failed)
+  {
+    errno = EIO;
+    err   = -1;
+  }
+
+  if (fclose(capture->file) != 0)
+  {
+    err = -1;
+  }
+
+  free(capture);
+
+  return err;
+}
+
+/**
+* @brief record raw bytes written to or read from the stick, only called by the worker
+*
+* @param dev       - the device
+* @param direction - CONBEE_TRACE_TX or CONBEE_TRACE_RX
+* @param data      - the raw bytes
+* @param length    - the number of raw bytes
+*/
+void conbee_capture_record(struct conbee_device *dev, uint8_t direction, uint8_t *data, uint32_t length)
+{
+  struct conbee_capture_record record;
+
+  // no locking at all while nothing is captured
+  if (__atomic_load_n(&dev->capture, __ATOMIC_ACQUIRE) == NULL)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&dev->mutex_capture);
+
+  struct conbee_capture *capture = dev->capture;
+  if (capture == NULL || capture->failed)
+  {
+    pthread_mutex_unlock(&dev->mutex_capture);
+    return;
+  }
+
+  uint64_t now   = conbee_now_us();
+  uint64_t delta = now - capture->last_us;
+  capture->last_us = now;
+
+  // long writes are split, the following parts are recorded at the same time
+  do
+  {
+    record.delta_us   = delta > UINT32_MAX ? UINT32_MAX : delta;
+    record.length     = length > UINT16_MAX ? UINT16_MAX : length;
+    record.direction  = direction;
+    record.reserved   = 0;
+
+    if (fwrite(&record, sizeof(record), 1, capture->file) != 1 ||
+        fwrite(data, 1, record.length, capture->file) != record.length)
+    {
+      capture->failed = 1;
+      break;
+    }
+
+    data   += record.length;
+    length -= record.length;
+    delta   = 0;
+  } while(length > 0);
+
+  pthread_mutex_unlock(&dev->mutex_capture);
+}
@@ -0,0 +1,131 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <conbee.h>
+#include <string.h>
+
+/**
+* all parameters known to the library, sorted by id
+*/
+static const struct conbee_parameter_descriptor descriptors[] = {
+  { PARAM_MAC_ADDRESS,          "mac_address",          8,  PARAMETER_READABLE },
+  { PARAM_NWK_PANID,            "nwk_panid",            2,  PARAMETER_READABLE | PARAMETER_WRITABLE },
+  { PARAM_NWK_ADDRESS,          "nwk_address",          2,  PARAMETER_READABLE },
+  { PARAM_NWK_EXT_PANID,        "nwk_ext_panid",        8,  PARAMETER_READABLE },
+  { PARAM_APS_COORDINATOR,      "aps_coordinator",      1,  PARAMETER_READABLE | PARAMETER_WRITABLE },
+  { PARAM_CHANNEL_MASK,         "channel_mask",         4,  PARAMETER_READABLE | PARAMETER_WRITABLE },
+  { PARAM_APS_EXT_PANID,        "aps_ext_panid",        8,  PARAMETER_READABLE | PARAMETER_WRITABLE },
+  { PARAM_TRUST_CENTER_ADDRESS, "trust_center_address", 8,  PARAMETER_READABLE | PARAMETER_WRITABLE },
+  { PARAM_SECURITY_MODE,        "security_mode",        1,  PARAMETER_READABLE | PARAMETER_WRITABLE },
+  { PARAM_NETWORK_KEY,          "network_key",          16, PARAMETER_READABLE | PARAMETER_WRITABLE | PARAMETER_RAW },
+  { PARAM_CURRENT_CHANNEL,      "current_channel",      1,  PARAMETER_READABLE },
+  { PARAM_PROTOCOL_VERSION,     "protocol_version",     2,  PARAMETER_READABLE },
+  { PARAM_NWK_UPDATE_ID,        "nwk_update_id",        1,  PARAMETER_READABLE | PARAMETER_WRITABLE },
+  { PARAM_WATCHDOG_TTL,         "watchdog_ttl",         4,  PARAMETER_READABLE | PARAMETER_WRITABLE },
+};
+
+/**
+* @brief return the descriptor of a parameter
+*
+* @param id - the parameter id (PARAM_*)
+*
+* @return pointer to the descriptor, NULL if the parameter is unknown
+*/
+const struct conbee_parameter_descriptor * conbee_parameter_descriptor(uint8_t id)
+{
+  for(uint32_t i = 0; i < sizeof(descriptors)/sizeof(descriptors[0]); i++)
+  {
+    if (descriptors[i].id == id)
+    {
+      return &descriptors[i];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+* @brief return the descriptors of all parameters known to the library
+*
+* @param n - the number of descriptors
+*
+* @return pointer to the first of n descriptors, sorted by id
+*/
+const struct conbee_parameter_descriptor * conbee_parameter_descriptors(uint16_t *n)
+{
+  *n = sizeof(descriptors)/sizeof(descriptors[0]);
+
+  return descriptors;
+}
+
+/**
+* @brief convert the value of a parameter into an integer
+*
+* @param descriptor - the descriptor of the parameter
+* @param parameter  - the parameter as read from the stick
+* @param value      - the integer value
+*
+* @return   0 - everything went fine
+* @return  -1 - the parameter is no integer or its length does not match the descriptor
+*/
+int32_t conbee_parameter_decode(const struct conbee_parameter_descriptor *descriptor, struct conbee_parameter *parameter, uint64_t *value)
+{
+  if ((descriptor->flags & PARAMETER_RAW) || parameter->length != descriptor->length)
+  {
+    return -1;
+  }
+
+  *value = 0;
+  for(uint8_t i = 0; i < descriptor->length; i++)
+  {
+    uint8_t shift = descriptor->flags & PARAMETER_BIG_ENDIAN ? descriptor->length - 1 - i : i;
+    *value |= ((uint64_t) parameter->value.bytes[i]) << (8*shift);
+  }
+
+  return 0;
+}
+
+/**
+* @brief convert an integer into the value of a parameter
+*
+* @param descriptor - the descriptor of the parameter
+* @param value      - the integer value
+* @param parameter  - the parameter to write to the stick, id, length and value are set
+*
+* @return   0 - everything went fine
+* @return  -1 - the parameter is no integer
+*/
+int32_t conbee_parameter_encode(const struct conbee_parameter_descriptor *descriptor, uint64_t value, struct conbee_parameter *parameter)
+{
+  if (descriptor->flags & PARAMETER_RAW)
+  {
+    return -1;
+  }
+
+  memset(parameter->value.bytes, 0, PARAMETER_MAX_LENGTH);
+  parameter->id     = descriptor->id;
+  parameter->length = descriptor->length;
+
+  for(uint8_t i = 0; i < descriptor->length; i++)
+  {
+    uint8_t shift = descriptor->flags & PARAMETER_BIG_ENDIAN ? descriptor->length - 1 - i : i;
+    parameter->value.bytes[i] = (value >> (8*shift)) & 0xFF;
+  }
+
+  return 0;
+}
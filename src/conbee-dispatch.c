@@ -0,0 +1,335 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <conbee.h>
+#include <conbee-dispatch.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/// the wildcard pattern bit for the cluster id
+#define PATTERN_ANY_CLUSTER       0x01
+
+/// the wildcard pattern bit for the profile id
+#define PATTERN_ANY_PROFILE       0x02
+
+/// the wildcard pattern bit for the destination endpoint
+#define PATTERN_ANY_DST_ENDPOINT  0x04
+
+/// the wildcard pattern bit for the source endpoint
+#define PATTERN_ANY_SRC_ENDPOINT  0x08
+
+/**
+* the order in which the wildcard patterns are probed, most specific first
+*/
+static const uint8_t pattern_order[APS_HANDLER_PATTERNS] = {
+  0x00,
+  0x01, 0x02, 0x04, 0x08,
+  0x03, 0x05, 0x06, 0x09, 0x0A, 0x0C,
+  0x07, 0x0B, 0x0D, 0x0E,
+  0x0F
+};
+
+/**
+* @brief build the table key for the given fields and wildcard pattern
+*
+* key layout: cluster bits 0-15, profile bits 16-31, dst endpoint bits 32-39,
+* src endpoint bits 40-47 and the wildcard pattern bits 48-51. Wildcarded fields are zero.
+*/
+static uint64_t aps_handler_key(uint8_t src_endpoint, uint8_t dst_endpoint, uint16_t profile, uint16_t cluster, uint8_t pattern)
+{
+  uint64_t key = 0;
+
+  if (!(pattern & PATTERN_ANY_CLUSTER))
+  {
+    key |= (uint64_t) cluster;
+  }
+
+  if (!(pattern & PATTERN_ANY_PROFILE))
+  {
+    key |= ((uint64_t) profile) << 16;
+  }
+
+  if (!(pattern & PATTERN_ANY_DST_ENDPOINT))
+  {
+    key |= ((uint64_t) dst_endpoint) << 32;
+  }
+
+  if (!(pattern & PATTERN_ANY_SRC_ENDPOINT))
+  {
+    key |= ((uint64_t) src_endpoint) << 40;
+  }
+
+  key |= ((uint64_t) pattern) << 48;
+
+  return key;
+}
+
+/**
+* @brief map a key to its hash bucket
+*/
+static uint32_t aps_handler_bucket(uint64_t key)
+{
+  // finalizer of murmur3, spreads the few changing bits over the whole word
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+
+  return key & (APS_HANDLER_BUCKETS - 1);
+}
+
+/**
+* @brief convert the user supplied key fields into a key, checking the ranges
+*
+* @return   0 - everything went fine
+* @return  -1 - one of the fields is out of range
+*/
+static int32_t aps_handler_user_key(int32_t src_endpoint, int32_t dst_endpoint, int32_t profile, int32_t cluster, uint64_t *key)
+{
+  uint8_t pattern = 0;
+
+  if ((src_endpoint != APS_MATCH_ANY && (src_endpoint < 0 || src_endpoint > 0xFF)) ||
+      (dst_endpoint != APS_MATCH_ANY && (dst_endpoint < 0 || dst_endpoint > 0xFF)) ||
+      (profile != APS_MATCH_ANY && (profile < 0 || profile > 0xFFFF)) ||
+      (cluster != APS_MATCH_ANY && (cluster < 0 || cluster > 0xFFFF)))
+  {
+    return -1;
+  }
+
+  pattern |= cluster      == APS_MATCH_ANY ? PATTERN_ANY_CLUSTER      : 0;
+  pattern |= profile      == APS_MATCH_ANY ? PATTERN_ANY_PROFILE      : 0;
+  pattern |= dst_endpoint == APS_MATCH_ANY ? PATTERN_ANY_DST_ENDPOINT : 0;
+  pattern |= src_endpoint == APS_MATCH_ANY ? PATTERN_ANY_SRC_ENDPOINT : 0;
+
+  *key = aps_handler_key(src_endpoint, dst_endpoint, profile, cluster, pattern);
+
+  return 0;
+}
+
+/**
+* @brief initialize an aps handler table
+*
+* @param table - pointer to the table
+*/
+void conbee_aps_handler_table_init(struct conbee_aps_handler_table *table)
+{
+  memset(table->buckets, 0, sizeof(table->buckets));
+  memset(table->patterns, 0, sizeof(table->patterns));
+  pthread_rwlock_init(&table->lock, NULL);
+}
+
+/**
+* @brief free all handlers of an aps handler table
+*
+* @param table - pointer to the table
+*/
+void conbee_aps_handler_table_free(struct conbee_aps_handler_table *table)
+{
+  pthread_rwlock_wrlock(&table->lock);
+  for(uint32_t i = 0; i < APS_HANDLER_BUCKETS; i++)
+  {
+    struct conbee_aps_handler *handler = table->buckets[i];
+
+    while(handler != NULL)
+    {
+      struct conbee_aps_handler *next = handler->next;
+      free(handler);
+      handler = next;
+    }
+
+    table->buckets[i] = NULL;
+  }
+  memset(table->patterns, 0, sizeof(table->patterns));
+  pthread_rwlock_unlock(&table->lock);
+
+  pthread_rwlock_destroy(&table->lock);
+}
+
+/**
+* @brief register a handler for aps indications
+*
+* every key field can be set to APS_MATCH_ANY. Registering a handler for an already
+* registered key replaces the old handler. If more than one handler matches an indication
+* the most specific one is called, the exact match is always looked up first.
+*
+* @param dev          - the device to register the handler at, make sure it is already connected
+* @param src_endpoint - the source endpoint to match or APS_MATCH_ANY
+* @param dst_endpoint - the destination endpoint to match or APS_MATCH_ANY
+* @param profile      - the profile id to match or APS_MATCH_ANY
+* @param cluster      - the cluster id to match or APS_MATCH_ANY
+* @param cb           - the function to call for matching indications
+* @param userdata     - pointer handed to the callback
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+*/
+int32_t conbee_register_aps_handler(struct conbee_device *dev, int32_t src_endpoint, int32_t dst_endpoint, int32_t profile, int32_t cluster,
+                                    int32_t (*cb)(struct conbee_device *dev, struct conbee_aps_indication *indication, void *userdata), void *userdata)
+{
+  struct conbee_aps_handler_table *table = &dev->aps_handlers;
+  uint64_t key;
+
+  if (cb == NULL || aps_handler_user_key(src_endpoint, dst_endpoint, profile, cluster, &key) < 0)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  uint32_t bucket = aps_handler_bucket(key);
+
+  pthread_rwlock_wrlock(&table->lock);
+
+  // replace an already registered handler
+  for(struct conbee_aps_handler *handler = table->buckets[bucket]; handler != NULL; handler = handler->next)
+  {
+    if (handler->key == key)
+    {
+      handler->cb       = cb;
+      handler->userdata = userdata;
+      pthread_rwlock_unlock(&table->lock);
+      return 0;
+    }
+  }
+
+  struct conbee_aps_handler *handler = malloc(sizeof(struct conbee_aps_handler));
+  if (handler == NULL)
+  {
+    pthread_rwlock_unlock(&table->lock);
+    return -1;
+  }
+
+  handler->key              = key;
+  handler->cb               = cb;
+  handler->userdata         = userdata;
+  handler->next             = table->buckets[bucket];
+  table->buckets[bucket]    = handler;
+  table->patterns[key >> 48]++;
+
+  pthread_rwlock_unlock(&table->lock);
+
+  return 0;
+}
+
+/**
+* @brief remove a handler registered with conbee_register_aps_handler
+*
+* @param dev          - the device the handler is registered at
+* @param src_endpoint - the source endpoint of the handler or APS_MATCH_ANY
+* @param dst_endpoint - the destination endpoint of the handler or APS_MATCH_ANY
+* @param profile      - the profile id of the handler or APS_MATCH_ANY
+* @param cluster      - the cluster id of the handler or APS_MATCH_ANY
+*
+* @return   0 - handler removed
+* @return  -1 - no such handler registered
+*/
+int32_t conbee_unregister_aps_handler(struct conbee_device *dev, int32_t src_endpoint, int32_t dst_endpoint, int32_t profile, int32_t cluster)
+{
+  struct conbee_aps_handler_table *table = &dev->aps_handlers;
+  uint64_t key;
+
+  if (aps_handler_user_key(src_endpoint, dst_endpoint, profile, cluster, &key) < 0)
+  {
+    return -1;
+  }
+
+  uint32_t bucket = aps_handler_bucket(key);
+
+  pthread_rwlock_wrlock(&table->lock);
+
+  struct conbee_aps_handler **link = &table->buckets[bucket];
+  while(*link != NULL)
+  {
+    struct conbee_aps_handler *handler = *link;
+
+    if (handler->key == key)
+    {
+      *link = handler->next;
+      table->patterns[key >> 48]--;
+      pthread_rwlock_unlock(&table->lock);
+      free(handler);
+      return 0;
+    }
+
+    link = &handler->next;
+  }
+
+  pthread_rwlock_unlock(&table->lock);
+
+  return -1;
+}
+
+/**
+* @brief decode an aps data indication frame and call the matching handler
+*
+* @param dev   - the device the frame was received from
+* @param frame - the received aps data indication frame, still owned by the caller
+*
+* @return   1 - a handler was called
+* @return   0 - no handler matches the indication
+* @return  -1 - the frame is no valid aps data indication
+*/
+int32_t conbee_dispatch_aps_indication(struct conbee_device *dev, struct conbee_frame *frame)
+{
+  struct conbee_aps_handler_table *table = &dev->aps_handlers;
+  struct conbee_aps_indication indication;
+  int32_t (*cb)(struct conbee_device *, struct conbee_aps_indication *, void *) = NULL;
+  void *userdata = NULL;
+
+  if (conbee_aps_indication_response(frame, &indication) < 0)
+  {
+    return -1;
+  }
+
+  pthread_rwlock_rdlock(&table->lock);
+
+  for(uint32_t i = 0; i < APS_HANDLER_PATTERNS && cb == NULL; i++)
+  {
+    uint8_t pattern = pattern_order[i];
+
+    // skip patterns without any registered handler
+    if (table->patterns[pattern] == 0)
+    {
+      continue;
+    }
+
+    uint64_t key = aps_handler_key(indication.src_endpoint, indication.dst_endpoint,
+                                   indication.profile_id, indication.cluster_id, pattern);
+
+    for(struct conbee_aps_handler *handler = table->buckets[aps_handler_bucket(key)]; handler != NULL; handler = handler->next)
+    {
+      if (handler->key == key)
+      {
+        cb       = handler->cb;
+        userdata = handler->userdata;
+        break;
+      }
+    }
+  }
+
+  pthread_rwlock_unlock(&table->lock);
+
+  // call the handler without holding the lock, so it may (un)register handlers itself
+  if (cb == NULL)
+  {
+    return 0;
+  }
+
+  cb(dev, &indication, userdata);
+
+  return 1;
+}
@@ -17,7 +17,6 @@
 
  /** @file */
  #include <conbee.h>
- #include <conbee-internal.h>
  #include <string.h>
 
  /**
@@ -56,31 +55,14 @@
  */
  int32_t conbee_get_mac_address(struct conbee_device *dev, uint8_t mac[8])
  {
-   struct conbee_frame *request  = conbee_read_parameter_request(PARAM_MAC_ADDRESS);
-   struct conbee_frame *response;
-   uint8_t sequence_number = 0;
-   uint8_t err = 0;
-
-   sequence_number = conbee_enqueue_frame(dev, request);
-
-   if(sequence_number < 0)
-   {
-     return sequence_number;
-   }
-
-   err = conbee_wait_for_frame(dev, &response, sequence_number, COMMAND_READ_PARAMETER);
+   uint64_t value;
+   int32_t err = conbee_get_parameter_uint(dev, PARAM_MAC_ADDRESS, &value);
 
-   if (!conbee_frame_success(response))
+   if (err == 0)
    {
-     conbee_free_frame(response);
-     return -1;
+     memcpy(mac,(void *)&value,8);
    }
 
-   uint64_t value;
-   err = conbee_read_parameter_response_uint64(response, &value);
-
-   memcpy(mac,(void *)&value,8);
-
    return err;
  }
 
@@ -95,28 +77,14 @@
  */
  int32_t conbee_get_nwk_panid(struct conbee_device *dev, uint16_t *panid)
  {
-   struct conbee_frame *request  = conbee_read_parameter_request(PARAM_NWK_PANID);
-   struct conbee_frame *response;
-   uint8_t sequence_number = 0;
-   uint8_t err = 0;
-
-   sequence_number = conbee_enqueue_frame(dev, request);
-
-   if(sequence_number < 0)
-   {
-     return sequence_number;
-   }
-
-   err = conbee_wait_for_frame(dev, &response, sequence_number, COMMAND_READ_PARAMETER);
+   uint64_t value;
+   int32_t err = conbee_get_parameter_uint(dev, PARAM_NWK_PANID, &value);
 
-   if (!conbee_frame_success(response))
+   if (err == 0)
    {
-     conbee_free_frame(response);
-     return -1;
+     *panid = value;
    }
 
-   err = conbee_read_parameter_response_uint16(response, panid);
-
    return err;
  }
 
@@ -131,28 +99,14 @@
  */
  int32_t conbee_get_nwk_address(struct conbee_device *dev, uint16_t *addr)
  {
-   struct conbee_frame *request  = conbee_read_parameter_request(PARAM_NWK_ADDRESS);
-   struct conbee_frame *response;
-   uint8_t sequence_number = 0;
-   uint8_t err = 0;
-
-   sequence_number = conbee_enqueue_frame(dev, request);
-
-   if(sequence_number < 0)
-   {
-     return sequence_number;
-   }
-
-   err = conbee_wait_for_frame(dev, &response, sequence_number, COMMAND_READ_PARAMETER);
+   uint64_t value;
+   int32_t err = conbee_get_parameter_uint(dev, PARAM_NWK_ADDRESS, &value);
 
-   if (!conbee_frame_success(response))
+   if (err == 0)
    {
-     conbee_free_frame(response);
-     return -1;
+     *addr = value;
    }
 
-   err = conbee_read_parameter_response_uint16(response, addr);
-
    return err;
  }
 
@@ -167,28 +121,14 @@
  */
  int32_t conbee_get_nwk_extended_panid(struct conbee_device *dev, uint64_t *panid)
  {
-   struct conbee_frame *request  = conbee_read_parameter_request(PARAM_NWK_EXT_PANID);
-   struct conbee_frame *response;
-   uint8_t sequence_number = 0;
-   uint8_t err = 0;
-
-   sequence_number = conbee_enqueue_frame(dev, request);
-
-   if(sequence_number < 0)
-   {
-     return sequence_number;
-   }
-
-   err = conbee_wait_for_frame(dev, &response, sequence_number, COMMAND_READ_PARAMETER);
+   uint64_t value;
+   int32_t err = conbee_get_parameter_uint(dev, PARAM_NWK_EXT_PANID, &value);
 
-   if (!conbee_frame_success(response))
+   if (err == 0)
    {
-     conbee_free_frame(response);
-     return -1;
+     *panid = value;
    }
 
-   err = conbee_read_parameter_response_uint64(response, panid);
-
    return err;
  }
 
@@ -203,28 +143,14 @@
  */
  int32_t conbee_get_network_mode(struct conbee_device *dev, uint8_t *mode)
  {
-   struct conbee_frame *request  = conbee_read_parameter_request(PARAM_APS_COORDINATOR);
-   struct conbee_frame *response;
-   uint8_t sequence_number = 0;
-   uint8_t err = 0;
-
-   sequence_number = conbee_enqueue_frame(dev, request);
-
-   if(sequence_number < 0)
-   {
-     return sequence_number;
-   }
-
-   err = conbee_wait_for_frame(dev, &response, sequence_number, COMMAND_READ_PARAMETER);
+   uint64_t value;
+   int32_t err = conbee_get_parameter_uint(dev, PARAM_APS_COORDINATOR, &value);
 
-   if (!conbee_frame_success(response))
+   if (err == 0)
    {
-     conbee_free_frame(response);
-     return -1;
+     *mode = value;
    }
 
-   err = conbee_read_parameter_response_uint8(response, mode);
-
    return err;
  }
 
@@ -239,29 +165,7 @@
  */
  int32_t conbee_set_network_mode(struct conbee_device *dev, uint8_t mode)
  {
-   struct conbee_frame *request  = conbee_write_parameter_request_uint8(PARAM_APS_COORDINATOR, &mode);
-   struct conbee_frame *response;
-   uint8_t sequence_number = 0;
-   uint8_t err = 0;
-
-   sequence_number = conbee_enqueue_frame(dev, request);
-
-   if(sequence_number < 0)
-   {
-     return sequence_number;
-   }
-
-   err = conbee_wait_for_frame(dev, &response, sequence_number, COMMAND_WRITE_PARAMETER);
-
-   if (!conbee_frame_success(response))
-   {
-     conbee_free_frame(response);
-     return -1;
-   }
-
-   conbee_free_frame(response);
-
-   return err;
+   return conbee_set_parameter_uint(dev, PARAM_APS_COORDINATOR, mode);
  }
 
  /**
@@ -275,28 +179,14 @@
  */
  int32_t conbee_get_channel_mask(struct conbee_device *dev, uint32_t *mask)
  {
-   struct conbee_frame *request  = conbee_read_parameter_request(PARAM_CHANNEL_MASK);
-   struct conbee_frame *response;
-   uint8_t sequence_number = 0;
-   uint8_t err = 0;
-
-   sequence_number = conbee_enqueue_frame(dev, request);
-
-   if(sequence_number < 0)
-   {
-     return sequence_number;
-   }
-
-   err = conbee_wait_for_frame(dev, &response, sequence_number, COMMAND_READ_PARAMETER);
+   uint64_t value;
+   int32_t err = conbee_get_parameter_uint(dev, PARAM_CHANNEL_MASK, &value);
 
-   if (!conbee_frame_success(response))
+   if (err == 0)
    {
-     conbee_free_frame(response);
-     return -1;
+     *mask = value;
    }
 
-   err = conbee_read_parameter_response_uint32(response, mask);
-
    return err;
  }
 
@@ -311,29 +201,7 @@
  */
  int32_t conbee_set_channel_mask(struct conbee_device *dev, uint32_t mask)
  {
-   struct conbee_frame *request  = conbee_write_parameter_request_uint32(PARAM_CHANNEL_MASK, &mask);
-   struct conbee_frame *response;
-   uint8_t sequence_number = 0;
-   uint8_t err = 0;
-
-   sequence_number = conbee_enqueue_frame(dev, request);
-
-   if(sequence_number < 0)
-   {
-     return sequence_number;
-   }
-
-   err = conbee_wait_for_frame(dev, &response, sequence_number, COMMAND_WRITE_PARAMETER);
-
-   if (!conbee_frame_success(response))
-   {
-     conbee_free_frame(response);
-     return -1;
-   }
-
-   conbee_free_frame(response);
-
-   return err;
+   return conbee_set_parameter_uint(dev, PARAM_CHANNEL_MASK, mask);
  }
 
  /**
@@ -347,28 +215,14 @@
  */
  int32_t conbee_get_aps_extended_panid(struct conbee_device *dev, uint64_t *panid)
  {
-   struct conbee_frame *request  = conbee_read_parameter_request(PARAM_APS_EXT_PANID);
-   struct conbee_frame *response;
-   uint8_t sequence_number = 0;
-   uint8_t err = 0;
-
-   sequence_number = conbee_enqueue_frame(dev, request);
-
-   if(sequence_number < 0)
-   {
-     return sequence_number;
-   }
-
-   err = conbee_wait_for_frame(dev, &response, sequence_number, COMMAND_READ_PARAMETER);
+   uint64_t value;
+   int32_t err = conbee_get_parameter_uint(dev, PARAM_APS_EXT_PANID, &value);
 
-   if (!conbee_frame_success(response))
+   if (err == 0)
    {
-     conbee_free_frame(response);
-     return -1;
+     *panid = value;
    }
 
-   err = conbee_read_parameter_response_uint64(response, panid);
-
    return err;
  }
 
@@ -383,29 +237,7 @@
  */
  int32_t conbee_set_aps_extended_panid(struct conbee_device *dev, uint64_t panid)
  {
-   struct conbee_frame *request  = conbee_write_parameter_request_uint64(PARAM_APS_EXT_PANID, &panid);
-   struct conbee_frame *response;
-   uint8_t sequence_number = 0;
-   uint8_t err = 0;
-
-   sequence_number = conbee_enqueue_frame(dev, request);
-
-   if(sequence_number < 0)
-   {
-     return sequence_number;
-   }
-
-   err = conbee_wait_for_frame(dev, &response, sequence_number, COMMAND_WRITE_PARAMETER);
-
-   if (!conbee_frame_success(response))
-   {
-     conbee_free_frame(response);
-     return -1;
-   }
-
-   conbee_free_frame(response);
-
-   return err;
+   return conbee_set_parameter_uint(dev, PARAM_APS_EXT_PANID, panid);
  }
 
  /**
@@ -419,28 +251,14 @@
  */
  int32_t conbee_get_trust_center_addr(struct conbee_device *dev, uint64_t *addr)
  {
-   struct conbee_frame *request  = conbee_read_parameter_request(PARAM_TRUST_CENTER_ADDRESS);
-   struct conbee_frame *response;
-   uint8_t sequence_number = 0;
-   uint8_t err = 0;
-
-   sequence_number = conbee_enqueue_frame(dev, request);
-
-   if(sequence_number < 0)
-   {
-     return sequence_number;
-   }
-
-   err = conbee_wait_for_frame(dev, &response, sequence_number, COMMAND_READ_PARAMETER);
+   uint64_t value;
+   int32_t err = conbee_get_parameter_uint(dev, PARAM_TRUST_CENTER_ADDRESS, &value);
 
-   if (!conbee_frame_success(response))
+   if (err == 0)
    {
-     conbee_free_frame(response);
-     return -1;
+     *addr = value;
    }
 
-   err = conbee_read_parameter_response_uint64(response, addr);
-
    return err;
  }
 
@@ -455,29 +273,7 @@
  */
  int32_t conbee_set_trust_center_addr(struct conbee_device *dev, uint64_t addr)
  {
-   struct conbee_frame *request  = conbee_write_parameter_request_uint64(PARAM_TRUST_CENTER_ADDRESS, &addr);
-   struct conbee_frame *response;
-   uint8_t sequence_number = 0;
-   uint8_t err = 0;
-
-   sequence_number = conbee_enqueue_frame(dev, request);
-
-   if(sequence_number < 0)
-   {
-     return sequence_number;
-   }
-
-   err = conbee_wait_for_frame(dev, &response, sequence_number, COMMAND_WRITE_PARAMETER);
-
-   if (!conbee_frame_success(response))
-   {
-     conbee_free_frame(response);
-     return -1;
-   }
-
-   conbee_free_frame(response);
-
-   return err;
+   return conbee_set_parameter_uint(dev, PARAM_TRUST_CENTER_ADDRESS, addr);
  }
 
  /**
@@ -491,28 +287,14 @@
  */
  int32_t conbee_get_security_mode(struct conbee_device *dev, uint8_t *mode)
  {
-   struct conbee_frame *request  = conbee_read_parameter_request(PARAM_SECURITY_MODE);
-   struct conbee_frame *response;
-   uint8_t sequence_number = 0;
-   uint8_t err = 0;
-
-   sequence_number = conbee_enqueue_frame(dev, request);
-
-   if(sequence_number < 0)
-   {
-     return sequence_number;
-   }
-
-   err = conbee_wait_for_frame(dev, &response, sequence_number, COMMAND_READ_PARAMETER);
+   uint64_t value;
+   int32_t err = conbee_get_parameter_uint(dev, PARAM_SECURITY_MODE, &value);
 
-   if (!conbee_frame_success(response))
+   if (err == 0)
    {
-     conbee_free_frame(response);
-     return -1;
+     *mode = value;
    }
 
-   err = conbee_read_parameter_response_uint8(response, mode);
-
    return err;
  }
 
@@ -533,28 +315,172 @@
  */
  int32_t conbee_set_security_mode(struct conbee_device *dev, uint8_t mode)
  {
-   struct conbee_frame *request  = conbee_write_parameter_request_uint8(PARAM_SECURITY_MODE, &mode);
-   struct conbee_frame *response;
-   uint8_t sequence_number = 0;
-   uint8_t err = 0;
+   return conbee_set_parameter_uint(dev, PARAM_SECURITY_MODE, mode);
+ }
 
-   sequence_number = conbee_enqueue_frame(dev, request);
+ /**
+ * @brief return the network key
+ *
+ * @param dev - the device from to request the network key
+ * @param key - array containing the network key after calling
+ *
+ * @return -1 - an error occured
+ * @return 0  - everything was fine
+ */
+ int32_t conbee_get_network_key(struct conbee_device *dev, uint8_t key[16])
+ {
+   struct conbee_parameter parameter;
+   parameter.id = PARAM_NETWORK_KEY;
 
-   if(sequence_number < 0)
+   int32_t err = conbee_get_parameter(dev, &parameter);
+
+   if (err == 0)
    {
-     return sequence_number;
+     if (parameter.length != 16)
+     {
+       return -1;
+     }
+     memcpy(key, parameter.value.bytes, 16);
    }
 
-   err = conbee_wait_for_frame(dev, &response, sequence_number, COMMAND_WRITE_PARAMETER);
+   return err;
+ }
+
+ /**
+ * @brief set the network key
+ *
+ * @param dev - the device for which to set the network key
+ * @param key - the key to set
+ *
+ * @return -1 - an error occured
+ * @return 0  - everything was fine
+ */
+ int32_t conbee_set_network_key(struct conbee_device *dev, uint8_t key[16])
+ {
+   struct conbee_parameter parameter;
+
+   memset(&parameter, 0, sizeof(parameter));
+   parameter.id     = PARAM_NETWORK_KEY;
+   parameter.length = 16;
+   memcpy(parameter.value.bytes, key, 16);
+
+   return conbee_set_parameter(dev, &parameter);
+ }
 
-   if (!conbee_frame_success(response))
+ /**
+ * @brief return the channel the stick is currently operating on
+ *
+ * @param dev     - the device from to request the current channel
+ * @param channel - pointer to the returned channel
+ *
+ * @return -1 - an error occured
+ * @return 0  - everything was fine
+ */
+ int32_t conbee_get_current_channel(struct conbee_device *dev, uint8_t *channel)
+ {
+   uint64_t value;
+   int32_t err = conbee_get_parameter_uint(dev, PARAM_CURRENT_CHANNEL, &value);
+
+   if (err == 0)
    {
-     conbee_free_frame(response);
-     return -1;
+     *channel = value;
    }
 
-   conbee_free_frame(response);
+   return err;
+ }
+
+ /**
+ * @brief return the protocol version implemented by the firmware of the stick
+ *
+ * @param dev     - the device from to request the protocol version
+ * @param version - pointer to the returned protocol version
+ *
+ * @return -1 - an error occured
+ * @return 0  - everything was fine
+ */
+ int32_t conbee_get_protocol_version(struct conbee_device *dev, uint16_t *version)
+ {
+   uint64_t value;
+   int32_t err = conbee_get_parameter_uint(dev, PARAM_PROTOCOL_VERSION, &value);
+
+   if (err == 0)
+   {
+     *version = value;
+   }
+
+   return err;
+ }
+
+ /**
+ * @brief return the network update id
+ *
+ * @param dev - the device from to request the network update id
+ * @param id  - pointer to the returned network update id
+ *
+ * @return -1 - an error occured
+ * @return 0  - everything was fine
+ */
+ int32_t conbee_get_nwk_update_id(struct conbee_device *dev, uint8_t *id)
+ {
+   uint64_t value;
+   int32_t err = conbee_get_parameter_uint(dev, PARAM_NWK_UPDATE_ID, &value);
+
+   if (err == 0)
+   {
+     *id = value;
+   }
+
+   return err;
+ }
+
+ /**
+ * @brief set the network update id
+ *
+ * @param dev - the device for which to set the network update id
+ * @param id  - the network update id to set
+ *
+ * @return -1 - an error occured
+ * @return 0  - everything was fine
+ */
+ int32_t conbee_set_nwk_update_id(struct conbee_device *dev, uint8_t id)
+ {
+   return conbee_set_parameter_uint(dev, PARAM_NWK_UPDATE_ID, id);
+ }
+
+ /**
+ * @brief return the watchdog time to live
+ *
+ * @param dev - the device from to request the watchdog time to live
+ * @param ttl - pointer to the returned time to live in seconds
+ *
+ * @return -1 - an error occured
+ * @return 0  - everything was fine
+ */
+ int32_t conbee_get_watchdog_ttl(struct conbee_device *dev, uint32_t *ttl)
+ {
+   uint64_t value;
+   int32_t err = conbee_get_parameter_uint(dev, PARAM_WATCHDOG_TTL, &value);
+
+   if (err == 0)
+   {
+     *ttl = value;
+   }
 
    return err;
+ }
 
+ /**
+ * @brief set the watchdog time to live
+ *
+ * the stick resets itself if the time to live is not refreshed before it expires
+ *
+ * @param dev - the device for which to set the watchdog time to live
+ * @param ttl - the time to live in seconds
+ *
+ * @return -1 - an error occured
+ * @return 0  - everything was fine
+ */
+ int32_t conbee_set_watchdog_ttl(struct conbee_device *dev, uint32_t ttl)
+ {
+   return conbee_set_parameter_uint(dev, PARAM_WATCHDOG_TTL, ttl);
  }
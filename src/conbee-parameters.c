@@ -0,0 +1,429 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <conbee.h>
+#include <conbee-internal.h>
+#include <string.h>
+#include <errno.h>
+
+/**
+* @brief check if the value of a parameter fits into the parameter cache
+*
+* @param id - the parameter id
+*
+* @return the descriptor of the parameter, NULL if the parameter is not cacheable
+*/
+static const struct conbee_parameter_descriptor * conbee_parameter_cacheable(uint8_t id)
+{
+  const struct conbee_parameter_descriptor *descriptor = conbee_parameter_descriptor(id);
+
+  if (descriptor == NULL || (descriptor->flags & PARAMETER_RAW) || descriptor->length > sizeof(uint64_t))
+  {
+    return NULL;
+  }
+
+  return descriptor;
+}
+
+/**
+* @brief read many parameters in one pipelined batch
+*
+* parameters known to the library are taken from the parameter cache if it is enabled,
+* only the missing ones are requested from the stick.
+*
+* @param dev     - the device to read from, make sure it is already connected
+* @param ids     - array of n parameter ids (PARAM_*)
+* @param n       - the number of parameters to read, at most 255
+* @param results - array of n parameters receiving id, status and value of each parameter
+*
+* @return   0 - all parameters have been read
+* @return  -1 - with errno EIO at least one parameter could not be read, check the status of each result,
+*               with any other errno the request failed as a whole and the results are not set
+* @return  -2 - conbee device is not connected
+*/
+int32_t conbee_read_parameters(struct conbee_device *dev, uint8_t *ids, uint16_t n, struct conbee_parameter *results)
+{
+  struct conbee_frame *requests[255];
+  struct conbee_frame *responses[255];
+  uint8_t sequence_numbers[255];
+  uint8_t pending[255];
+  uint16_t m = 0;
+  int32_t err = 0;
+
+  if (dev->tty_status == TTY_DISCONNECTED)
+  {
+    return -2;
+  }
+
+  if (n > 255)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  uint32_t generation = conbee_parameter_cache_generation(dev);
+
+  // answer what we can from the cache, everything else has to be requested
+  for(uint16_t i = 0; i < n; i++)
+  {
+    const struct conbee_parameter_descriptor *descriptor = conbee_parameter_cacheable(ids[i]);
+    uint64_t cached;
+
+    if (descriptor != NULL && conbee_parameter_cache_get(dev, ids[i], &cached) == 0)
+    {
+      memset(results[i].value.bytes, 0, PARAMETER_MAX_LENGTH);
+      results[i].id         = ids[i];
+      results[i].status     = STATUS_SUCCESS;
+      results[i].length     = descriptor->length;
+      results[i].value.u64  = cached;
+    }
+    else
+    {
+      pending[m++] = i;
+    }
+  }
+
+  if (m == 0)
+  {
+    return 0;
+  }
+
+  uint8_t first = conbee_reserve_sequence_numbers(dev, m);
+
+  // build all requests first, so they reach the worker in one go
+  for(uint16_t j = 0; j < m; j++)
+  {
+    requests[j]                   = conbee_read_parameter_request(ids[pending[j]]);
+    requests[j]->sequence_number  = first + j;
+    sequence_numbers[j]           = first + j;
+  }
+
+  conbee_push_frames(dev, requests, m);
+
+  if (conbee_wait_for_frames(dev, responses, sequence_numbers, m, COMMAND_READ_PARAMETER) < 0)
+  {
+    return -1;
+  }
+
+  for(uint16_t j = 0; j < m; j++)
+  {
+    uint8_t i = pending[j];
+
+    if (conbee_read_parameter_response(responses[j], &results[i]) < 0 || results[i].id != ids[i])
+    {
+      if (results[i].status == STATUS_SUCCESS)
+      {
+        results[i].status = STATUS_INVALID_VALUE;
+      }
+      err = -1;
+    }
+    else if (conbee_parameter_cacheable(ids[i]) != NULL)
+    {
+      conbee_parameter_cache_store(dev, ids[i], results[i].value.u64, generation);
+    }
+
+    results[i].id = ids[i];
+    conbee_free_frame(responses[j]);
+  }
+
+  // tell the per parameter failures apart from the failures of the whole request
+  if (err < 0)
+  {
+    errno = EIO;
+  }
+
+  return err;
+}
+
+/**
+* @brief send write requests for all parameters back to back and collect the responses
+*
+* @param dev        - the device to write to
+* @param parameters - array of n parameters to write, the status of each parameter is set
+* @param n          - the number of parameters, at most 255
+*
+* @return   0 - all parameters have been written
+* @return  -1 - at least one parameter could not be written
+*/
+static int32_t conbee_write_parameter_batch(struct conbee_device *dev, struct conbee_parameter *parameters, uint16_t n)
+{
+  struct conbee_frame *requests[255];
+  struct conbee_frame *responses[255];
+  uint8_t sequence_numbers[255];
+  int32_t err = 0;
+
+  if (n == 0)
+  {
+    return 0;
+  }
+
+  uint8_t first = conbee_reserve_sequence_numbers(dev, n);
+
+  for(uint16_t i = 0; i < n; i++)
+  {
+    requests[i]                   = conbee_write_parameter_request(parameters[i].id, parameters[i].value.bytes, parameters[i].length);
+    requests[i]->sequence_number  = first + i;
+    sequence_numbers[i]           = first + i;
+  }
+
+  conbee_push_frames(dev, requests, n);
+
+  err = conbee_wait_for_frames(dev, responses, sequence_numbers, n, COMMAND_WRITE_PARAMETER);
+
+  // whatever has been written, cached values may be stale now
+  conbee_invalidate_parameter_cache(dev);
+
+  if (err < 0)
+  {
+    return -1;
+  }
+
+  for(uint16_t i = 0; i < n; i++)
+  {
+    parameters[i].status = responses[i]->status;
+    if (parameters[i].status != STATUS_SUCCESS)
+    {
+      err = -1;
+    }
+
+    conbee_free_frame(responses[i]);
+  }
+
+  return err;
+}
+
+/**
+* @brief write many parameters in one pipelined batch
+*
+* parameters known to the library as read only are refused before anything is written.
+*
+* @param dev        - the device to write to, make sure it is already connected
+* @param parameters - array of n parameters with id, length and value set, the status of each parameter is set on return
+* @param n          - the number of parameters to write, at most 255
+* @param flags      - WRITE_PARAMETERS_VERIFY and/or WRITE_PARAMETERS_ROLLBACK
+*
+* @return   0 - all parameters have been written (and verified)
+* @return  -1 - at least one parameter could not be written or verified, rolled back if requested
+* @return  -2 - conbee device is not connected
+* @return  -3 - the rollback failed, the configuration is partially applied
+*/
+int32_t conbee_write_parameters(struct conbee_device *dev, struct conbee_parameter *parameters, uint16_t n, uint8_t flags)
+{
+  struct conbee_parameter previous[255];
+  struct conbee_parameter restore[255];
+  uint8_t ids[255];
+  uint8_t written[255];
+  int32_t err = 0;
+
+  if (dev->tty_status == TTY_DISCONNECTED)
+  {
+    return -2;
+  }
+
+  if (n > 255)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  for(uint16_t i = 0; i < n; i++)
+  {
+    const struct conbee_parameter_descriptor *descriptor = conbee_parameter_descriptor(parameters[i].id);
+
+    if (parameters[i].length == 0 || parameters[i].length > PARAMETER_MAX_LENGTH ||
+        (descriptor != NULL && !(descriptor->flags & PARAMETER_WRITABLE)))
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+    ids[i] = parameters[i].id;
+  }
+
+  // without the current values there is nothing to roll back to, so do not touch the stick
+  if (flags & WRITE_PARAMETERS_ROLLBACK)
+  {
+    err = conbee_read_parameters(dev, ids, n, previous);
+    if (err == -1 && errno == EIO)
+    {
+      for(uint16_t i = 0; i < n; i++)
+      {
+        parameters[i].status = previous[i].status;
+      }
+    }
+
+    if (err < 0)
+    {
+      return err;
+    }
+  }
+
+  err = conbee_write_parameter_batch(dev, parameters, n);
+
+  for(uint16_t i = 0; i < n; i++)
+  {
+    written[i] = parameters[i].status == STATUS_SUCCESS;
+  }
+
+  if (err == 0 && (flags & WRITE_PARAMETERS_VERIFY))
+  {
+    struct conbee_parameter readback[255];
+
+    // only a completed read carries a status for every parameter
+    err = conbee_read_parameters(dev, ids, n, readback);
+    if (err < 0 && !(err == -1 && errno == EIO))
+    {
+      return err;
+    }
+    err = 0;
+
+    for(uint16_t i = 0; i < n; i++)
+    {
+      if (readback[i].status != STATUS_SUCCESS)
+      {
+        parameters[i].status = readback[i].status;
+        err = -1;
+      }
+      else if (readback[i].length != parameters[i].length ||
+               memcmp(readback[i].value.bytes, parameters[i].value.bytes, parameters[i].length) != 0)
+      {
+        parameters[i].status = STATUS_INVALID_VALUE;
+        err = -1;
+      }
+    }
+  }
+
+  if (err == 0 || !(flags & WRITE_PARAMETERS_ROLLBACK))
+  {
+    return err;
+  }
+
+  // restore every parameter the stick accepted, the failed ones have not been changed
+  uint16_t m = 0;
+  for(uint16_t i = 0; i < n; i++)
+  {
+    if (written[i])
+    {
+      restore[m++] = previous[i];
+    }
+  }
+
+  if (conbee_write_parameter_batch(dev, restore, m) < 0)
+  {
+    return -3;
+  }
+
+  return -1;
+}
+
+/**
+* @brief read one parameter, using the parameter cache if enabled
+*
+* @param dev       - the device to read from, make sure it is already connected
+* @param parameter - the parameter to read, the id has to be set, status, length and value are set on return
+*
+* @return   0 - everything went fine
+* @return  -1 - the parameter could not be read, check its status
+* @return  -2 - conbee device is not connected
+*/
+int32_t conbee_get_parameter(struct conbee_device *dev, struct conbee_parameter *parameter)
+{
+  // the response overwrites the id of the result, the requested id has to stay untouched
+  uint8_t id = parameter->id;
+
+  return conbee_read_parameters(dev, &id, 1, parameter);
+}
+
+/**
+* @brief write one parameter
+*
+* @param dev       - the device to write to, make sure it is already connected
+* @param parameter - the parameter to write with id, length and value set, the status is set on return
+*
+* @return   0 - everything went fine
+* @return  -1 - the parameter could not be written, check its status
+* @return  -2 - conbee device is not connected
+*/
+int32_t conbee_set_parameter(struct conbee_device *dev, struct conbee_parameter *parameter)
+{
+  return conbee_write_parameters(dev, parameter, 1, 0);
+}
+
+/**
+* @brief read an integer parameter known to the library
+*
+* @param dev   - the device to read from, make sure it is already connected
+* @param id    - the parameter id (PARAM_*)
+* @param value - the value read
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+* @return  -2 - conbee device is not connected
+*/
+int32_t conbee_get_parameter_uint(struct conbee_device *dev, uint8_t id, uint64_t *value)
+{
+  const struct conbee_parameter_descriptor *descriptor = conbee_parameter_descriptor(id);
+  struct conbee_parameter parameter;
+  int32_t err;
+
+  if (descriptor == NULL || !(descriptor->flags & PARAMETER_READABLE) || (descriptor->flags & PARAMETER_RAW))
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  parameter.id = id;
+  err = conbee_get_parameter(dev, &parameter);
+  if (err < 0)
+  {
+    return err;
+  }
+
+  if (conbee_parameter_decode(descriptor, &parameter, value) < 0)
+  {
+    errno = EPROTO;
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+* @brief write an integer parameter known to the library
+*
+* @param dev   - the device to write to, make sure it is already connected
+* @param id    - the parameter id (PARAM_*)
+* @param value - the value to write, truncated to the width of the parameter
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+* @return  -2 - conbee device is not connected
+*/
+int32_t conbee_set_parameter_uint(struct conbee_device *dev, uint8_t id, uint64_t value)
+{
+  const struct conbee_parameter_descriptor *descriptor = conbee_parameter_descriptor(id);
+  struct conbee_parameter parameter;
+
+  if (descriptor == NULL || conbee_parameter_encode(descriptor, value, &parameter) < 0)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  return conbee_set_parameter(dev, &parameter);
+}
@@ -0,0 +1,386 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <conbee.h>
+#include <conbee-pool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/**
+* @brief mix a 64 bit value, finalizer of murmur3
+*/
+static uint64_t pool_mix(uint64_t key)
+{
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+
+  return key;
+}
+
+/**
+* @brief return the seed of a device, the FNV-1a hash of its name
+*
+* the name is stable across restarts, so a destination keeps using the same stick
+*/
+static uint64_t pool_seed(struct conbee_device *dev)
+{
+  uint64_t hash = 0xcbf29ce484222325ULL;
+
+  for(const char *c = dev->tty; *c != 0; c++)
+  {
+    hash ^= (uint8_t) *c;
+    hash *= 0x100000001b3ULL;
+  }
+
+  return hash;
+}
+
+/**
+* @brief check if a device should not get more requests right now
+*/
+static uint8_t pool_saturated(struct conbee_device *dev)
+{
+  struct conbee_device_state state;
+
+  if (__atomic_load_n(&dev->stats.send_queue_depth, __ATOMIC_RELAXED) >= POOL_QUEUE_LIMIT)
+  {
+    return 1;
+  }
+
+  // requests sent without free slots are answered with STATUS_BUSY
+  return conbee_device_state_snapshot(dev, &state) == 0 && !state.apsde_data_request_free_slots;
+}
+
+/**
+* @brief select the member for a destination, call with the read lock held
+*
+* @return the index of the member, -1 if no device is up
+*/
+static int32_t pool_route(struct conbee_pool *pool, struct conbee_aps_address *dst)
+{
+  uint64_t key     = pool_mix((dst->addr_mode == DEST_ADDR_IEEE ? dst->ieee_addr : dst->addr) ^ ((uint64_t) dst->addr_mode << 56));
+  uint64_t scores[POOL_MAX_DEVICES];
+  int32_t order[POOL_MAX_DEVICES];
+  int32_t fallback = -1;
+  int32_t selected = -1;
+
+  // rank the members by their score for the destination, highest first
+  for(uint32_t i = 0; i < pool->nr_members; i++)
+  {
+    uint64_t score = pool_mix(key ^ pool->members[i].seed);
+    int32_t k      = i;
+
+    while(k > 0 && scores[k-1] < score)
+    {
+      scores[k] = scores[k-1];
+      order[k]  = order[k-1];
+      k--;
+    }
+    scores[k] = score;
+    order[k]  = i;
+  }
+
+  for(uint32_t i = 0; i < pool->nr_members && selected < 0; i++)
+  {
+    struct conbee_device *dev = pool->members[order[i]].dev;
+
+    if (!conbee_link_up(dev))
+    {
+      continue;
+    }
+
+    if (fallback < 0)
+    {
+      fallback = order[i];
+    }
+
+    if (!pool_saturated(dev))
+    {
+      selected = order[i];
+    }
+  }
+
+  // every stick is saturated, queue at the first one which is up
+  if (selected < 0)
+  {
+    selected = fallback;
+  }
+
+  if (selected < 0)
+  {
+    return -1;
+  }
+
+  if (selected != order[0])
+  {
+    __atomic_add_fetch(conbee_link_up(pool->members[order[0]].dev) ? &pool->spills : &pool->failovers, 1, __ATOMIC_RELAXED);
+  }
+  __atomic_add_fetch(&pool->members[selected].routed, 1, __ATOMIC_RELAXED);
+
+  return selected;
+}
+
+/**
+* @brief initialize an empty pool
+*
+* @param pool - the pool
+*/
+void conbee_pool_init(struct conbee_pool *pool)
+{
+  memset(pool->members, 0, sizeof(pool->members));
+  pool->nr_members  = 0;
+  pool->failovers   = 0;
+  pool->spills      = 0;
+  pthread_rwlock_init(&pool->lock, NULL);
+}
+
+/**
+* @brief free a pool, the devices are neither closed nor freed
+*
+* @param pool - the pool
+*/
+void conbee_pool_free(struct conbee_pool *pool)
+{
+  pthread_rwlock_destroy(&pool->lock);
+}
+
+/**
+* @brief add a device to a pool
+*
+* @param pool - the pool
+* @param dev  - the device, make sure it is already connected and stays valid while it is part of the pool
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+*/
+int32_t conbee_pool_add(struct conbee_pool *pool, struct conbee_device *dev)
+{
+  int32_t err = 0;
+
+  pthread_rwlock_wrlock(&pool->lock);
+
+  for(uint32_t i = 0; i < pool->nr_members; i++)
+  {
+    if (pool->members[i].dev == dev)
+    {
+      errno = EEXIST;
+      err   = -1;
+    }
+  }
+
+  if (err == 0 && pool->nr_members == POOL_MAX_DEVICES)
+  {
+    errno = ENOSPC;
+    err   = -1;
+  }
+
+  if (err == 0)
+  {
+    pool->members[pool->nr_members].dev     = dev;
+    pool->members[pool->nr_members].seed    = pool_seed(dev);
+    pool->members[pool->nr_members].routed  = 0;
+    pool->nr_members++;
+  }
+
+  pthread_rwlock_unlock(&pool->lock);
+
+  return err;
+}
+
+/**
+* @brief remove a device from a pool, its destinations move to the other devices
+*
+* @param pool - the pool
+* @param dev  - the device
+*
+* @return   0 - device removed
+* @return  -1 - the device is no member of the pool
+*/
+int32_t conbee_pool_remove(struct conbee_pool *pool, struct conbee_device *dev)
+{
+  int32_t err = -1;
+
+  pthread_rwlock_wrlock(&pool->lock);
+
+  for(uint32_t i = 0; i < pool->nr_members; i++)
+  {
+    if (pool->members[i].dev == dev)
+    {
+      pool->members[i] = pool->members[--pool->nr_members];
+      err              = 0;
+      break;
+    }
+  }
+
+  pthread_rwlock_unlock(&pool->lock);
+
+  return err;
+}
+
+/**
+* @brief return the device of the pool the requests to a destination are sent with
+*
+* @param pool - the pool
+* @param dst  - the destination
+*
+* @return the device, NULL if no device of the pool is up
+*/
+struct conbee_device * conbee_pool_select(struct conbee_pool *pool, struct conbee_aps_address *dst)
+{
+  struct conbee_device *dev = NULL;
+
+  pthread_rwlock_rdlock(&pool->lock);
+
+  int32_t selected = pool_route(pool, dst);
+  if (selected >= 0)
+  {
+    dev = pool->members[selected].dev;
+  }
+
+  pthread_rwlock_unlock(&pool->lock);
+
+  return dev;
+}
+
+/**
+* @brief send an aps data request with the device responsible for its destination
+*
+* @param pool    - the pool
+* @param request - the request, its destination selects the device
+* @param dev     - receives the device the request has been sent with, wait for the response there
+*
+* @return >=0 - the sequence number of the request
+* @return  -1 - error occured, use errno to find out what
+*/
+int32_t conbee_pool_send(struct conbee_pool *pool, struct conbee_aps_request *request, struct conbee_device **dev)
+{
+  struct conbee_frame *frame = conbee_aps_data_request(request);
+
+  if (frame == NULL)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  *dev = conbee_pool_select(pool, &request->dst);
+  if (*dev == NULL)
+  {
+    conbee_free_frame(frame);
+    errno = ENODEV;
+    return -1;
+  }
+
+  return conbee_enqueue_frame(*dev, frame);
+}
+
+/**
+* @brief send the same aps data request to many destinations, spread over the devices of the pool
+*
+* the destinations of every device are sent with one conbee_aps_send_many call, so every
+* stick gets its requests as one burst. If sending fails with one of the devices, the bursts
+* of the devices before it are already enqueued. devices[i] is NULL for every destination
+* which has not been sent, wait for the responses of the others.
+*
+* @param pool             - the pool
+* @param request          - the request template
+* @param destinations     - array of n destinations, all with the same address mode
+* @param n                - the number of destinations
+* @param devices          - array receiving the device used for each destination, NULL if it has not been sent
+* @param sequence_numbers - array receiving the sequence number used for each destination
+*
+* @return   0 - everything went fine, all requests are enqueued
+* @return  -1 - error occured, use errno to find out what
+*/
+int32_t conbee_pool_send_many(struct conbee_pool *pool, struct conbee_aps_request *request, struct conbee_aps_address *destinations,
+                              uint16_t n, struct conbee_device **devices, uint8_t *sequence_numbers)
+{
+  struct conbee_aps_address *batch = malloc(n * sizeof(struct conbee_aps_address));
+  uint16_t *indices                = malloc(n * sizeof(uint16_t));
+  int32_t *selected                = malloc(n * sizeof(int32_t));
+  uint8_t batch_sequence_numbers[255];
+  int32_t err                      = 0;
+
+  for(uint16_t i = 0; i < n; i++)
+  {
+    devices[i] = NULL;
+  }
+
+  if (batch == NULL || indices == NULL || selected == NULL)
+  {
+    free(batch);
+    free(indices);
+    free(selected);
+    return -1;
+  }
+
+  pthread_rwlock_rdlock(&pool->lock);
+
+  for(uint16_t i = 0; i < n && err == 0; i++)
+  {
+    selected[i] = pool_route(pool, &destinations[i]);
+    if (selected[i] < 0)
+    {
+      errno = ENODEV;
+      err   = -1;
+    }
+  }
+
+  for(uint32_t member = 0; member < pool->nr_members && err == 0; member++)
+  {
+    uint16_t count = 0;
+
+    for(uint16_t i = 0; i < n; i++)
+    {
+      if (selected[i] == (int32_t) member)
+      {
+        batch[count]   = destinations[i];
+        indices[count] = i;
+        count++;
+      }
+    }
+
+    // at most 255 requests per burst, every one needs its own sequence number
+    for(uint16_t first = 0; first < count && err == 0; first += 255)
+    {
+      uint16_t burst = count - first < 255 ? count - first : 255;
+
+      err = conbee_aps_send_many(pool->members[member].dev, request, &batch[first], burst, batch_sequence_numbers);
+      if (err == -2)
+      {
+        errno = ENOTCONN;
+      }
+      for(uint16_t i = 0; i < burst && err == 0; i++)
+      {
+        devices[indices[first + i]]          = pool->members[member].dev;
+        sequence_numbers[indices[first + i]] = batch_sequence_numbers[i];
+      }
+    }
+  }
+
+  pthread_rwlock_unlock(&pool->lock);
+
+  free(batch);
+  free(indices);
+  free(selected);
+
+  return err < 0 ? -1 : 0;
+}
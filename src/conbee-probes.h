@@ -0,0 +1,62 @@
+#ifndef __CONNBEE_PROBES_H__
+#define __CONNBEE_PROBES_H__
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file */
+
+/*
+* USDT probes of the provider libconbee, e.g. for bpftrace:
+*
+*   bpftrace -e 'usdt:/usr/lib/libconbee.so:libconbee:frame__receive { @[arg0] = count(); }'
+*
+* a probe not attached to is a single nop instruction. The probes are only compiled in if
+* CONBEE_USDT is defined, the build system does so if sys/sdt.h is available.
+*
+* frame probes carry (command, sequence number, length, status)
+*/
+#ifdef CONBEE_USDT
+
+#include <sys/sdt.h>
+
+/// probe without arguments
+#define CONBEE_PROBE(name)                    DTRACE_PROBE(libconbee, name)
+
+/// probe with one argument
+#define CONBEE_PROBE1(name, a)                DTRACE_PROBE1(libconbee, name, a)
+
+/// probe with two arguments
+#define CONBEE_PROBE2(name, a, b)             DTRACE_PROBE2(libconbee, name, a, b)
+
+/// probe with three arguments
+#define CONBEE_PROBE3(name, a, b, c)          DTRACE_PROBE3(libconbee, name, a, b, c)
+
+/// probe with the command, sequence number, length and status of a frame
+#define CONBEE_PROBE_FRAME(name, frame)       DTRACE_PROBE4(libconbee, name, (frame)->command, (frame)->sequence_number, \
+                                                            (frame)->length, (frame)->status)
+
+#else
+
+#define CONBEE_PROBE(name)                    do {} while(0)
+#define CONBEE_PROBE1(name, a)                do {} while(0)
+#define CONBEE_PROBE2(name, a, b)             do {} while(0)
+#define CONBEE_PROBE3(name, a, b, c)          do {} while(0)
+#define CONBEE_PROBE_FRAME(name, frame)       do {} while(0)
+
+#endif
+
+#endif
@@ -35,7 +35,7 @@ void conbee_queue_init(struct conbee_queue_root* queue){
 * @param contents - the content to enqueue
 */
 void conbee_queue_push(struct conbee_queue_root* queue, void *content){
-	struct conbee_queue_item *item = malloc(sizeof(item));
+	struct conbee_queue_item *item = malloc(sizeof(struct conbee_queue_item));
 	item->contents = content;
 	item->next     = NULL;
   item->previous = NULL;
@@ -48,6 +48,25 @@ void conbee_queue_push(struct conbee_queue_root* queue, void *content){
 	}
 }
 
+/**
+* @brief push contents to the front of the queue, it is popped next
+*
+* @param queue - pointer to the head of the queue
+* @param contents - the content to enqueue
+*/
+void conbee_queue_push_front(struct conbee_queue_root* queue, void *content){
+	struct conbee_queue_item *item = malloc(sizeof(struct conbee_queue_item));
+	item->contents = content;
+	item->next     = queue->head;
+  item->previous = NULL;
+
+	if (queue->head == NULL){
+		queue->head = queue->tail = item;
+	} else {
+		queue->head = queue->head->previous = item;
+	}
+}
+
 /**
 * @brief pop content from the queue
 *
@@ -66,6 +85,8 @@ void * conbee_queue_pop(struct conbee_queue_root* queue){
 		queue->head = next;
 		if (queue->head == NULL)
 			queue->tail = NULL;
+		else
+			queue->head->previous = NULL;
 	}
 	return popped;
 }
@@ -88,5 +109,14 @@ void conbee_queue_delete(struct conbee_queue_root *queue, struct conbee_queue_it
   {
     item->previous->next=item->next;
   }
+
+  if (item->next == NULL)
+  {
+    queue->tail = item->previous;
+  }
+  else
+  {
+    item->next->previous=item->previous;
+  }
   free(item);
 }
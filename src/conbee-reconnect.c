@@ -0,0 +1,402 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <conbee.h>
+#include <conbee-internal.h>
+#include <conbee-queue.h>
+#include <slip.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/**
+* @brief keep a copy of one slip encoded request, only called by the worker
+*
+* @param dev     - the device
+* @param command - the command of the request
+* @param sequence_number - the sequence number of the request
+* @param bytes   - the encoded request without its END bytes
+* @param length  - the number of bytes
+* @param now     - the time the request is written
+*/
+static void reconnect_store(struct conbee_device *dev, uint8_t command, uint8_t sequence_number, uint8_t *bytes, uint32_t length, uint64_t now)
+{
+  struct conbee_reconnect *reconnect = &dev->reconnect;
+
+  // a request never answered is replaced by the next one with the same sequence number
+  free(reconnect->inflight[sequence_number]);
+
+  uint8_t *copy = malloc(length + 2);
+  reconnect->inflight[sequence_number] = copy;
+  if (copy == NULL)
+  {
+    return;
+  }
+
+  copy[0] = END;
+  memcpy(&copy[1], bytes, length);
+  copy[length + 1] = END;
+
+  reconnect->inflight_length[sequence_number]  = length + 2;
+  reconnect->inflight_command[sequence_number] = command;
+  reconnect->inflight_us[sequence_number]      = now;
+}
+
+/**
+* @brief drop the copy of a request
+*/
+static void reconnect_drop(struct conbee_reconnect *reconnect, uint8_t sequence_number)
+{
+  free(reconnect->inflight[sequence_number]);
+  reconnect->inflight[sequence_number] = NULL;
+}
+
+/**
+* @brief answer a request with a frame of status STATUS_ERROR, so its waiter does not hang
+*/
+static void reconnect_fail(struct conbee_device *dev, uint8_t command, uint8_t sequence_number)
+{
+  struct conbee_frame *frame = conbee_init_frame();
+
+  frame->command          = command;
+  frame->sequence_number  = sequence_number;
+  frame->status           = STATUS_ERROR;
+  frame->length           = 5;
+
+  pthread_mutex_lock(&dev->mutex_receive_queue);
+  conbee_queue_push(&dev->receive_queue, (void*) frame);
+  conbee_stats_queue_depth(&dev->stats.receive_queue_depth, &dev->stats.receive_queue_high_water, 1);
+  pthread_cond_broadcast(&dev->cond_receive_queue);
+  pthread_mutex_unlock(&dev->mutex_receive_queue);
+}
+
+/**
+* @brief return the reconnect policy of a device
+*/
+static uint8_t reconnect_policy(struct conbee_device *dev, uint32_t *interval_ms)
+{
+  uint8_t policy;
+
+  pthread_mutex_lock(&dev->reconnect.mutex);
+  policy = dev->reconnect.policy;
+  if (interval_ms != NULL)
+  {
+    *interval_ms = dev->reconnect.interval_ms;
+  }
+  pthread_mutex_unlock(&dev->reconnect.mutex);
+
+  return policy;
+}
+
+/**
+* @brief let the worker reopen the transport once it fails, e.g. after the stick was unplugged
+*
+* the worker closes the failed transport and tries to open the address given to conbee_connect
+* again every interval_ms, a tty gets its attributes set up again. Use a stable path like
+* /dev/serial/by-id/... for a tty, the stick may come back with another number. Frames enqueued
+* while the link is down stay in the send queue and are written once it is up again.
+*
+* requests written but not answered before the link went down are written again with
+* RECONNECT_RETRY or answered with a frame of status STATUS_ERROR with RECONNECT_FAIL, so
+* their waiters do not hang. Requests older than RECONNECT_MAX_AGE_MS are answered with
+* STATUS_ERROR with both policies.
+* Reconnects are not supported by the loopback and replay transports.
+*
+* @param dev         - the device, make sure it is already connected
+* @param interval_ms - time between two attempts to reopen the transport in milliseconds
+* @param policy      - RECONNECT_RETRY, RECONNECT_FAIL or RECONNECT_DISABLED to stop reconnecting
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+* @return  -2 - conbee device is not connected
+*/
+int32_t conbee_enable_reconnect(struct conbee_device *dev, uint32_t interval_ms, uint8_t policy)
+{
+  if (dev->tty_status == TTY_DISCONNECTED)
+  {
+    return -2;
+  }
+
+  if (policy > RECONNECT_FAIL || (policy != RECONNECT_DISABLED && interval_ms == 0))
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  // reopening would start a new loopback or replay instead of resuming the old one
+  if (policy != RECONNECT_DISABLED &&
+      (dev->transport.ops == &conbee_transport_loopback || dev->transport.ops == &conbee_transport_replay))
+  {
+    errno = EOPNOTSUPP;
+    return -1;
+  }
+
+  pthread_mutex_lock(&dev->reconnect.mutex);
+  dev->reconnect.policy       = policy;
+  dev->reconnect.interval_ms  = interval_ms;
+  pthread_mutex_unlock(&dev->reconnect.mutex);
+
+  return 0;
+}
+
+/**
+* @brief check if the worker reopens the transport once it fails
+*
+* @param dev - the device
+*
+* @return 1 - reconnecting is enabled
+* @return 0 - reconnecting is disabled
+*/
+uint8_t conbee_reconnect_enabled(struct conbee_device *dev)
+{
+  return reconnect_policy(dev, NULL) != RECONNECT_DISABLED;
+}
+
+/**
+* @brief keep a copy of the requests about to be written to the stick, only called by the worker
+*
+* @param dev   - the device
+* @param iov   - the slip encoded bytes of every frame, may contain many frames each
+* @param count - the number of buffers
+*/
+void conbee_reconnect_record(struct conbee_device *dev, struct iovec *iov, int count)
+{
+  uint64_t now = conbee_now_us();
+
+  if (!conbee_reconnect_enabled(dev))
+  {
+    return;
+  }
+
+  for(int i = 0; i < count; i++)
+  {
+    uint8_t *bytes  = (uint8_t *) iov[i].iov_base;
+    uint32_t start  = 0;
+    uint32_t index  = 0;
+    uint8_t escaped = 0;
+    uint8_t command = 0;
+    uint8_t sequence_number = 0;
+
+    // pre-encoded buffers contain many frames, split them at the END bytes
+    for(uint32_t j = 0; j < iov[i].iov_len; j++)
+    {
+      uint8_t c = bytes[j];
+
+      if (c == END)
+      {
+        if (index > 0)
+        {
+          reconnect_store(dev, command, sequence_number, &bytes[start], j - start, now);
+        }
+        start = j + 1;
+        index = 0;
+        continue;
+      }
+
+      if (c == ESC && !escaped)
+      {
+        escaped = 1;
+        continue;
+      }
+
+      if (escaped)
+      {
+        c       = c == ESC_END ? END : ESC;
+        escaped = 0;
+      }
+
+      if (index == 0)
+      {
+        command = c;
+      }
+      else if (index == 1)
+      {
+        sequence_number = c;
+      }
+      index++;
+    }
+  }
+}
+
+/**
+* @brief drop the copy of the request a received frame answers, only called by the worker
+*
+* @param dev   - the device
+* @param frame - the received frame
+*/
+void conbee_reconnect_response(struct conbee_device *dev, struct conbee_frame *frame)
+{
+  struct conbee_reconnect *reconnect = &dev->reconnect;
+
+  if (reconnect->inflight[frame->sequence_number] != NULL &&
+      reconnect->inflight_command[frame->sequence_number] == frame->command)
+  {
+    reconnect_drop(reconnect, frame->sequence_number);
+  }
+}
+
+/**
+* @brief close the failed transport and handle the unanswered requests, only called by the worker
+*
+* @param dev - the device
+*/
+void conbee_reconnect_link_down(struct conbee_device *dev)
+{
+  struct conbee_reconnect *reconnect = &dev->reconnect;
+  uint32_t interval_ms;
+  uint32_t failed = 0;
+  uint64_t now    = conbee_now_us();
+  uint8_t policy  = reconnect_policy(dev, &interval_ms);
+
+  if (policy == RECONNECT_DISABLED)
+  {
+    return;
+  }
+
+  dev->transport.ops->close(&dev->transport);
+  dev->fd = -1;
+
+  reconnect->down_us          = now;
+  reconnect->next_attempt_us  = now + ((uint64_t) interval_ms) * 1000;
+
+  for(uint32_t i = 0; i < 256; i++)
+  {
+    if (reconnect->inflight[i] == NULL)
+    {
+      continue;
+    }
+
+    // requests too old to be written again are failed as well, their waiters would hang otherwise
+    if (policy == RECONNECT_FAIL || now - reconnect->inflight_us[i] > RECONNECT_MAX_AGE_MS * 1000ULL)
+    {
+      reconnect_fail(dev, reconnect->inflight_command[i], i);
+      reconnect_drop(reconnect, i);
+      failed++;
+    }
+  }
+
+  if (failed > 0)
+  {
+    conbee_stats_requests_resolved(dev, 0, failed);
+  }
+}
+
+/**
+* @brief try to reopen the transport if an attempt is due, only called by the worker
+*
+* @param dev     - the device
+* @param decoder - the slip decoder of the device, reset after reopening
+*
+* @return   0 - the transport has been reopened
+* @return  -1 - the link is still down
+*/
+int32_t conbee_reconnect_poll(struct conbee_device *dev, struct slip_decoder *decoder)
+{
+  struct conbee_reconnect *reconnect = &dev->reconnect;
+  struct iovec iov[256];
+  uint32_t interval_ms;
+  int count       = 0;
+  uint64_t now    = conbee_now_us();
+  uint8_t policy  = reconnect_policy(dev, &interval_ms);
+  const char *address = dev->tty;
+
+  if (policy == RECONNECT_DISABLED)
+  {
+    return -1;
+  }
+
+  // reconnecting has been enabled after the link went down
+  if (reconnect->down_us == 0)
+  {
+    conbee_reconnect_link_down(dev);
+    return -1;
+  }
+
+  if (now < reconnect->next_attempt_us)
+  {
+    return -1;
+  }
+
+  const struct conbee_transport_ops *ops = dev->transport.ops;
+  if (ops->prefix != NULL && strncmp(address, ops->prefix, strlen(ops->prefix)) == 0)
+  {
+    address += strlen(ops->prefix);
+  }
+
+  int32_t err = ops->open(&dev->transport, address);
+  conbee_stats_reconnect(dev, err, now - reconnect->down_us);
+  if (err < 0)
+  {
+    reconnect->next_attempt_us = now + ((uint64_t) interval_ms) * 1000;
+    return -1;
+  }
+
+  dev->fd = ops->fd(&dev->transport);
+  slip_decoder_init(decoder, decoder->packet, decoder->size);
+  reconnect->down_us = 0;
+
+  // the stick may have been reset while it was gone
+  conbee_invalidate_parameter_cache(dev);
+
+  if (policy != RECONNECT_RETRY)
+  {
+    return 0;
+  }
+
+  // the oldest request has the sequence number following the last reserved one
+  uint8_t first = conbee_reserve_sequence_numbers(dev, 0);
+  for(uint32_t i = 0; i < 256; i++)
+  {
+    uint8_t sequence_number = first + i;
+
+    if (reconnect->inflight[sequence_number] != NULL)
+    {
+      iov[count].iov_base = reconnect->inflight[sequence_number];
+      iov[count].iov_len  = reconnect->inflight_length[sequence_number];
+      count++;
+    }
+  }
+
+  if (count == 0)
+  {
+    return 0;
+  }
+
+  conbee_stats_requests_resolved(dev, count, 0);
+
+  if (conbee_write_iov(dev, iov, count) < 0)
+  {
+    conbee_reconnect_link_down(dev);
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+* @brief free the copies of the unanswered requests, the worker has to be stopped already
+*
+* @param dev - the device
+*/
+void conbee_reconnect_free(struct conbee_device *dev)
+{
+  for(uint32_t i = 0; i < 256; i++)
+  {
+    reconnect_drop(&dev->reconnect, i);
+  }
+}
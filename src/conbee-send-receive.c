@@ -24,6 +24,378 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <sys/select.h>
+#include <sys/uio.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <slip.h>
+#include <conbee-probes.h>
+
+/// number of bytes read from the transport at once
+#define RECEIVE_CHUNK_SIZE      512
+
+/// maximum number of frames written with one writev
+#define TRANSMIT_BATCH          64
+
+/// buffer for encoding the frames of one writev
+#define TRANSMIT_ARENA_SIZE     (8 * CONBEE_FRAME_MAX_ENCODED)
+
+/**
+* @brief look at the device state carried by a received frame
+*
+* @param dev   - the device the frame was received from
+* @param frame - the received frame
+*/
+static void conbee_handle_device_state(struct conbee_device *dev, struct conbee_frame *frame)
+{
+  uint8_t state_byte;
+  struct conbee_device_state state;
+
+  if (conbee_device_state_byte(frame, &state_byte) < 0)
+  {
+    return;
+  }
+
+  conbee_device_state_decode(state_byte, &state);
+
+  // cached parameters may be stale now
+  if (state.configuration_changed)
+  {
+    conbee_invalidate_parameter_cache(dev);
+  }
+
+  conbee_device_state_update(dev, state_byte);
+}
+
+/**
+* @brief set a function taking every received frame before it is queued
+*
+* the subscriber is called by the worker for every received frame except the responses
+* to watchdog refreshes. If it returns 1 it owns the frame and the frame is not queued,
+* so it is never returned by conbee_wait_for_frame. It must not block, the worker does
+* not read or write while the subscriber runs. The subscriber may replace or remove itself.
+* When this function returns the old subscriber is not called anymore, unless this function
+* is called from the subscriber itself.
+*
+* @param dev      - the device, make sure it is already connected
+* @param cb       - the function to call or NULL to remove the subscriber
+* @param userdata - pointer handed to the subscriber
+*/
+void conbee_set_frame_subscriber(struct conbee_device *dev,
+                                 int32_t (*cb)(struct conbee_device *dev, struct conbee_frame *frame, void *userdata),
+                                 void *userdata)
+{
+  pthread_mutex_lock(&dev->mutex_subscriber);
+  dev->subscriber_cb        = cb;
+  dev->subscriber_userdata  = userdata;
+
+  // wait for a running call of the old subscriber, unless it is the caller itself
+  while(dev->subscriber_running && !pthread_equal(pthread_self(), dev->worker))
+  {
+    pthread_cond_wait(&dev->cond_subscriber, &dev->mutex_subscriber);
+  }
+  pthread_mutex_unlock(&dev->mutex_subscriber);
+}
+
+/**
+* @brief restrict the frames offered to the subscriber
+*
+* the worker checks the filter before calling the subscriber, frames not passing it take
+* the normal way as if no subscriber is set. The cluster is only checked for aps data
+* indications, frames of all other accepted commands pass regardless of it.
+*
+* @param dev         - the device, make sure it is already connected
+* @param commands    - array of the accepted commands, NULL to accept all commands
+* @param nr_commands - the number of commands within the array
+* @param cluster     - the accepted cluster of aps data indications or APS_MATCH_ANY
+*
+* @return   0 - everything went fine
+* @return  -1 - the cluster is out of range, errno is set to EINVAL
+*/
+int32_t conbee_set_frame_subscriber_filter(struct conbee_device *dev, const uint8_t *commands, uint16_t nr_commands, int32_t cluster)
+{
+  uint8_t bitmap[sizeof(dev->subscriber_commands)];
+
+  if (cluster != APS_MATCH_ANY && (cluster < 0 || cluster > 0xFFFF))
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  memset(bitmap, commands == NULL ? 0xFF : 0, sizeof(bitmap));
+  for(uint16_t i = 0; commands != NULL && i < nr_commands; i++)
+  {
+    bitmap[commands[i] / 8] |= 1 << (commands[i] % 8);
+  }
+
+  pthread_mutex_lock(&dev->mutex_subscriber);
+  memcpy(dev->subscriber_commands, bitmap, sizeof(bitmap));
+  dev->subscriber_cluster = cluster;
+  pthread_mutex_unlock(&dev->mutex_subscriber);
+
+  return 0;
+}
+
+/**
+* @brief check if a frame passes the subscriber filter, call with mutex_subscriber held
+*/
+static uint8_t conbee_subscriber_accepts(struct conbee_device *dev, struct conbee_frame *frame)
+{
+  struct conbee_aps_indication indication;
+
+  if (!(dev->subscriber_commands[frame->command / 8] & (1 << (frame->command % 8))))
+  {
+    return 0;
+  }
+
+  if (dev->subscriber_cluster == APS_MATCH_ANY || frame->command != COMMAND_APS_DATA_INDICATION)
+  {
+    return 1;
+  }
+
+  return conbee_aps_indication_response(frame, &indication) == 0 && indication.cluster_id == dev->subscriber_cluster;
+}
+
+/**
+* @brief offer a received frame to the subscriber
+*
+* @return 1 - the subscriber took the frame
+* @return 0 - the frame is still owned by the caller
+*/
+static int32_t conbee_offer_frame(struct conbee_device *dev, struct conbee_frame *frame)
+{
+  int32_t (*cb)(struct conbee_device *, struct conbee_frame *, void *) = NULL;
+  void *userdata = NULL;
+  int32_t taken  = 0;
+
+  pthread_mutex_lock(&dev->mutex_subscriber);
+  if (dev->subscriber_cb != NULL && conbee_subscriber_accepts(dev, frame))
+  {
+    cb                      = dev->subscriber_cb;
+    userdata                = dev->subscriber_userdata;
+    dev->subscriber_running = 1;
+  }
+  pthread_mutex_unlock(&dev->mutex_subscriber);
+
+  if (cb == NULL)
+  {
+    return 0;
+  }
+
+  // call the subscriber without holding the lock, so it may set another subscriber itself
+  taken = cb(dev, frame, userdata) == 1;
+
+  pthread_mutex_lock(&dev->mutex_subscriber);
+  dev->subscriber_running = 0;
+  pthread_cond_broadcast(&dev->cond_subscriber);
+  pthread_mutex_unlock(&dev->mutex_subscriber);
+
+  return taken;
+}
+
+/**
+* @brief hand a received frame to whoever is interested in it
+*
+* @param dev   - the device the frame was received from
+* @param frame - the received frame, owned by the function
+*/
+static void conbee_handle_frame(struct conbee_device *dev, struct conbee_frame *frame)
+{
+  conbee_handle_device_state(dev, frame);
+
+  // responses to watchdog refreshes are consumed by the worker itself
+  if (conbee_watchdog_response(dev, frame))
+  {
+    return;
+  }
+
+  if (conbee_offer_frame(dev, frame))
+  {
+    return;
+  }
+
+  // state change notifications are answers to nobody, they are fully handled by now
+  if (frame->command == COMMAND_DEVICE_STATE_CHANGED)
+  {
+    conbee_free_frame(frame);
+    return;
+  }
+
+  pthread_mutex_lock(&dev->mutex_receive_queue);
+  conbee_queue_push(&dev->receive_queue, (void*) frame);
+  conbee_stats_queue_depth(&dev->stats.receive_queue_depth, &dev->stats.receive_queue_high_water, 1);
+  pthread_cond_broadcast(&dev->cond_receive_queue);
+  pthread_mutex_unlock(&dev->mutex_receive_queue);
+}
+
+/**
+* @brief read what the transport has available and handle all completed frames
+*
+* @param dev         - the device to read from
+* @param decoder     - the slip decoder of the device, keeps partial frames between calls
+* @param received_ns - the time the first bytes of the current packet were read, kept between calls
+*
+* @return   0 - everything went fine
+* @return  -1 - the transport failed or has been closed
+*/
+static int32_t conbee_receive(struct conbee_device *dev, struct slip_decoder *decoder, uint64_t *received_ns)
+{
+  uint8_t chunk[RECEIVE_CHUNK_SIZE];
+  ssize_t length = dev->transport.ops->read(&dev->transport, chunk, sizeof(chunk));
+  uint64_t read_ns = conbee_timestamp(dev);
+
+  if (length <= 0)
+  {
+    fprintf(stderr,"error: reading from %s failed (%s)\n", dev->tty, length == 0 ? "connection closed" : strerror (errno));
+    return -1;
+  }
+
+  conbee_wire_trace_record(dev, CONBEE_TRACE_RX, chunk, length);
+  conbee_capture_record(dev, CONBEE_TRACE_RX, chunk, length);
+
+  uint32_t offset = 0;
+  while(offset < (uint32_t) length)
+  {
+    uint32_t packet_length = 0;
+
+    // a new packet starts within this chunk
+    if (decoder->received == 0 || decoder->complete)
+    {
+      *received_ns = read_ns;
+    }
+
+    offset += slip_decode(decoder, &chunk[offset], length - offset, &packet_length);
+
+    if (packet_length > 0)
+    {
+      struct conbee_frame *frame = conbee_init_frame();
+
+      uint32_t escapes = decoder->escapes;
+
+      decoder->escapes = 0;
+
+      if (conbee_decode_frame(dev, decoder->packet, packet_length, frame) < 0)
+      {
+        CONBEE_PROBE1(frame__invalid, packet_length);
+        conbee_stats_checksum_failure(dev);
+        conbee_free_frame(frame);
+        continue;
+      }
+
+      // the packet plus its escape bytes and the END byte, leading END bytes are line noise
+      conbee_stats_received(dev, frame, packet_length + escapes + 1, escapes);
+      conbee_timestamps_received(dev, frame, *received_ns);
+      conbee_reconnect_response(dev, frame);
+      CONBEE_PROBE_FRAME(frame__receive, frame);
+      conbee_handle_frame(dev, frame);
+    }
+  }
+
+  return 0;
+}
+
+/**
+* @brief write all queued frames with as few writes as possible
+*
+* @param dev - the device to write to
+*
+* @return   0 - everything went fine
+* @return  -1 - writing failed, the frames of the failed write are lost unless reconnecting retries them
+*/
+static int32_t conbee_transmit(struct conbee_device *dev)
+{
+  struct iovec iov[TRANSMIT_BATCH];
+  struct conbee_frame *batch[TRANSMIT_BATCH];
+  uint8_t arena[TRANSMIT_ARENA_SIZE];
+  uint32_t used  = 0;
+  int count      = 0;
+  int32_t err    = 0;
+  uint8_t keep   = conbee_reconnect_enabled(dev);
+
+  // send all queued frames back to back, pipelined requests depend on it
+  while(1)
+  {
+    pthread_mutex_lock(&dev->mutex_send_queue);
+    struct conbee_frame *frame = (struct conbee_frame*) conbee_queue_pop(&dev->send_queue);
+    if (frame != NULL)
+    {
+      conbee_stats_queue_depth(&dev->stats.send_queue_depth, &dev->stats.send_queue_high_water, -1);
+      frame->timestamps.dequeued_ns = conbee_timestamp(dev);
+    }
+    pthread_mutex_unlock(&dev->mutex_send_queue);
+
+    // flush the batch if the frame does not fit anymore or nothing is left
+    if (count > 0 && (frame == NULL || count == TRANSMIT_BATCH ||
+                      (frame->wire == NULL && used + CONBEE_FRAME_MAX_ENCODED > sizeof(arena))))
+    {
+      // count before writing, writing modifies the buffers
+      conbee_stats_transmitted(dev, batch, iov, count);
+      conbee_reconnect_record(dev, iov, count);
+      CONBEE_PROBE2(worker__write, count, used);
+
+      if (conbee_write_iov(dev, iov, count) < 0)
+      {
+        conbee_stats_write_failure(dev, batch, count);
+        err = -1;
+      }
+      conbee_timestamps_written(dev, batch, count, conbee_timestamp(dev));
+
+      for(int i = 0; i < count; i++)
+      {
+        conbee_free_frame(batch[i]);
+      }
+
+      count = 0;
+      used  = 0;
+    }
+
+    // keep the remaining frames queued until the link is up again
+    if (frame == NULL || (err < 0 && keep))
+    {
+      if (frame != NULL)
+      {
+        pthread_mutex_lock(&dev->mutex_send_queue);
+        conbee_queue_push_front(&dev->send_queue, (void *) frame);
+        conbee_stats_queue_depth(&dev->stats.send_queue_depth, &dev->stats.send_queue_high_water, 1);
+        pthread_mutex_unlock(&dev->mutex_send_queue);
+      }
+      break;
+    }
+
+    if (frame->wire != NULL)
+    {
+      // the frame has already been encoded, e.g. by conbee_aps_send_many
+      iov[count].iov_base = frame->wire;
+      iov[count].iov_len  = frame->wire_length;
+    }
+    else
+    {
+      iov[count].iov_base = &arena[used];
+      iov[count].iov_len  = conbee_encode_frame(frame, &arena[used]);
+      used               += iov[count].iov_len;
+    }
+
+    CONBEE_PROBE_FRAME(frame__transmit, frame);
+    batch[count++] = frame;
+  }
+
+  return err;
+}
+
+/**
+* @brief mark the link as down after the transport failed
+*
+* @param dev     - the device
+* @param link_up - the link state of the worker
+*/
+static void conbee_link_down(struct conbee_device *dev, uint8_t *link_up)
+{
+  CONBEE_PROBE(worker__link__down);
+  *link_up = 0;
+  __atomic_store_n(&dev->link_up, 0, __ATOMIC_RELEASE);
+
+  conbee_reconnect_link_down(dev);
+}
 
 /**
 * @brief manage the asynchronous reception and transmission of conbee frames
@@ -38,6 +410,13 @@ void *conbee_send_receive(void *arg)
   struct timeval tv;
   int retval = 0;
   int maxfd = 0;
+  uint8_t link_up = 1;
+
+  // frames are received in chunks, partial frames are kept by the decoder
+  uint8_t packet[1500];
+  struct slip_decoder decoder;
+  uint64_t received_ns = 0;
+  slip_decoder_init(&decoder, packet, sizeof(packet));
 
   // signal that the worker is running
   pthread_mutex_lock(&dev->mutex_worker);
@@ -56,17 +435,17 @@ void *conbee_send_receive(void *arg)
 
     // wait for new data on the line from the conbee stick or a transmission request
     FD_ZERO(&rfds);
-    FD_SET(dev->fd, &rfds);
     FD_SET(dev->pipe_send_queue[0], &rfds);
+    maxfd = dev->pipe_send_queue[0];
 
-    // for select we require the maximum file descriptor
-    if(dev->fd > dev->pipe_send_queue[0])
-    {
-      maxfd=dev->fd;
-    }
-    else
+    // a closed transport would be readable forever
+    if (link_up)
     {
-      maxfd = dev->pipe_send_queue[0];
+      FD_SET(dev->fd, &rfds);
+      if(dev->fd > maxfd)
+      {
+        maxfd=dev->fd;
+      }
     }
 
     // we wait for 1000 usecs
@@ -75,42 +454,47 @@ void *conbee_send_receive(void *arg)
 
     retval = select(maxfd+1, &rfds, NULL, NULL, &tv);
 
+    // the timeout above bounds the delay of a due watchdog refresh
+    conbee_watchdog_poll(dev);
+
     // if data is available
-    if (retval)
+    if (retval > 0)
     {
-      if (FD_ISSET(dev->fd, &rfds))
+      if (link_up && FD_ISSET(dev->fd, &rfds))
       {
-        // a frame from the conbee stick
-        struct conbee_frame *frame = conbee_init_frame();
-        retval=conbee_read_frame(dev, frame);
-
-        //todo: check retval
-        pthread_mutex_lock(&dev->mutex_receive_queue);
-        conbee_queue_push(&dev->receive_queue, (void*) frame);
-        pthread_cond_signal(&dev->cond_receive_queue);
-        pthread_mutex_unlock(&dev->mutex_receive_queue);
-
+        if (conbee_receive(dev, &decoder, &received_ns) < 0)
+        {
+          conbee_link_down(dev, &link_up);
+        }
       }
-      else
+
+      if (FD_ISSET(dev->pipe_send_queue[0], &rfds))
       {
-        // a frame to send
-        // first clear the pipe
-        uint8_t buf[2];
-        read(dev->pipe_send_queue[0], buf, 2);
+        // first clear the pipe, one wakeup may stand for many enqueued frames
+        uint8_t buf[64];
+        read(dev->pipe_send_queue[0], buf, sizeof(buf));
 
-        // get the frame and send
-        pthread_mutex_lock(&dev->mutex_send_queue);
-        struct conbee_frame *frame = (struct conbee_frame*) conbee_queue_pop(&dev->send_queue);
-        pthread_mutex_unlock(&dev->mutex_send_queue);
-        if (frame != NULL)
+        // while reconnecting the frames stay queued
+        if ((link_up || !conbee_reconnect_enabled(dev)) && conbee_transmit(dev) < 0 && link_up)
         {
-          retval=conbee_write_frame(dev, frame);
-          // TODO: check retval
-          conbee_free_frame(frame);
+          conbee_link_down(dev, &link_up);
         }
       }
     }
 
+    // resume with the frames queued while the link was down
+    if (!link_up && conbee_reconnect_poll(dev, &decoder) == 0)
+    {
+      CONBEE_PROBE(worker__link__up);
+      link_up = 1;
+      __atomic_store_n(&dev->link_up, 1, __ATOMIC_RELEASE);
+
+      if (conbee_transmit(dev) < 0)
+      {
+        conbee_link_down(dev, &link_up);
+      }
+    }
+
   }
 
   pthread_mutex_lock(&dev->mutex_worker);
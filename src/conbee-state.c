@@ -0,0 +1,125 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <conbee.h>
+#include <conbee-internal.h>
+
+/**
+* @brief return the device state last reported by the stick without asking the stick
+*
+* @param dev   - the device, make sure it is already connected
+* @param state - pointer to the state to save the state in
+*
+* @return   0 - everything worked fine
+* @return  -1 - the stick did not report its state yet
+*/
+int32_t conbee_device_state_snapshot(struct conbee_device *dev, struct conbee_device_state *state)
+{
+  uint32_t current = __atomic_load_n(&dev->device_state, __ATOMIC_ACQUIRE);
+
+  if (!(current & DEVICE_STATE_KNOWN))
+  {
+    return -1;
+  }
+
+  conbee_device_state_decode(current & 0xFF, state);
+
+  return 0;
+}
+
+/**
+* @brief check if the transport to the stick still works
+*
+* the worker clears the flag as soon as reading from the transport fails, e.g. because
+* the stick has been unplugged. Requests enqueued afterwards are never answered.
+*
+* @param dev - the device
+*
+* @return 1 - the device is connected and its transport works
+* @return 0 - the device is not connected or its transport failed
+*/
+uint8_t conbee_link_up(struct conbee_device *dev)
+{
+  return dev->tty_status == TTY_CONNECTED && __atomic_load_n(&dev->link_up, __ATOMIC_ACQUIRE);
+}
+
+/**
+* @brief set a function called whenever the device state reported by the stick changes
+*
+* the callback is called from the worker thread, so it must not block and must not wait
+* for frames of the same device. It may replace or remove itself. When this function returns
+* the old callback is not running anymore, unless it is called from the callback itself.
+*
+* @param dev      - the device, make sure it is already connected
+* @param cb       - the function to call or NULL to remove the callback
+* @param userdata - pointer handed to the callback
+*/
+void conbee_set_device_state_callback(struct conbee_device *dev,
+                                      void (*cb)(struct conbee_device *dev, struct conbee_device_state *state, void *userdata),
+                                      void *userdata)
+{
+  pthread_mutex_lock(&dev->mutex_device_state_cb);
+  dev->device_state_cb       = cb;
+  dev->device_state_userdata = userdata;
+
+  // wait for a running call of the old callback, unless it is the caller itself
+  while(dev->device_state_cb_running && !pthread_equal(pthread_self(), dev->worker))
+  {
+    pthread_cond_wait(&dev->cond_device_state_cb, &dev->mutex_device_state_cb);
+  }
+  pthread_mutex_unlock(&dev->mutex_device_state_cb);
+}
+
+/**
+* @brief update the tracked device state, only called by the worker
+*
+* @param dev        - the device the state was received from
+* @param state_byte - the device state byte as sent by the stick
+*/
+void conbee_device_state_update(struct conbee_device *dev, uint8_t state_byte)
+{
+  uint32_t current  = DEVICE_STATE_KNOWN | state_byte;
+  uint32_t previous = __atomic_exchange_n(&dev->device_state, current, __ATOMIC_ACQ_REL);
+
+  if (previous == current)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&dev->mutex_device_state_cb);
+  void (*cb)(struct conbee_device *, struct conbee_device_state *, void *) = dev->device_state_cb;
+  void *userdata = dev->device_state_userdata;
+  dev->device_state_cb_running = cb != NULL;
+  pthread_mutex_unlock(&dev->mutex_device_state_cb);
+
+  if (cb == NULL)
+  {
+    return;
+  }
+
+  // call the callback without holding the lock, so it may set another callback itself
+  struct conbee_device_state state;
+
+  conbee_device_state_decode(state_byte, &state);
+  cb(dev, &state, userdata);
+
+  pthread_mutex_lock(&dev->mutex_device_state_cb);
+  dev->device_state_cb_running = 0;
+  pthread_cond_broadcast(&dev->cond_device_state_cb);
+  pthread_mutex_unlock(&dev->mutex_device_state_cb);
+}
@@ -0,0 +1,329 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <conbee.h>
+#include <conbee-internal.h>
+#include <slip.h>
+#include <conbee-probes.h>
+#include <string.h>
+#include <time.h>
+
+/**
+* @brief return the monotonic time in microseconds
+*/
+uint64_t conbee_now_us()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return ((uint64_t) now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+* @brief start updating the counters, makes readers retry until conbee_stats_end
+*/
+static void conbee_stats_begin(struct conbee_stats_state *stats)
+{
+  __atomic_store_n(&stats->sequence, stats->sequence + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+* @brief finish updating the counters
+*/
+static void conbee_stats_end(struct conbee_stats_state *stats)
+{
+  __atomic_store_n(&stats->sequence, stats->sequence + 1, __ATOMIC_RELEASE);
+}
+
+/**
+* @brief count a latency in its log2 bucket
+*/
+static void conbee_stats_histogram(uint64_t *histogram, uint64_t latency_us)
+{
+  uint32_t bucket = latency_us == 0 ? 0 : 64 - __builtin_clzll(latency_us);
+
+  histogram[bucket < STATS_HISTOGRAM_BUCKETS ? bucket : STATS_HISTOGRAM_BUCKETS - 1]++;
+}
+
+/**
+* @brief return the per command counters of a command
+*/
+static struct conbee_command_stats * conbee_stats_command(struct conbee_stats *counters, uint8_t command)
+{
+  return &counters->commands[command < STATS_COMMANDS ? command : 0];
+}
+
+/**
+* @brief change the depth of a queue and track its high-water mark
+*
+* call it while holding the mutex of the queue, readers do not need the mutex
+*
+* @param depth      - the depth counter of the queue
+* @param high_water - the high-water mark of the queue
+* @param delta      - the number of frames added, negative for removed frames
+*/
+void conbee_stats_queue_depth(uint32_t *depth, uint32_t *high_water, int32_t delta)
+{
+  uint32_t current = __atomic_add_fetch(depth, delta, __ATOMIC_RELAXED);
+
+  if (current > __atomic_load_n(high_water, __ATOMIC_RELAXED))
+  {
+    __atomic_store_n(high_water, current, __ATOMIC_RELAXED);
+  }
+}
+
+/**
+* @brief count frames about to be written to the stick, only called by the worker
+*
+* @param dev    - the device
+* @param frames - the frames
+* @param iov    - the slip encoded bytes of every frame, may contain many frames each
+* @param count  - the number of frames and buffers
+*/
+void conbee_stats_transmitted(struct conbee_device *dev, struct conbee_frame **frames, struct iovec *iov, int count)
+{
+  struct conbee_stats_state *stats  = &dev->stats;
+  struct conbee_stats *counters     = &stats->counters;
+  uint64_t now                      = conbee_now_us();
+
+  conbee_stats_begin(stats);
+
+  for(int i = 0; i < count; i++)
+  {
+    uint8_t *bytes  = (uint8_t *) iov[i].iov_base;
+    uint32_t start  = 0;
+    uint32_t index  = 0;
+    uint8_t escaped = 0;
+    uint8_t command = 0;
+    uint8_t sequence_number = 0;
+
+    if (frames[i]->enqueued_us != 0)
+    {
+      conbee_stats_histogram(counters->enqueue_to_wire, now - frames[i]->enqueued_us);
+    }
+
+    // walk the encoded bytes, pre-encoded buffers contain many frames
+    for(uint32_t j = 0; j < iov[i].iov_len; j++)
+    {
+      uint8_t c = bytes[j];
+
+      if (c == END)
+      {
+        if (index > 0)
+        {
+          struct conbee_command_stats *command_stats = conbee_stats_command(counters, command);
+
+          command_stats->tx_frames++;
+          command_stats->tx_bytes += j + 1 - start;
+          counters->tx_frames++;
+          counters->tx_bytes      += j + 1 - start;
+          stats->sent_us[sequence_number] = now;
+        }
+        start = index > 0 ? j + 1 : start;
+        index = 0;
+        continue;
+      }
+
+      if (c == ESC && !escaped)
+      {
+        escaped = 1;
+        counters->tx_escapes++;
+        continue;
+      }
+
+      if (escaped)
+      {
+        c       = c == ESC_END ? END : ESC;
+        escaped = 0;
+      }
+
+      if (index == 0)
+      {
+        command = c;
+      }
+      else if (index == 1)
+      {
+        sequence_number = c;
+      }
+      index++;
+    }
+  }
+
+  conbee_stats_end(stats);
+}
+
+/**
+* @brief count frames whose write to the stick failed, only called by the worker
+*
+* @param dev    - the device
+* @param frames - the frames, pre-encoded frames may contain many frames each
+* @param count  - the number of frames
+*/
+void conbee_stats_write_failure(struct conbee_device *dev, struct conbee_frame **frames, int count)
+{
+  conbee_stats_begin(&dev->stats);
+
+  for(int i = 0; i < count; i++)
+  {
+    dev->stats.counters.tx_failures += frames[i]->wire != NULL ? frames[i]->wire_frames : 1;
+  }
+
+  conbee_stats_end(&dev->stats);
+}
+
+/**
+* @brief count a valid frame received from the stick, only called by the worker
+*
+* @param dev     - the device
+* @param frame   - the received frame
+* @param length  - the number of slip encoded bytes of the frame
+* @param escapes - the number of escaped bytes within the frame
+*/
+void conbee_stats_received(struct conbee_device *dev, struct conbee_frame *frame, uint32_t length, uint32_t escapes)
+{
+  struct conbee_stats_state *stats            = &dev->stats;
+  struct conbee_stats *counters               = &stats->counters;
+  struct conbee_command_stats *command_stats  = conbee_stats_command(counters, frame->command);
+
+  conbee_stats_begin(stats);
+
+  command_stats->rx_frames++;
+  command_stats->rx_bytes   += length;
+  counters->rx_frames++;
+  counters->rx_bytes        += length;
+  counters->rx_escapes      += escapes;
+
+  if (frame->status == STATUS_BUSY)
+  {
+    counters->busy_statuses++;
+  }
+
+  // state change notifications answer no request
+  if (frame->command != COMMAND_DEVICE_STATE_CHANGED)
+  {
+    uint64_t sent = stats->sent_us[frame->sequence_number];
+
+    if (sent == 0)
+    {
+      CONBEE_PROBE2(response__unmatched, frame->command, frame->sequence_number);
+      counters->unmatched_responses++;
+    }
+    else
+    {
+      uint64_t latency_us = conbee_now_us() - sent;
+
+      CONBEE_PROBE3(response__match, frame->command, frame->sequence_number, latency_us);
+      conbee_stats_histogram(counters->request_to_response, latency_us);
+      stats->sent_us[frame->sequence_number] = 0;
+    }
+  }
+
+  conbee_stats_end(stats);
+}
+
+/**
+* @brief count a received frame dropped because of a wrong checksum or length, only called by the worker
+*
+* @param dev - the device
+*/
+void conbee_stats_checksum_failure(struct conbee_device *dev)
+{
+  conbee_stats_begin(&dev->stats);
+  dev->stats.counters.checksum_failures++;
+  conbee_stats_end(&dev->stats);
+}
+
+/**
+* @brief return a consistent snapshot of the statistics of a device
+*
+* taking the snapshot never blocks the worker, it can be polled at any rate
+*
+* @param dev   - the device, make sure it is already connected
+* @param stats - the statistics
+*/
+void conbee_get_stats(struct conbee_device *dev, struct conbee_stats *stats)
+{
+  struct conbee_stats_state *state = &dev->stats;
+  uint32_t sequence;
+
+  // retry while the worker updates the counters
+  do
+  {
+    sequence = __atomic_load_n(&state->sequence, __ATOMIC_ACQUIRE);
+    if (sequence & 1)
+    {
+      continue;
+    }
+
+    memcpy(stats, &state->counters, sizeof(struct conbee_stats));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  }
+  while((sequence & 1) || __atomic_load_n(&state->sequence, __ATOMIC_RELAXED) != sequence);
+
+  stats->send_queue_depth         = __atomic_load_n(&state->send_queue_depth, __ATOMIC_RELAXED);
+  stats->send_queue_high_water    = __atomic_load_n(&state->send_queue_high_water, __ATOMIC_RELAXED);
+  stats->receive_queue_depth      = __atomic_load_n(&state->receive_queue_depth, __ATOMIC_RELAXED);
+  stats->receive_queue_high_water = __atomic_load_n(&state->receive_queue_high_water, __ATOMIC_RELAXED);
+}
+
+/**
+* @brief count an attempt to reopen the transport, only called by the worker
+*
+* @param dev     - the device
+* @param err     - 0 if the transport has been reopened, -1 if not
+* @param down_us - the time the link has been down in microseconds
+*/
+void conbee_stats_reconnect(struct conbee_device *dev, int32_t err, uint64_t down_us)
+{
+  struct conbee_stats *counters = &dev->stats.counters;
+
+  conbee_stats_begin(&dev->stats);
+
+  if (err < 0)
+  {
+    counters->reconnect_failures++;
+  }
+  else
+  {
+    counters->reconnects++;
+    counters->last_reconnect_us = down_us;
+    if (down_us > counters->max_reconnect_us)
+    {
+      counters->max_reconnect_us = down_us;
+    }
+  }
+
+  conbee_stats_end(&dev->stats);
+}
+
+/**
+* @brief count the requests written again or failed because the link went down, only called by the worker
+*
+* @param dev     - the device
+* @param retried - the number of requests written again
+* @param failed  - the number of requests answered with STATUS_ERROR
+*/
+void conbee_stats_requests_resolved(struct conbee_device *dev, uint32_t retried, uint32_t failed)
+{
+  conbee_stats_begin(&dev->stats);
+  dev->stats.counters.retried_requests += retried;
+  dev->stats.counters.failed_requests  += failed;
+  conbee_stats_end(&dev->stats);
+}
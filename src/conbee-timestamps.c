@@ -0,0 +1,157 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <conbee.h>
+#include <conbee-internal.h>
+#include <string.h>
+#include <time.h>
+
+/**
+* @brief enable or disable recording the lifecycle timestamps of frames
+*
+* the timestamps are stored in the timestamps member of the frames returned by
+* conbee_wait_for_frame and conbee_wait_for_frames. While disabled recording costs
+* nothing but a check of the flag.
+*
+* @param dev    - the device, make sure it is already connected
+* @param enable - 1 to enable, 0 to disable
+*/
+void conbee_enable_frame_timestamps(struct conbee_device *dev, uint8_t enable)
+{
+  __atomic_store_n(&dev->timestamps_enabled, enable ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+/**
+* @brief set a function called whenever a waiter picks up a received frame
+*
+* the callback is only called while timestamps are enabled. It is called from the thread
+* waiting for the frame, e.g. within conbee_get_* functions, so it must not block.
+*
+* @param dev      - the device, make sure it is already connected
+* @param cb       - the function to call or NULL to remove the callback
+* @param userdata - pointer handed to the callback
+*/
+void conbee_set_frame_trace_callback(struct conbee_device *dev,
+                                     void (*cb)(struct conbee_device *dev, struct conbee_frame *frame, void *userdata),
+                                     void *userdata)
+{
+  pthread_mutex_lock(&dev->mutex_trace_cb);
+  dev->trace_cb       = cb;
+  dev->trace_userdata = userdata;
+  pthread_mutex_unlock(&dev->mutex_trace_cb);
+}
+
+/**
+* @brief return the monotonic time in nanoseconds if timestamps are enabled
+*
+* @param dev - the device
+*
+* @return the time, 0 if timestamps are disabled
+*/
+uint64_t conbee_timestamp(struct conbee_device *dev)
+{
+  struct timespec now;
+
+  if (!__atomic_load_n(&dev->timestamps_enabled, __ATOMIC_RELAXED))
+  {
+    return 0;
+  }
+
+  // served by the vdso on linux, no system call involved
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return ((uint64_t) now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+/**
+* @brief remember the timestamps of requests written to the stick, only called by the worker
+*
+* @param dev        - the device
+* @param frames     - the written frames
+* @param count      - the number of frames
+* @param written_ns - the time the write completed
+*/
+void conbee_timestamps_written(struct conbee_device *dev, struct conbee_frame **frames, int count, uint64_t written_ns)
+{
+  if (written_ns == 0)
+  {
+    return;
+  }
+
+  for(int i = 0; i < count; i++)
+  {
+    struct conbee_frame *frame = frames[i];
+    uint16_t n = frame->wire != NULL ? frame->wire_frames : 1;
+
+    frame->timestamps.written_ns = written_ns;
+
+    // pre-encoded buffers carry consecutive sequence numbers
+    for(uint16_t j = 0; j < n; j++)
+    {
+      dev->timestamps[(uint8_t) (frame->sequence_number + j)] = frame->timestamps;
+    }
+  }
+}
+
+/**
+* @brief attach the timestamps of its request to a received frame, only called by the worker
+*
+* @param dev         - the device
+* @param frame       - the received frame
+* @param received_ns - the time the first bytes of the frame were read
+*/
+void conbee_timestamps_received(struct conbee_device *dev, struct conbee_frame *frame, uint64_t received_ns)
+{
+  if (received_ns == 0)
+  {
+    return;
+  }
+
+  // state change notifications answer no request
+  if (frame->command != COMMAND_DEVICE_STATE_CHANGED)
+  {
+    frame->timestamps = dev->timestamps[frame->sequence_number];
+    memset(&dev->timestamps[frame->sequence_number], 0, sizeof(struct conbee_frame_timestamps));
+  }
+
+  frame->timestamps.received_ns = received_ns;
+  frame->timestamps.decoded_ns  = conbee_timestamp(dev);
+}
+
+/**
+* @brief record the wakeup of the waiter of a frame and call the trace callback
+*
+* @param dev   - the device
+* @param frame - the frame picked up by the waiter
+*/
+void conbee_timestamps_woken(struct conbee_device *dev, struct conbee_frame *frame)
+{
+  frame->timestamps.woken_ns = conbee_timestamp(dev);
+
+  if (frame->timestamps.woken_ns == 0)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&dev->mutex_trace_cb);
+  if (dev->trace_cb != NULL)
+  {
+    dev->trace_cb(dev, frame, dev->trace_userdata);
+  }
+  pthread_mutex_unlock(&dev->mutex_trace_cb);
+}
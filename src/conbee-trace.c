@@ -0,0 +1,311 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <conbee.h>
+#include <conbee-internal.h>
+#include <conbee-trace.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/**
+* @brief return the number of ring bytes used by a record with the given number of raw bytes
+*
+* @param length - the number of raw bytes of the record
+*
+* @return the number of bytes including record header and padding
+*/
+uint64_t conbee_trace_record_size(uint32_t length)
+{
+  return (sizeof(struct conbee_trace_record) + length + CONBEE_TRACE_ALIGN - 1) & ~((uint64_t) CONBEE_TRACE_ALIGN - 1);
+}
+
+/**
+* @brief return the time of the given clock in nanoseconds
+*/
+static uint64_t trace_now_ns(clockid_t clock)
+{
+  struct timespec now;
+
+  clock_gettime(clock, &now);
+
+  return ((uint64_t) now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+/**
+* @brief start recording the raw bytes written to and read from the stick
+*
+* the worker records every chunk with a timestamp into a ring of the given size, the
+* oldest records are overwritten. With a path the ring is a shared mapping of that file,
+* so it survives a crash of the process. Decode a trace with conbee-tracedump.
+* The trace is recorded until the device is closed.
+*
+* @param dev  - the device, make sure it is already connected
+* @param size - the number of bytes of the ring, at least CONBEE_TRACE_MIN_SIZE and a multiple of CONBEE_TRACE_ALIGN
+* @param path - the file to map the ring to, NULL to keep it in memory only
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+*/
+int32_t conbee_enable_wire_trace(struct conbee_device *dev, uint32_t size, const char *path)
+{
+  struct conbee_wire_trace *expected = NULL;
+  uint64_t mapped = sizeof(struct conbee_trace_header) + size;
+  void *memory;
+
+  if (size < CONBEE_TRACE_MIN_SIZE || size % CONBEE_TRACE_ALIGN != 0)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (__atomic_load_n(&dev->wire_trace, __ATOMIC_ACQUIRE) != NULL)
+  {
+    errno = EBUSY;
+    return -1;
+  }
+
+  if (path != NULL)
+  {
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+      return -1;
+    }
+
+    if (ftruncate(fd, mapped) < 0)
+    {
+      close(fd);
+      return -1;
+    }
+
+    memory = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+  }
+  else
+  {
+    memory = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  }
+
+  if (memory == MAP_FAILED)
+  {
+    return -1;
+  }
+
+  struct conbee_wire_trace *trace = malloc(sizeof(struct conbee_wire_trace));
+  if (trace == NULL)
+  {
+    munmap(memory, mapped);
+    return -1;
+  }
+
+  trace->header = (struct conbee_trace_header *) memory;
+  trace->ring   = (uint8_t *) memory + sizeof(struct conbee_trace_header);
+  trace->mapped = mapped;
+
+  trace->header->magic              = CONBEE_TRACE_MAGIC;
+  trace->header->version            = CONBEE_TRACE_VERSION;
+  trace->header->header_size        = sizeof(struct conbee_trace_header);
+  trace->header->size               = size;
+  trace->header->head               = 0;
+  trace->header->tail               = 0;
+  trace->header->records            = 0;
+  trace->header->realtime_offset_ns = trace_now_ns(CLOCK_REALTIME) - trace_now_ns(CLOCK_MONOTONIC);
+
+  // publish the trace to the worker, only one caller may win
+  if (!__atomic_compare_exchange_n(&dev->wire_trace, &expected, trace, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+  {
+    munmap(memory, mapped);
+    free(trace);
+    errno = EBUSY;
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+* @brief make room for need bytes at head by dropping the oldest records
+*/
+static void trace_reserve(struct conbee_wire_trace *trace, uint64_t head, uint64_t need)
+{
+  struct conbee_trace_header *header = trace->header;
+  uint64_t tail = header->tail;
+
+  while(head + need - tail > header->size)
+  {
+    struct conbee_trace_record *record = (struct conbee_trace_record *) &trace->ring[tail % header->size];
+    tail += conbee_trace_record_size(record->length);
+  }
+
+  // readers have to see the new tail before the old records are overwritten
+  __atomic_store_n(&header->tail, tail, __ATOMIC_RELEASE);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+* @brief write a record at head, there has to be enough room up to the end of the ring
+*/
+static uint64_t trace_write(struct conbee_wire_trace *trace, uint64_t head, uint8_t direction, uint64_t timestamp_ns,
+                            uint8_t *data, uint32_t length)
+{
+  uint64_t need = conbee_trace_record_size(length);
+  struct conbee_trace_record *record = (struct conbee_trace_record *) &trace->ring[head % trace->header->size];
+
+  trace_reserve(trace, head, need);
+
+  record->length        = length;
+  record->direction     = direction;
+  memset(record->reserved, 0, sizeof(record->reserved));
+  record->timestamp_ns  = timestamp_ns;
+  if (data != NULL)
+  {
+    memcpy((uint8_t *) record + sizeof(struct conbee_trace_record), data, length);
+  }
+
+  // the record is complete before readers see the new head
+  __atomic_store_n(&trace->header->head, head + need, __ATOMIC_RELEASE);
+
+  return head + need;
+}
+
+/**
+* @brief record raw bytes written to or read from the stick, only called by the worker
+*
+* @param dev       - the device
+* @param direction - CONBEE_TRACE_TX or CONBEE_TRACE_RX
+* @param data      - the raw bytes
+* @param length    - the number of raw bytes
+*/
+void conbee_wire_trace_record(struct conbee_device *dev, uint8_t direction, uint8_t *data, uint32_t length)
+{
+  struct conbee_wire_trace *trace = __atomic_load_n(&dev->wire_trace, __ATOMIC_ACQUIRE);
+
+  if (trace == NULL)
+  {
+    return;
+  }
+
+  struct conbee_trace_header *header = trace->header;
+  uint64_t head     = header->head;
+  uint64_t now      = trace_now_ns(CLOCK_MONOTONIC);
+  uint32_t maximum  = header->size / 4 - sizeof(struct conbee_trace_record);
+
+  // huge chunks are truncated, a trace has to hold more than a few of them
+  if (length > maximum)
+  {
+    length = maximum;
+  }
+
+  // records never wrap, fill the end of the ring with a padding record instead
+  uint64_t offset = head % header->size;
+  if (offset + conbee_trace_record_size(length) > header->size)
+  {
+    head = trace_write(trace, head, CONBEE_TRACE_PAD, now, NULL, header->size - offset - sizeof(struct conbee_trace_record));
+  }
+
+  trace_write(trace, head, direction, now, data, length);
+  __atomic_store_n(&header->records, header->records + 1, __ATOMIC_RELAXED);
+}
+
+/**
+* @brief write a consistent copy of the wire trace of a device to a file
+*
+* the worker is not stopped while copying, records overwritten during the copy are
+* left out. Decode the file with conbee-tracedump.
+*
+* @param dev  - the device with an enabled wire trace
+* @param path - the file to write
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+*/
+int32_t conbee_dump_wire_trace(struct conbee_device *dev, const char *path)
+{
+  struct conbee_wire_trace *trace = __atomic_load_n(&dev->wire_trace, __ATOMIC_ACQUIRE);
+  struct conbee_trace_header header;
+
+  if (trace == NULL)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  uint8_t *ring = malloc(trace->header->size);
+  if (ring == NULL)
+  {
+    return -1;
+  }
+
+  memcpy(&header, trace->header, sizeof(header));
+  header.head = __atomic_load_n(&trace->header->head, __ATOMIC_ACQUIRE);
+  memcpy(ring, trace->ring, header.size);
+
+  // everything the worker overwrote while copying is before the tail now
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  header.tail = __atomic_load_n(&trace->header->tail, __ATOMIC_ACQUIRE);
+  if (header.tail > header.head)
+  {
+    header.tail = header.head;
+  }
+
+  FILE *file = fopen(path, "w");
+  if (file == NULL)
+  {
+    free(ring);
+    return -1;
+  }
+
+  int32_t err = 0;
+  if (fwrite(&header, sizeof(header), 1, file) != 1 || fwrite(ring, header.size, 1, file) != 1)
+  {
+    err = -1;
+  }
+
+  if (fclose(file) != 0)
+  {
+    err = -1;
+  }
+
+  free(ring);
+
+  return err;
+}
+
+/**
+* @brief stop recording and free the wire trace, the worker has to be stopped already
+*
+* @param dev - the device
+*/
+void conbee_wire_trace_free(struct conbee_device *dev)
+{
+  struct conbee_wire_trace *trace = __atomic_exchange_n(&dev->wire_trace, NULL, __ATOMIC_ACQ_REL);
+
+  if (trace == NULL)
+  {
+    return;
+  }
+
+  munmap(trace->header, trace->mapped);
+  free(trace);
+}
@@ -0,0 +1,113 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+ /** @file */
+#include <conbee.h>
+#include <conbee-internal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+/**
+* @brief create a connected socket pair, the library uses one end and an emulator the other
+*
+* @param transport - the transport to open
+* @param address   - ignored
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+*/
+static int32_t loopback_open(struct conbee_transport *transport, const char *address)
+{
+  int sv[2];
+
+  (void) address;
+
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0)
+  {
+    fprintf(stderr,"error: creating loopback transport failed (%s)\n", strerror (errno));
+    return -1;
+  }
+
+  int32_t *peer = malloc(sizeof(int32_t));
+  if (peer == NULL)
+  {
+    close(sv[0]);
+    close(sv[1]);
+    return -1;
+  }
+
+  *peer           = sv[1];
+  transport->fd   = sv[0];
+  transport->priv = peer;
+
+  return 0;
+}
+
+/**
+* @brief close both ends of the socket pair, the peer only if nobody took it
+*/
+static void loopback_close(struct conbee_transport *transport)
+{
+  int32_t *peer = (int32_t *) transport->priv;
+
+  conbee_transport_fd_close(transport);
+
+  if (peer != NULL)
+  {
+    if (*peer >= 0)
+    {
+      close(*peer);
+    }
+    free(peer);
+    transport->priv = NULL;
+  }
+}
+
+/**
+* @brief take the other end of a loopback transport, e.g. to attach an emulator to it
+*
+* @param dev - a device connected with the loopback transport
+*
+* @return >=0 - the file descriptor, it is owned by the caller from now on
+* @return  -1 - the device is not connected with the loopback transport or the peer was already taken
+*/
+int32_t conbee_loopback_peer(struct conbee_device *dev)
+{
+  if (dev->transport.ops != &conbee_transport_loopback || dev->transport.priv == NULL)
+  {
+    return -1;
+  }
+
+  int32_t *peer = (int32_t *) dev->transport.priv;
+  int32_t fd    = *peer;
+  *peer         = -1;
+
+  return fd;
+}
+
+/// in process transport for emulators and tests, address "loopback://"
+const struct conbee_transport_ops conbee_transport_loopback = {
+  .prefix = "loopback://",
+  .open   = loopback_open,
+  .read   = conbee_transport_fd_read,
+  .writev = conbee_transport_fd_writev,
+  .fd     = conbee_transport_fd,
+  .close  = loopback_close,
+};
@@ -0,0 +1,356 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <conbee.h>
+#include <conbee-internal.h>
+#include <conbee-capture.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+/// option at the end of a replay address to replay as fast as possible
+#define REPLAY_FAST_OPTION    "?fast"
+
+/// the longest time the feeder sleeps before checking whether it has to stop
+#define REPLAY_SLEEP_NS       10000000
+
+/**
+* @brief the state of a replay transport
+*/
+struct replay_state
+{
+  /// the whole capture file
+  uint8_t *capture;
+
+  /// number of bytes of the capture file
+  size_t size;
+
+  /// replay as fast as possible instead of at the original timing
+  uint8_t fast;
+
+  /// the end of the socket pair written by the feeder
+  int32_t peer;
+
+  /// the thread writing the received bytes of the capture to the peer
+  pthread_t feeder;
+
+  /// the feeder has to stop, accessed atomically
+  uint8_t stop;
+
+  /// the library has read everything the feeder has written, accessed atomically
+  uint8_t finished;
+};
+
+/**
+* @brief read a whole capture file into memory and check its records
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+*/
+static int32_t replay_load(struct replay_state *state, const char *path)
+{
+  FILE *file = fopen(path, "r");
+  if (file == NULL)
+  {
+    return -1;
+  }
+
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  state->capture = malloc(size > 0 ? size : 1);
+  state->size    = size;
+  if (size < 0 || state->capture == NULL || fread(state->capture, 1, size, file) != (size_t) size)
+  {
+    fclose(file);
+    free(state->capture);
+    state->capture = NULL;
+    return -1;
+  }
+  fclose(file);
+
+  struct conbee_capture_header *header = (struct conbee_capture_header *) state->capture;
+  if (state->size < sizeof(*header) || header->magic != CONBEE_CAPTURE_MAGIC ||
+      header->version != CONBEE_CAPTURE_VERSION || header->header_size < sizeof(*header))
+  {
+    free(state->capture);
+    state->capture = NULL;
+    errno = EINVAL;
+    return -1;
+  }
+
+  // a capture cut off while recording is replayed up to its last complete record
+  size_t offset = header->header_size;
+  while(offset + sizeof(struct conbee_capture_record) <= state->size)
+  {
+    struct conbee_capture_record record;
+
+    memcpy(&record, &state->capture[offset], sizeof(record));
+    if (offset + sizeof(record) + record.length > state->size)
+    {
+      break;
+    }
+    offset += sizeof(record) + record.length;
+  }
+  state->size = offset;
+
+  return 0;
+}
+
+/**
+* @brief sleep until the given monotonic time or until the feeder has to stop
+*/
+static void replay_sleep_until(struct replay_state *state, struct timespec *until)
+{
+  while(!__atomic_load_n(&state->stop, __ATOMIC_ACQUIRE))
+  {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    int64_t remaining = (until->tv_sec - now.tv_sec) * 1000000000LL + (until->tv_nsec - now.tv_nsec);
+    if (remaining <= 0)
+    {
+      return;
+    }
+
+    struct timespec step = {0, remaining > REPLAY_SLEEP_NS ? REPLAY_SLEEP_NS : remaining};
+    nanosleep(&step, NULL);
+  }
+}
+
+/**
+* @brief write the received bytes of the capture to the peer
+*
+* @param arg - the replay state
+*/
+static void * replay_feed(void *arg)
+{
+  struct replay_state *state            = (struct replay_state *) arg;
+  struct conbee_capture_header *header  = (struct conbee_capture_header *) state->capture;
+  size_t offset                         = header->header_size;
+  struct timespec at;
+
+  clock_gettime(CLOCK_MONOTONIC, &at);
+
+  while(offset < state->size && !__atomic_load_n(&state->stop, __ATOMIC_ACQUIRE))
+  {
+    struct conbee_capture_record record;
+
+    memcpy(&record, &state->capture[offset], sizeof(record));
+    uint8_t *data = &state->capture[offset + sizeof(record)];
+    offset += sizeof(record) + record.length;
+
+    at.tv_sec  += record.delta_us / 1000000;
+    at.tv_nsec += (record.delta_us % 1000000) * 1000;
+    if (at.tv_nsec >= 1000000000)
+    {
+      at.tv_sec++;
+      at.tv_nsec -= 1000000000;
+    }
+
+    // written bytes are only recorded for reference, the library writes its own
+    if (record.direction != CONBEE_TRACE_RX)
+    {
+      continue;
+    }
+
+    if (!state->fast)
+    {
+      replay_sleep_until(state, &at);
+    }
+
+    uint32_t written = 0;
+    while(written < record.length)
+    {
+      ssize_t err = send(state->peer, &data[written], record.length - written, MSG_NOSIGNAL);
+      if (err < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+
+        // the library closed the transport
+        return NULL;
+      }
+      written += err;
+    }
+  }
+
+  // the library reads the end of the stream once it has read everything before
+  shutdown(state->peer, SHUT_WR);
+
+  return NULL;
+}
+
+/**
+* @brief load a capture and start replaying the received bytes
+*
+* @param transport - the transport to open
+* @param address   - the capture file, followed by "?fast" to replay as fast as possible
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+*/
+static int32_t replay_open(struct conbee_transport *transport, const char *address)
+{
+  char path[1024];
+  int sv[2];
+
+  size_t length = strlen(address);
+  size_t option = strlen(REPLAY_FAST_OPTION);
+  uint8_t fast  = length > option && strcmp(address + length - option, REPLAY_FAST_OPTION) == 0;
+
+  if (fast)
+  {
+    length -= option;
+  }
+
+  if (length == 0 || length >= sizeof(path))
+  {
+    errno = EINVAL;
+    return -1;
+  }
+  memcpy(path, address, length);
+  path[length] = 0;
+
+  struct replay_state *state = malloc(sizeof(struct replay_state));
+  if (state == NULL)
+  {
+    return -1;
+  }
+
+  if (replay_load(state, path) < 0)
+  {
+    fprintf(stderr,"error: loading capture %s failed (%s)\n", path, strerror (errno));
+    free(state);
+    return -1;
+  }
+
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0)
+  {
+    fprintf(stderr,"error: creating replay transport failed (%s)\n", strerror (errno));
+    free(state->capture);
+    free(state);
+    return -1;
+  }
+
+  state->fast       = fast;
+  state->peer       = sv[1];
+  state->stop       = 0;
+  state->finished   = 0;
+  transport->fd     = sv[0];
+  transport->priv   = state;
+
+  pthread_create(&state->feeder, NULL, replay_feed, state);
+
+  return 0;
+}
+
+/**
+* @brief read the replayed bytes, remembers when the whole capture has been read
+*/
+static ssize_t replay_read(struct conbee_transport *transport, uint8_t *buffer, uint32_t length)
+{
+  struct replay_state *state = (struct replay_state *) transport->priv;
+  ssize_t err = conbee_transport_fd_read(transport, buffer, length);
+
+  if (err == 0)
+  {
+    __atomic_store_n(&state->finished, 1, __ATOMIC_RELEASE);
+  }
+
+  return err;
+}
+
+/**
+* @brief drop everything the library writes, the capture already holds the answers
+*/
+static ssize_t replay_writev(struct conbee_transport *transport, const struct iovec *iov, int iovcnt)
+{
+  ssize_t length = 0;
+
+  (void) transport;
+
+  for(int i = 0; i < iovcnt; i++)
+  {
+    length += iov[i].iov_len;
+  }
+
+  return length;
+}
+
+/**
+* @brief stop the feeder and free the capture
+*/
+static void replay_close(struct conbee_transport *transport)
+{
+  struct replay_state *state = (struct replay_state *) transport->priv;
+
+  conbee_transport_fd_close(transport);
+
+  if (state != NULL)
+  {
+    __atomic_store_n(&state->stop, 1, __ATOMIC_RELEASE);
+    pthread_join(state->feeder, NULL);
+    close(state->peer);
+    free(state->capture);
+    free(state);
+    transport->priv = NULL;
+  }
+}
+
+/**
+* @brief check whether a replayed capture has been read completely
+*
+* all frames of the capture are in the receive queue once this returns 1
+*
+* @param dev - a device connected with the replay transport
+*
+* @return   1 - the whole capture has been read
+* @return   0 - the replay is still running
+* @return  -1 - the device is not connected with the replay transport
+*/
+int32_t conbee_replay_finished(struct conbee_device *dev)
+{
+  if (dev->transport.ops != &conbee_transport_replay || dev->transport.priv == NULL)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  struct replay_state *state = (struct replay_state *) dev->transport.priv;
+
+  return __atomic_load_n(&state->finished, __ATOMIC_ACQUIRE);
+}
+
+/// transport replaying the bytes received in a capture, address "replay://file" or "replay://file?fast"
+const struct conbee_transport_ops conbee_transport_replay = {
+  .prefix = "replay://",
+  .open   = replay_open,
+  .read   = replay_read,
+  .writev = replay_writev,
+  .fd     = conbee_transport_fd,
+  .close  = replay_close,
+};
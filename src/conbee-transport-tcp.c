@@ -0,0 +1,123 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+ /** @file */
+#include <conbee.h>
+#include <conbee-internal.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+/**
+* @brief connect to a stick exported by a tcp server like ser2net
+*
+* @param transport - the transport to open
+* @param address   - host:port, an ipv6 host has to be given in brackets like [::1]:4000
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+*/
+static int32_t tcp_open(struct conbee_transport *transport, const char *address)
+{
+  struct addrinfo hints;
+  struct addrinfo *result;
+  char host[256];
+  const char *port = strrchr(address, ':');
+  size_t host_length;
+  int32_t err;
+
+  if (port == NULL || port == address)
+  {
+    fprintf(stderr,"error: %s is no valid host:port\n", address);
+    errno = EINVAL;
+    return -1;
+  }
+
+  host_length = port - address;
+  if (address[0] == '[' && address[host_length-1] == ']')
+  {
+    address++;
+    host_length -= 2;
+  }
+
+  if (host_length >= sizeof(host))
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  memcpy(host, address, host_length);
+  host[host_length] = 0;
+  port++;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family   = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  err = getaddrinfo(host, port, &hints, &result);
+  if (err != 0)
+  {
+    fprintf(stderr,"error: resolving %s failed (%s)\n", host, gai_strerror(err));
+    errno = EHOSTUNREACH;
+    return -1;
+  }
+
+  transport->fd = -1;
+  for(struct addrinfo *ai = result; ai != NULL; ai = ai->ai_next)
+  {
+    transport->fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (transport->fd < 0)
+    {
+      continue;
+    }
+
+    if (connect(transport->fd, ai->ai_addr, ai->ai_addrlen) == 0)
+    {
+      break;
+    }
+
+    conbee_transport_fd_close(transport);
+  }
+
+  freeaddrinfo(result);
+
+  if (transport->fd < 0)
+  {
+    fprintf(stderr,"error: connecting to %s:%s failed (%s)\n", host, port, strerror (errno));
+    return -1;
+  }
+
+  // requests are small and latency matters more than throughput
+  int one = 1;
+  setsockopt(transport->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  return 0;
+}
+
+/// transport for a stick exported by a tcp server like ser2net, address "tcp://host:port"
+const struct conbee_transport_ops conbee_transport_tcp = {
+  .prefix = "tcp://",
+  .open   = tcp_open,
+  .read   = conbee_transport_fd_read,
+  .writev = conbee_transport_fd_writev,
+  .fd     = conbee_transport_fd,
+  .close  = conbee_transport_fd_close,
+};
@@ -0,0 +1,110 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+ /** @file */
+#include <conbee.h>
+#include <conbee-internal.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+/**
+* @brief open the tty a stick is attached to and switch it to raw mode with 115200 baud
+*
+* @param transport - the transport to open
+* @param address   - full path to the tty device
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+*/
+static int32_t tty_open(struct conbee_transport *transport, const char *address)
+{
+  struct termios tty;
+  int32_t err = 0;
+
+  // initialize termios structure
+  memset (&tty, 0, sizeof tty);
+
+  // open the tty device
+  transport->fd = open (address, O_RDWR | O_NOCTTY | O_SYNC);
+
+  if (transport->fd < 0)
+  {
+    fprintf(stderr,"error: opening %s failed (%s)\n", address, strerror (errno));
+    return -1;
+  }
+
+  // fetch us the current attributes of the tty
+  err = tcgetattr(transport->fd, &tty);
+
+  if (err < 0)
+  {
+      fprintf(stderr,"error: fetching attributes from %s failed (%s)\n", address, strerror (errno));
+      conbee_transport_fd_close(transport);
+      return -1;
+  }
+
+  // the line carries binary slip frames, so no character translation at all
+  cfmakeraw(&tty);
+  tty.c_cc[VMIN]  = 1;
+  tty.c_cc[VTIME] = 0;
+
+  /*
+  * setting input and output baud rate
+  */
+  err=cfsetospeed (&tty, B115200);
+
+  if (err < 0)
+  {
+      fprintf(stderr,"error: setting output baudrate of %s failed (%s)\n", address, strerror (errno));
+      conbee_transport_fd_close(transport);
+      return -1;
+  }
+
+  err=cfsetispeed (&tty, B115200);
+
+  if (err < 0)
+  {
+      fprintf(stderr,"error: setting input baudrate of %s failed (%s)\n", address, strerror (errno));
+      conbee_transport_fd_close(transport);
+      return -1;
+  }
+
+  // set the configured attributes
+  err=tcsetattr (transport->fd, TCSANOW, &tty);
+
+  if (err < 0)
+  {
+      fprintf(stderr,"error: setting attributes of %s failed (%s)\n", address, strerror (errno));
+      conbee_transport_fd_close(transport);
+      return -1;
+  }
+
+  return 0;
+}
+
+/// transport for a stick attached to a local tty, used for addresses without prefix
+const struct conbee_transport_ops conbee_transport_tty = {
+  .prefix = "tty://",
+  .open   = tty_open,
+  .read   = conbee_transport_fd_read,
+  .writev = conbee_transport_fd_writev,
+  .fd     = conbee_transport_fd,
+  .close  = conbee_transport_fd_close,
+};
@@ -0,0 +1,76 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+ /** @file */
+#include <conbee.h>
+#include <conbee-internal.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/**
+* @brief connect to a stick shared by a local daemon like conbeectrl serve
+*
+* @param transport - the transport to open
+* @param address   - the path of the unix socket
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+*/
+static int32_t unix_open(struct conbee_transport *transport, const char *address)
+{
+  struct sockaddr_un addr;
+
+  if (strlen(address) == 0 || strlen(address) >= sizeof(addr.sun_path))
+  {
+    fprintf(stderr,"error: %s is no valid socket path\n", address);
+    errno = EINVAL;
+    return -1;
+  }
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, address);
+
+  transport->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (transport->fd < 0)
+  {
+    return -1;
+  }
+
+  if (connect(transport->fd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+  {
+    int32_t err = errno;
+    conbee_transport_fd_close(transport);
+    errno = err;
+    return -1;
+  }
+
+  return 0;
+}
+
+/// transport for a stick shared by a local daemon, address "unix:///path/of/socket"
+const struct conbee_transport_ops conbee_transport_unix = {
+  .prefix = "unix://",
+  .open   = unix_open,
+  .read   = conbee_transport_fd_read,
+  .writev = conbee_transport_fd_writev,
+  .fd     = conbee_transport_fd,
+  .close  = conbee_transport_fd_close,
+};
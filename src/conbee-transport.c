@@ -0,0 +1,121 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+ /** @file */
+#include <conbee.h>
+#include <conbee-internal.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+/**
+* all transports selected by an address prefix, the tty transport is the fallback
+*/
+static const struct conbee_transport_ops *transports[] = {
+  &conbee_transport_tty,
+  &conbee_transport_tcp,
+  &conbee_transport_loopback,
+  &conbee_transport_unix,
+  &conbee_transport_replay,
+};
+
+/**
+* @brief find the transport for an address
+*
+* @param address - the address, e.g. /dev/ttyACM0 or tcp://host:port
+* @param rest    - receives a pointer to the address without the transport prefix, may be NULL
+*
+* @return the transport operations, the tty transport if no prefix matches
+*/
+const struct conbee_transport_ops * conbee_transport_lookup(const char *address, const char **rest)
+{
+  for(uint32_t i = 0; i < sizeof(transports)/sizeof(transports[0]); i++)
+  {
+    size_t length = strlen(transports[i]->prefix);
+
+    if (strncmp(address, transports[i]->prefix, length) == 0)
+    {
+      if (rest != NULL)
+      {
+        *rest = address + length;
+      }
+      return transports[i];
+    }
+  }
+
+  if (rest != NULL)
+  {
+    *rest = address;
+  }
+  return &conbee_transport_tty;
+}
+
+/**
+* @brief read from the file descriptor of a transport
+*
+* @return  >0 - the number of bytes read
+* @return   0 - the transport has been closed by the other side
+* @return  -1 - error occured, use errno to find out what
+*/
+ssize_t conbee_transport_fd_read(struct conbee_transport *transport, uint8_t *buffer, uint32_t length)
+{
+  ssize_t err;
+
+  do
+  {
+    err = read(transport->fd, buffer, length);
+  } while(err < 0 && errno == EINTR);
+
+  return err;
+}
+
+/**
+* @brief write to the file descriptor of a transport
+*
+* @return >=0 - the number of bytes written
+* @return  -1 - error occured, use errno to find out what
+*/
+ssize_t conbee_transport_fd_writev(struct conbee_transport *transport, const struct iovec *iov, int iovcnt)
+{
+  ssize_t err;
+
+  do
+  {
+    err = writev(transport->fd, iov, iovcnt);
+  } while(err < 0 && errno == EINTR);
+
+  return err;
+}
+
+/**
+* @brief return the file descriptor of a transport
+*/
+int32_t conbee_transport_fd(struct conbee_transport *transport)
+{
+  return transport->fd;
+}
+
+/**
+* @brief close the file descriptor of a transport
+*/
+void conbee_transport_fd_close(struct conbee_transport *transport)
+{
+  if (transport->fd >= 0)
+  {
+    close(transport->fd);
+    transport->fd = -1;
+  }
+}
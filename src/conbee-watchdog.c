@@ -0,0 +1,217 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <conbee.h>
+#include <conbee-internal.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+/**
+* @brief return the monotonic time in microseconds
+*/
+static uint64_t watchdog_now_us()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return ((uint64_t) now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+* @brief let the worker keep the watchdog of the stick alive
+*
+* @param dev      - the device, make sure it is already connected
+* @param ttl      - the time to live in seconds, 0 stops refreshing
+* @param percent  - refresh after this percentage of the time to live, 1 to 100
+* @param cb       - the function to call for failed refreshes, may be NULL
+* @param userdata - pointer handed to the callback
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+* @return  -2 - conbee device is not connected
+*/
+int32_t conbee_enable_watchdog(struct conbee_device *dev, uint32_t ttl, uint8_t percent,
+                               void (*cb)(struct conbee_device *dev, uint8_t status, void *userdata), void *userdata)
+{
+  struct conbee_watchdog *watchdog = &dev->watchdog;
+
+  if (dev->tty_status == TTY_DISCONNECTED)
+  {
+    return -2;
+  }
+
+  if (ttl > 0 && (percent == 0 || percent > 100))
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  pthread_mutex_lock(&watchdog->mutex);
+  watchdog->ttl             = ttl;
+  watchdog->period_ms       = ((uint64_t) ttl) * 10 * percent;
+  watchdog->deadline_us     = watchdog_now_us();
+  watchdog->pending         = -1;
+  watchdog->cb              = cb;
+  watchdog->userdata        = userdata;
+  watchdog->total_jitter_us = 0;
+  memset(&watchdog->stats, 0, sizeof(watchdog->stats));
+  pthread_mutex_unlock(&watchdog->mutex);
+
+  return 0;
+}
+
+/**
+* @brief return the statistics of the watchdog refresher
+*
+* @param dev   - the device, make sure it is already connected
+* @param stats - the statistics
+*/
+void conbee_get_watchdog_stats(struct conbee_device *dev, struct conbee_watchdog_stats *stats)
+{
+  pthread_mutex_lock(&dev->watchdog.mutex);
+  *stats = dev->watchdog.stats;
+  pthread_mutex_unlock(&dev->watchdog.mutex);
+}
+
+/**
+* @brief send a watchdog refresh if it is due, called by the worker on every iteration
+*
+* @param dev - the device
+*/
+void conbee_watchdog_poll(struct conbee_device *dev)
+{
+  struct conbee_watchdog *watchdog = &dev->watchdog;
+  void (*cb)(struct conbee_device *, uint8_t, void *) = NULL;
+  void *userdata = NULL;
+  uint32_t ttl;
+
+  pthread_mutex_lock(&watchdog->mutex);
+
+  uint64_t now = watchdog_now_us();
+  if (watchdog->ttl == 0 || now < watchdog->deadline_us)
+  {
+    pthread_mutex_unlock(&watchdog->mutex);
+    return;
+  }
+
+  // the previous refresh is still unanswered
+  if (watchdog->pending >= 0)
+  {
+    watchdog->stats.failures++;
+    cb        = watchdog->cb;
+    userdata  = watchdog->userdata;
+  }
+
+  uint64_t jitter = now - watchdog->deadline_us;
+  watchdog->stats.refreshes++;
+  watchdog->stats.last_jitter_us = jitter;
+  watchdog->total_jitter_us     += jitter;
+  watchdog->stats.mean_jitter_us = watchdog->total_jitter_us / watchdog->stats.refreshes;
+  if (jitter > watchdog->stats.max_jitter_us)
+  {
+    watchdog->stats.max_jitter_us = jitter;
+  }
+
+  // keep the schedule, but do not try to catch up on refreshes missed completely
+  watchdog->deadline_us += watchdog->period_ms * 1000;
+  if (watchdog->deadline_us <= now)
+  {
+    watchdog->deadline_us = now + watchdog->period_ms * 1000;
+  }
+
+  ttl = watchdog->ttl;
+  struct conbee_frame *request  = conbee_write_parameter_request_uint32(PARAM_WATCHDOG_TTL, &ttl);
+  request->sequence_number      = conbee_reserve_sequence_numbers(dev, 1);
+  watchdog->pending             = request->sequence_number;
+
+  pthread_mutex_unlock(&watchdog->mutex);
+
+  if (cb != NULL)
+  {
+    cb(dev, STATUS_TIMEOUT, userdata);
+  }
+
+  // the worker is the only writer to the tty, so the refresh can be sent right away
+  if (conbee_write_frame(dev, request) < 0)
+  {
+    pthread_mutex_lock(&watchdog->mutex);
+    watchdog->pending = -1;
+    watchdog->stats.failures++;
+    cb        = watchdog->cb;
+    userdata  = watchdog->userdata;
+    pthread_mutex_unlock(&watchdog->mutex);
+
+    if (cb != NULL)
+    {
+      cb(dev, STATUS_ERROR, userdata);
+    }
+  }
+
+  conbee_free_frame(request);
+}
+
+/**
+* @brief consume the response to a watchdog refresh, called by the worker for every received frame
+*
+* @param dev   - the device
+* @param frame - the received frame
+*
+* @return   1 - the frame was the response to a refresh and has been freed
+* @return   0 - the frame is no response to a refresh
+*/
+int32_t conbee_watchdog_response(struct conbee_device *dev, struct conbee_frame *frame)
+{
+  struct conbee_watchdog *watchdog = &dev->watchdog;
+  void (*cb)(struct conbee_device *, uint8_t, void *) = NULL;
+  void *userdata = NULL;
+  uint8_t status = frame->status;
+
+  if (frame->command != COMMAND_WRITE_PARAMETER)
+  {
+    return 0;
+  }
+
+  pthread_mutex_lock(&watchdog->mutex);
+
+  if (watchdog->pending != frame->sequence_number)
+  {
+    pthread_mutex_unlock(&watchdog->mutex);
+    return 0;
+  }
+
+  watchdog->pending = -1;
+  if (status != STATUS_SUCCESS)
+  {
+    watchdog->stats.failures++;
+    cb        = watchdog->cb;
+    userdata  = watchdog->userdata;
+  }
+
+  pthread_mutex_unlock(&watchdog->mutex);
+
+  if (cb != NULL)
+  {
+    cb(dev, status, userdata);
+  }
+
+  conbee_free_frame(frame);
+
+  return 1;
+}
@@ -31,11 +31,18 @@
 #include <conbee-queue.h>
 #include <conbee-internal.h>
 #include <conbee-send-receive.h>
+#include <conbee-dispatch.h>
+#include <conbee-probes.h>
 #include <pthread.h>
 #include <time.h>
+#include <sys/uio.h>
 /**
 * @brief function to connect to the conbee stick on the given tty
 *
+* the transport is selected by the prefix of the name, "tcp://host:port" connects to a
+* stick exported by a tcp server, "loopback://" creates an in process transport, every
+* other name is opened as tty.
+*
 * @param dev      - pointer to a conbee_device structure, please make memory is already allocated
 * @param ttyname  - c string containing the full path to the tty device of the conbee stick
 *
@@ -44,78 +51,48 @@
 */
 int32_t conbee_connect(struct conbee_device *dev, char *ttyname)
 {
-  struct termios tty;
+  return conbee_connect_transport(dev, conbee_transport_lookup(ttyname, NULL), ttyname);
+}
+
+/**
+* @brief function to connect to the conbee stick using the given transport
+*
+* @param dev      - pointer to a conbee_device structure, please make memory is already allocated
+* @param ops      - the transport to use
+* @param address  - the address of the stick, the prefix of the transport is optional
+*
+* @return < 0 - an error occured, use errno to get the error code of the system
+* @return   0 - everything went fine
+*/
+int32_t conbee_connect_transport(struct conbee_device *dev, const struct conbee_transport_ops *ops, const char *address)
+{
   int32_t err = 0;
+  size_t length = strlen(address);
 
-  // copy name of tty device into conbee_device structure
-  if (strlen(ttyname) < 200)
-  {
-    memcpy(dev->tty, ttyname, strlen(ttyname));
-  }
-  else
+  // copy name of the stick into conbee_device structure
+  memset(dev->tty, 0, sizeof(dev->tty));
+  memcpy(dev->tty, address, length < sizeof(dev->tty) ? length : sizeof(dev->tty) - 1);
+
+  // strip the transport prefix
+  if (ops->prefix != NULL && strncmp(address, ops->prefix, strlen(ops->prefix)) == 0)
   {
-    memcpy(dev->tty, ttyname, 199);
-    dev->tty[199]=0;
+    address += strlen(ops->prefix);
   }
 
-  // initialize termios structure
-  memset (&tty, 0, sizeof tty);
-
   // tty is not connected
   dev->tty_status=TTY_DISCONNECTED;
 
-  // open the tty device
-  dev->fd = open (ttyname, O_RDWR | O_NOCTTY | O_SYNC);
-
-  if (dev->fd < 0)
-  {
-    fprintf(stderr,"error: opening %s failed (%s)\n", ttyname, strerror (errno));
-    return -1;
-  }
-
-
-  // fetch us the current attributes of the tty
-  err = tcgetattr(dev->fd, &tty);
+  dev->transport.ops  = ops;
+  dev->transport.fd   = -1;
+  dev->transport.priv = NULL;
 
+  err = ops->open(&dev->transport, address);
   if (err < 0)
   {
-      fprintf(stderr,"error: fetching attributes from %s failed (%s)\n", ttyname, strerror (errno));
-      close(dev->fd);
-      return -1;
-  }
-
-  /*
-  * setting input and output baud rate
-  */
-
-  err=cfsetospeed (&tty, B115200);
-
-  if (err < 0)
-  {
-      fprintf(stderr,"error: setting output baudrate of %s failed (%s)\n", ttyname, strerror (errno));
-      close(dev->fd);
-      return -1;
-  }
-
-  err=cfsetispeed (&tty, B115200);
-
-  if (err < 0)
-  {
-      fprintf(stderr,"error: setting input baudrate of %s failed (%s)\n", ttyname, strerror (errno));
-      close(dev->fd);
-      return -1;
+    return -1;
   }
 
-
-  // set the configured attributes
-  err=tcsetattr (dev->fd, TCSANOW, &tty);
-
-  if (err < 0)
-  {
-      fprintf(stderr,"error: setting attributes of %s failed (%s)\n", ttyname, strerror (errno));
-      close(dev->fd);
-      return -1;
-  }
+  dev->fd = ops->fd(&dev->transport);
 
   dev->write_byte = &conbee_write_byte;
   dev->read_byte  = &conbee_read_byte;
@@ -135,11 +112,61 @@ int32_t conbee_connect(struct conbee_device *dev, char *ttyname)
   // initialize condition variables to notify listeners to queues
   pthread_cond_init(&dev->cond_receive_queue,NULL);
 
+  // no aps handlers are registered after connecting
+  conbee_aps_handler_table_init(&dev->aps_handlers);
+
+  // the parameter cache is disabled until the user enables it
+  pthread_mutex_init(&dev->parameter_cache.mutex, NULL);
+  dev->parameter_cache.enabled    = 0;
+  dev->parameter_cache.generation = 0;
+  memset(dev->parameter_cache.valid, 0, sizeof(dev->parameter_cache.valid));
+
+  // the device state is unknown until the stick reports it
+  dev->device_state           = 0;
+  dev->device_state_cb        = NULL;
+  dev->device_state_userdata  = NULL;
+  dev->device_state_cb_running = 0;
+  pthread_mutex_init(&dev->mutex_device_state_cb, NULL);
+  pthread_cond_init(&dev->cond_device_state_cb, NULL);
+
+  // the watchdog is not refreshed until the user enables it
+  memset(&dev->watchdog, 0, sizeof(dev->watchdog));
+  dev->watchdog.pending = -1;
+  pthread_mutex_init(&dev->watchdog.mutex, NULL);
+
+  // the transport is not reopened until the user enables it
+  memset(&dev->reconnect, 0, sizeof(dev->reconnect));
+  pthread_mutex_init(&dev->reconnect.mutex, NULL);
+
+  // statistics are kept for every connection
+  memset(&dev->stats, 0, sizeof(dev->stats));
+
+  // frame timestamps are recorded once the user enables them
+  dev->timestamps_enabled = 0;
+  dev->trace_cb           = NULL;
+  dev->trace_userdata     = NULL;
+  memset(dev->timestamps, 0, sizeof(dev->timestamps));
+  pthread_mutex_init(&dev->mutex_trace_cb, NULL);
+
+  // the wire trace is recorded once the user enables it
+  dev->wire_trace = NULL;
+  dev->capture    = NULL;
+  pthread_mutex_init(&dev->mutex_capture, NULL);
+
+  // received frames are queued until the user subscribes to them
+  dev->subscriber_cb        = NULL;
+  dev->subscriber_userdata  = NULL;
+  dev->subscriber_cluster   = APS_MATCH_ANY;
+  memset(dev->subscriber_commands, 0xFF, sizeof(dev->subscriber_commands));
+  dev->subscriber_running   = 0;
+  pthread_mutex_init(&dev->mutex_subscriber, NULL);
+  pthread_cond_init(&dev->cond_subscriber, NULL);
+
   err = pipe(dev->pipe_send_queue);
   if (err < 0)
   {
       fprintf(stderr,"error: initializing send queue pipes (%s)\n", strerror (errno));
-      close(dev->fd);
+      dev->transport.ops->close(&dev->transport);
 
       return -1;
   }
@@ -148,6 +175,7 @@ int32_t conbee_connect(struct conbee_device *dev, char *ttyname)
   pthread_mutex_init(&dev->mutex_worker, NULL);
   dev->worker_running=0;
   dev->worker_stop=0;
+  dev->link_up=1;
 
   pthread_create(&dev->worker, NULL, conbee_send_receive, (void *)dev);
 
@@ -182,10 +210,16 @@ void conbee_close(struct conbee_device *dev)
 
   pthread_join(dev->worker,NULL);
 
-  close(dev->fd);
+  dev->transport.ops->close(&dev->transport);
+  close(dev->pipe_send_queue[0]);
+  close(dev->pipe_send_queue[1]);
 
   dev->tty_status = TTY_DISCONNECTED;
 
+  conbee_aps_handler_table_free(&dev->aps_handlers);
+  conbee_reconnect_free(dev);
+  conbee_wire_trace_free(dev);
+  conbee_disable_capture(dev);
 }
 
 
@@ -200,19 +234,35 @@ void conbee_close(struct conbee_device *dev)
 * @return -2  - conbee device is not connected
 */
 int32_t conbee_write_byte(struct conbee_device *dev, uint8_t c)
+{
+  return conbee_write_buffer(dev, &c, 1);
+}
+
+
+/**
+* @brief helper function to receive one byte from the tty to the conbee stick
+*
+* @param dev - pointer to a conbee_device structure, please make sure the device is already connected
+* @param  c  - the byte to receive
+*
+* @return 0   - everything went fine
+* @return -1  - error occured, use errno to find out what
+* @return -2  - conbee device is not connected
+*/
+int32_t conbee_read_byte(struct conbee_device *dev, uint8_t *c)
 {
   // variable for error codes
-  int32_t err = 0;
+  ssize_t err = 0;
 
   if (dev->tty_status == TTY_DISCONNECTED)
   {
     return -2;
   }
 
-  err=write(dev->fd, &c, 1);
-  if (err < 0)
+  err=dev->transport.ops->read(&dev->transport, c, 1);
+  if (err <= 0)
   {
-      fprintf(stderr,"error: writing %c to %s failed (%s)\n", c, dev->tty, strerror (errno));
+      fprintf(stderr,"error: reading from %s failed (%s)\n", dev->tty, err == 0 ? "connection closed" : strerror (errno));
       return -1;
   }
 
@@ -221,30 +271,81 @@ int32_t conbee_write_byte(struct conbee_device *dev, uint8_t c)
 
 
 /**
-* @brief helper function to receive one byte from the tty to the conbee stick
+* @brief helper function to transmit a buffer through the tty to the conbee stick
 *
-* @param dev - pointer to a conbee_device structure, please make sure the device is already connected
-* @param  c  - the byte to receive
+* @param dev    - pointer to a conbee_device structure, please make sure the device is already connected
+* @param buffer - the bytes to transfer
+* @param length - the number of bytes to transfer
 *
 * @return 0   - everything went fine
 * @return -1  - error occured, use errno to find out what
 * @return -2  - conbee device is not connected
 */
-int32_t conbee_read_byte(struct conbee_device *dev, uint8_t *c)
+int32_t conbee_write_buffer(struct conbee_device *dev, uint8_t *buffer, uint32_t length)
+{
+  struct iovec iov;
+
+  iov.iov_base = buffer;
+  iov.iov_len  = length;
+
+  return conbee_write_iov(dev, &iov, 1);
+}
+
+
+/**
+* @brief helper function to transmit many buffers at once through the transport to the conbee stick
+*
+* @param dev    - pointer to a conbee_device structure, please make sure the device is already connected
+* @param iov    - the buffers to transfer, modified while transferring
+* @param iovcnt - the number of buffers
+*
+* @return 0   - everything went fine
+* @return -1  - error occured, use errno to find out what
+* @return -2  - conbee device is not connected
+*/
+int32_t conbee_write_iov(struct conbee_device *dev, struct iovec *iov, int iovcnt)
 {
   // variable for error codes
-  int32_t err = 0;
+  ssize_t err = 0;
 
   if (dev->tty_status == TTY_DISCONNECTED)
   {
     return -2;
   }
 
-  err=read(dev->fd, c, 1);
-  if (err < 0)
+  for(int i = 0; i < iovcnt; i++)
+  {
+    conbee_wire_trace_record(dev, CONBEE_TRACE_TX, iov[i].iov_base, iov[i].iov_len);
+    conbee_capture_record(dev, CONBEE_TRACE_TX, iov[i].iov_base, iov[i].iov_len);
+  }
+
+  while(iovcnt > 0)
   {
-      fprintf(stderr,"error: reading from %s failed (%s)\n", dev->tty, strerror (errno));
+    err=dev->transport.ops->writev(&dev->transport, iov, iovcnt);
+    if (err < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+
+      fprintf(stderr,"error: writing to %s failed (%s)\n", dev->tty, strerror (errno));
       return -1;
+    }
+
+    // skip everything written, the transport may stop in the middle of a buffer
+    while(iovcnt > 0 && (size_t) err >= iov->iov_len)
+    {
+      err -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+
+    if (iovcnt > 0)
+    {
+      iov->iov_base  = (uint8_t *) iov->iov_base + err;
+      iov->iov_len  -= err;
+    }
   }
 
   return 0;
@@ -263,16 +364,38 @@ int32_t conbee_read_byte(struct conbee_device *dev, uint8_t *c)
 */
 int32_t conbee_write_frame(struct conbee_device *dev, struct conbee_frame *frame)
 {
-  // variable for error codes
-  int32_t err = 0;
-
-  uint8_t buffer[1000];
+  uint8_t buffer[CONBEE_FRAME_MAX_ENCODED];
+  struct iovec iov;
 
   if (dev->tty_status == TTY_DISCONNECTED)
   {
     return -2;
   }
 
+  iov.iov_base = buffer;
+  iov.iov_len  = conbee_encode_frame(frame, buffer);
+
+  CONBEE_PROBE_FRAME(frame__write, frame);
+
+  // frames written directly are only written by the worker, e.g. watchdog refreshes
+  conbee_stats_transmitted(dev, &frame, &iov, 1);
+
+  return conbee_write_iov(dev, &iov, 1);
+}
+
+/**
+* @brief serialize a frame including checksum and slip encode it
+*
+* @param frame  - the frame to encode, the status is set to zero as on all requests
+* @param output - buffer of CONBEE_FRAME_MAX_ENCODED bytes receiving the encoded frame
+*
+* @return the number of bytes written to output
+*/
+uint32_t conbee_encode_frame(struct conbee_frame *frame, uint8_t *output)
+{
+  uint8_t buffer[1000];
+  uint32_t length = 0;
+
   // status is always zero on requests
   frame->status=0;
 
@@ -288,15 +411,15 @@ int32_t conbee_write_frame(struct conbee_device *dev, struct conbee_frame *frame
     memcpy(&buffer[5+sizeof(frame->payload_length)],frame->payload,frame->payload_length);
   }
 
-
   // generate crc16
   uint16_t crc = crc16(buffer, frame->length);
   memcpy(&buffer[frame->length],&crc,sizeof(crc));
 
-  slip_transmit_packet(dev,buffer, frame->length+sizeof(crc));
-
+  output[length++] = END;
+  length += slip_encode(buffer, frame->length+sizeof(crc), &output[length]);
+  output[length++] = END;
 
-  return 0;
+  return length;
 }
 
 /**
@@ -322,38 +445,66 @@ int32_t conbee_read_frame(struct conbee_device *dev, struct conbee_frame *frame)
 
   err = slip_receive_packet(dev,buffer,1500);
 
+  if (err > 0 && conbee_decode_frame(dev, buffer, err, frame) < 0)
+  {
+    return -2;
+  }
+
   if (err > 0)
   {
+    CONBEE_PROBE_FRAME(frame__read, frame);
+  }
 
-    // generate the crc and check if is equal
-    uint16_t crc  = crc16(buffer,err-sizeof(crc));
-    uint16_t crc2;
-    memcpy(&crc2,&buffer[err-2],2);
+  return err;
+}
 
-    if (crc != crc2)
-    {
-      fprintf(stderr,"error: receiving from %s (wrong crc)\n", dev->tty);
-      return -2;
-    }
+/**
+* @brief check the checksum of a received slip decoded packet and create the frame from it
+*
+* @param dev    - the conbee_device the packet was received from
+* @param buffer - the slip decoded packet
+* @param length - the length of the packet including the checksum
+* @param frame  - the frame, the function allocates enough space for the payload if required, free it with conbee_free_frame
+*
+* @return   0 - everything went fine
+* @return  -1 - the packet is too short or its checksum is wrong
+*/
+int32_t conbee_decode_frame(struct conbee_device *dev, uint8_t *buffer, uint32_t length, struct conbee_frame *frame)
+{
+  uint16_t crc2;
 
-    // create the frame from the buffer
-    frame->command          = buffer[0];
-    frame->sequence_number  = buffer[1];
-    frame->status           = buffer[2];
+  if (length < 5 + sizeof(crc2))
+  {
+    fprintf(stderr,"error: receiving from %s (frame too short)\n", dev->tty);
+    return -1;
+  }
 
-    memcpy(&frame->length,&buffer[3],2);
+  // generate the crc and check if is equal
+  uint16_t crc  = crc16(buffer,length-sizeof(crc));
+  memcpy(&crc2,&buffer[length-2],2);
 
-    // if we have some payload
-    if (err > 5)
-    {
-      frame->payload_length=err-5-sizeof(crc);
-      frame->payload = (uint8_t *)malloc(frame->payload_length);
-      memcpy(frame->payload, &buffer[5],frame->payload_length);
-    }
+  if (crc != crc2)
+  {
+    fprintf(stderr,"error: receiving from %s (wrong crc)\n", dev->tty);
+    return -1;
+  }
 
+  // create the frame from the buffer
+  frame->command          = buffer[0];
+  frame->sequence_number  = buffer[1];
+  frame->status           = buffer[2];
+
+  memcpy(&frame->length,&buffer[3],2);
+
+  // if we have some payload
+  if (length > 5 + sizeof(crc))
+  {
+    frame->payload_length=length-5-sizeof(crc);
+    frame->payload = (uint8_t *)malloc(frame->payload_length);
+    memcpy(frame->payload, &buffer[5],frame->payload_length);
   }
 
-  return err;
+  return 0;
 }
 
 /**
@@ -558,6 +709,11 @@ struct conbee_frame * conbee_init_frame()
   frame->status           = 0;
   frame->payload_length   = 0;
   frame->payload          = NULL;
+  frame->wire             = NULL;
+  frame->wire_length      = 0;
+  frame->enqueued_us      = 0;
+  frame->wire_frames      = 0;
+  memset(&frame->timestamps, 0, sizeof(frame->timestamps));
 
   return frame;
 }
@@ -583,6 +739,12 @@ void conbee_free_frame(struct conbee_frame *frame)
     free(frame->payload);
   }
 
+  if (frame->wire != NULL)
+  {
+    frame->wire_length=0;
+    free(frame->wire);
+  }
+
   free(frame);
 }
 
@@ -627,6 +789,43 @@ struct conbee_frame * conbee_read_parameter_request(uint8_t parameter)
   return frame;
 }
 
+/**
+* @brief parse a read_parameter_response into a conbee_parameter
+*
+* @param frame     - the read parameter response
+* @param parameter - the parameter to fill, the status is set even if the frame carries no value
+*
+* @return   0 - everything worked fine
+* @return  -1 - no value available in frame
+*/
+int32_t conbee_read_parameter_response(struct conbee_frame *frame, struct conbee_parameter *parameter)
+{
+  parameter->status = frame->status;
+  parameter->length = 0;
+  memset(parameter->value.bytes, 0, PARAMETER_MAX_LENGTH);
+
+  if (frame->command != COMMAND_READ_PARAMETER || frame->status != STATUS_SUCCESS)
+  {
+    return -1;
+  }
+
+  /*
+  * a read parameter response always has as payload the payload length and the paramter id
+  * therefore, we have to skip the first 3 bytes of the payload
+  */
+  if (frame->payload == NULL || frame->payload_length < 3 || frame->payload_length - 3 > PARAMETER_MAX_LENGTH)
+  {
+    parameter->status = STATUS_INVALID_VALUE;
+    return -1;
+  }
+
+  parameter->id     = frame->payload[2];
+  parameter->length = frame->payload_length - 3;
+  memcpy(parameter->value.bytes, &frame->payload[3], parameter->length);
+
+  return 0;
+}
+
 /**
 * @brief parse a read_parameter_response into a uint64_t
 *
@@ -891,48 +1090,278 @@ struct conbee_frame * conbee_device_network_leave_request()
 }
 
 /**
-* @brief parse a device state response and return a device state structure
+* @brief return the raw device state byte carried by a frame
 *
-* @param  frame - pointer to the frame to parse
-* @param  state - pointer to the state to save the state in
+* @param  frame      - pointer to the frame to parse
+* @param  state_byte - the device state byte as sent by the stick
 *
 * @return   0 - everything worked fine
 * @return  -1 - no state information could be found
 */
-int32_t conbee_device_state_response(struct conbee_frame *frame, struct conbee_device_state *state)
+int32_t conbee_device_state_byte(struct conbee_frame *frame, uint8_t *state_byte)
 {
+  uint16_t index;
 
-  uint8_t stateByte;
-
-  // there are two responses containing state information
+  // there are three responses containing state information
   switch(frame->command)
   {
     case COMMAND_DEVICE_STATE:
-                              stateByte = frame->payload[1];
+                              index = 0;
                               break;
 
     case COMMAND_DEVICE_STATE_CHANGED:
-                              stateByte = frame->payload[0];
+                              index = 0;
                               break;
 
     case COMMAND_APS_DATA_INDICATION:
-                              stateByte = frame->payload[3];
+                              // skip the payload length
+                              index = 2;
                               break;
 
     default:
                               return -1;
   }
 
+  // frames received with an error may not have a payload at all
+  if (frame->payload == NULL || frame->payload_length <= index)
+  {
+    return -1;
+  }
+
+  *state_byte = frame->payload[index];
+
+  return 0;
+}
+
+/**
+* @brief split a raw device state byte into a device state structure
+*
+* @param  stateByte - the device state byte as sent by the stick
+* @param  state     - pointer to the state to save the state in
+*/
+void conbee_device_state_decode(uint8_t stateByte, struct conbee_device_state *state)
+{
   state->network_state                  = stateByte & 0x03;
   state->apsde_data_confirm             = stateByte & 0x04;
   state->apsde_data_indication          = stateByte & 0x08;
   state->configuration_changed          = stateByte & 0x10;
   state->apsde_data_request_free_slots  = stateByte & 0x20;
+}
+
+/**
+* @brief parse a device state response and return a device state structure
+*
+* @param  frame - pointer to the frame to parse
+* @param  state - pointer to the state to save the state in
+*
+* @return   0 - everything worked fine
+* @return  -1 - no state information could be found
+*/
+int32_t conbee_device_state_response(struct conbee_frame *frame, struct conbee_device_state *state)
+{
+  uint8_t stateByte;
+
+  if (conbee_device_state_byte(frame, &stateByte) < 0)
+  {
+    return -1;
+  }
+
+  conbee_device_state_decode(stateByte, state);
 
   return 0;
 }
 
 
+/**
+* @brief helper reading an unsigned little endian value of the given width out of a payload
+*
+* @param payload - the payload to read from
+* @param length  - the number of bytes of the payload
+* @param index   - the index to read from, advanced by width on success
+* @param width   - the number of bytes to read, 1 to 8
+* @param value   - the value read
+*
+* @return   0 - everything worked fine
+* @return  -1 - the value is outside the payload
+*/
+static int32_t conbee_payload_read(uint8_t *payload, uint16_t length, uint16_t *index, uint8_t width, uint64_t *value)
+{
+  if (*index + width > length)
+  {
+    return -1;
+  }
+
+  *value = 0;
+  for(uint8_t i = 0; i < width; i++)
+  {
+    *value |= ((uint64_t) payload[*index + i]) << (8*i);
+  }
+  *index += width;
+
+  return 0;
+}
+
+/**
+* @brief parse an aps data indication response
+*
+* the asdu pointer of the indication points into the payload of the frame, so the frame
+* has to be kept until the indication is no longer used
+*
+* @param  frame      - pointer to the frame to parse
+* @param  indication - pointer to the indication to fill
+*
+* @return   0 - everything worked fine
+* @return  -1 - the frame is no valid aps data indication
+*/
+int32_t conbee_aps_indication_response(struct conbee_frame *frame, struct conbee_aps_indication *indication)
+{
+  uint8_t *payload = frame->payload;
+  uint16_t length  = frame->payload_length;
+  uint16_t index   = 2;  // skip the payload length
+  uint64_t value   = 0;
+
+  if (frame->command != COMMAND_APS_DATA_INDICATION || frame->status != STATUS_SUCCESS || payload == NULL)
+  {
+    return -1;
+  }
+
+  memset(indication, 0, sizeof(struct conbee_aps_indication));
+
+  if (conbee_payload_read(payload, length, &index, 1, &value) < 0)
+  {
+    return -1;
+  }
+  indication->device_state = value;
+
+  // destination address, the endpoint is only present for unicasts
+  if (conbee_payload_read(payload, length, &index, 1, &value) < 0)
+  {
+    return -1;
+  }
+  indication->dst_addr_mode = value;
+
+  switch(indication->dst_addr_mode)
+  {
+    case DEST_ADDR_GROUP:
+    case DEST_ADDR_NWK:
+                          if (conbee_payload_read(payload, length, &index, 2, &value) < 0)
+                          {
+                            return -1;
+                          }
+                          indication->dst_addr = value;
+                          break;
+
+    case DEST_ADDR_IEEE:
+                          if (conbee_payload_read(payload, length, &index, 8, &value) < 0)
+                          {
+                            return -1;
+                          }
+                          indication->dst_ieee_addr = value;
+                          break;
+
+    default:
+                          return -1;
+  }
+
+  if (indication->dst_addr_mode != DEST_ADDR_GROUP)
+  {
+    if (conbee_payload_read(payload, length, &index, 1, &value) < 0)
+    {
+      return -1;
+    }
+    indication->dst_endpoint = value;
+  }
+
+  // source address, NWK and IEEE address may be present both
+  if (conbee_payload_read(payload, length, &index, 1, &value) < 0)
+  {
+    return -1;
+  }
+  indication->src_addr_mode = value;
+
+  switch(indication->src_addr_mode)
+  {
+    case DEST_ADDR_NWK:
+                          if (conbee_payload_read(payload, length, &index, 2, &value) < 0)
+                          {
+                            return -1;
+                          }
+                          indication->src_addr = value;
+                          break;
+
+    case DEST_ADDR_IEEE:
+                          if (conbee_payload_read(payload, length, &index, 8, &value) < 0)
+                          {
+                            return -1;
+                          }
+                          indication->src_ieee_addr = value;
+                          break;
+
+    case SRC_ADDR_NWK_IEEE:
+                          if (conbee_payload_read(payload, length, &index, 2, &value) < 0)
+                          {
+                            return -1;
+                          }
+                          indication->src_addr = value;
+
+                          if (conbee_payload_read(payload, length, &index, 8, &value) < 0)
+                          {
+                            return -1;
+                          }
+                          indication->src_ieee_addr = value;
+                          break;
+
+    default:
+                          return -1;
+  }
+
+  if (conbee_payload_read(payload, length, &index, 1, &value) < 0)
+  {
+    return -1;
+  }
+  indication->src_endpoint = value;
+
+  if (conbee_payload_read(payload, length, &index, 2, &value) < 0)
+  {
+    return -1;
+  }
+  indication->profile_id = value;
+
+  if (conbee_payload_read(payload, length, &index, 2, &value) < 0)
+  {
+    return -1;
+  }
+  indication->cluster_id = value;
+
+  if (conbee_payload_read(payload, length, &index, 2, &value) < 0)
+  {
+    return -1;
+  }
+  indication->asdu_length = value;
+
+  if (index + indication->asdu_length > length)
+  {
+    return -1;
+  }
+  indication->asdu = &payload[index];
+  index += indication->asdu_length;
+
+  // two reserved bytes, lqi, four reserved bytes and rssi follow if the firmware sends them
+  index += 2;
+  if (conbee_payload_read(payload, length, &index, 1, &value) == 0)
+  {
+    indication->lqi = value;
+
+    index += 4;
+    if (conbee_payload_read(payload, length, &index, 1, &value) == 0)
+    {
+      indication->rssi = (int8_t) value;
+    }
+  }
+
+  return 0;
+}
+
 /**
 * @brief create a frame for requesting available APS data
 *
@@ -975,19 +1404,70 @@ struct conbee_frame * conbee_device_get_aps_data_request()
 * @return  -2 - conbee device is not connected
 */
 int32_t conbee_enqueue_frame(struct conbee_device *dev, struct conbee_frame *frame)
+{
+  // set the sequence number in the frame
+  uint8_t sequence_number = conbee_reserve_sequence_numbers(dev, 1);
+  frame->sequence_number  = sequence_number;
+
+  // the worker may already have sent and freed the frame when conbee_push_frame returns
+  conbee_push_frame(dev, frame);
+
+  return sequence_number;
+}
+
+/**
+* @brief reserve consecutive sequence numbers for requests
+*
+* @param dev - the device to reserve the sequence numbers at
+* @param n   - the number of sequence numbers to reserve
+*
+* @return the first reserved sequence number
+*/
+uint8_t conbee_reserve_sequence_numbers(struct conbee_device *dev, uint16_t n)
 {
   uint8_t sequence_number = 0;
 
   pthread_mutex_lock(&dev->mutex_sequence_number);
   sequence_number = dev->sequence_number;
-  dev->sequence_number++;
+  dev->sequence_number+=n;
   pthread_mutex_unlock(&dev->mutex_sequence_number);
 
-  // set the sequence number in the frame
-  frame->sequence_number=sequence_number;
+  return sequence_number;
+}
+
+/**
+* @brief push a frame with an already assigned sequence number to the send queue and wake up the worker
+*
+* @param dev   - the device to send the frame with
+* @param frame - the frame to send, it is freed after transmission
+*/
+void conbee_push_frame(struct conbee_device *dev, struct conbee_frame *frame)
+{
+  conbee_push_frames(dev, &frame, 1);
+}
+
+/**
+* @brief push frames with already assigned sequence numbers to the send queue and wake up the worker once
+*
+* @param dev    - the device to send the frames with
+* @param frames - array of n frames to send, they are freed after transmission
+* @param n      - the number of frames
+*/
+void conbee_push_frames(struct conbee_device *dev, struct conbee_frame **frames, uint16_t n)
+{
+  // both clocks are monotonic, so enabled timestamps save the second clock read
+  uint64_t stamp = conbee_timestamp(dev);
+  uint64_t now   = stamp != 0 ? stamp / 1000 : conbee_now_us();
 
   pthread_mutex_lock(&dev->mutex_send_queue);
-  conbee_queue_push(&dev->send_queue, (void *) frame);
+  for(uint16_t i = 0; i < n; i++)
+  {
+    frames[i]->enqueued_us            = now;
+    frames[i]->timestamps.enqueued_ns = stamp;
+    CONBEE_PROBE_FRAME(frame__enqueue, frames[i]);
+    conbee_queue_push(&dev->send_queue, (void *) frames[i]);
+  }
+  conbee_stats_queue_depth(&dev->stats.send_queue_depth, &dev->stats.send_queue_high_water, n);
   pthread_mutex_unlock(&dev->mutex_send_queue);
 
   // wake up transmitter
@@ -995,9 +1475,6 @@ int32_t conbee_enqueue_frame(struct conbee_device *dev, struct conbee_frame *fra
   pthread_mutex_lock(&dev->mutex_send_pipe);
   write(dev->pipe_send_queue[1],buf,2);
   pthread_mutex_unlock(&dev->mutex_send_pipe);
-
-
-  return sequence_number;
 }
 
 
@@ -1021,6 +1498,8 @@ int32_t conbee_wait_for_frame(struct conbee_device *dev, struct conbee_frame **f
   struct conbee_frame *help_frame = NULL;
   time_t current_time = time(NULL);
 
+  CONBEE_PROBE2(wait__begin, command, sequence_number);
+
   // lock reception queue and search for message
   pthread_mutex_lock(&dev->mutex_receive_queue);
 
@@ -1036,31 +1515,157 @@ int32_t conbee_wait_for_frame(struct conbee_device *dev, struct conbee_frame **f
       {
         found = 1;
         conbee_queue_delete(&dev->receive_queue, item);
+        conbee_stats_queue_depth(&dev->stats.receive_queue_depth, &dev->stats.receive_queue_high_water, -1);
         break;
       }
       else if (help_frame->command == command && help_frame->sequence_number == sequence_number)
       {
         found = 1;
         conbee_queue_delete(&dev->receive_queue, item);
+        conbee_stats_queue_depth(&dev->stats.receive_queue_depth, &dev->stats.receive_queue_high_water, -1);
         break;
       }
       else
       {
         help_frame = NULL;
       }
+
+      item = item->next;
     }
-    pthread_mutex_unlock(&dev->mutex_receive_queue);
 
     if (found)
     {
+      pthread_mutex_unlock(&dev->mutex_receive_queue);
+      CONBEE_PROBE_FRAME(wait__end, help_frame);
+      conbee_timestamps_woken(dev, help_frame);
       *frame = help_frame;
       return 0;
     }
 
-    pthread_mutex_lock(&dev->mutex_receive_queue);
+    // keep the queue locked until waiting, otherwise a frame pushed in between is missed
     pthread_cond_wait(&dev->cond_receive_queue, &dev->mutex_receive_queue);
   }
 
 
   return 0;
 }
+
+
+/**
+* @brief wait for the reception of many frames at once
+*
+* returns as soon as a frame for every sequence number has been received, the frames are
+* stored in the order of the sequence numbers. Free the frames after processing !!!
+*
+* @param dev              - the conbee_device to read the frames from, make sure it is already connected
+* @param frames           - array of n pointers receiving the frames
+* @param sequence_numbers - array of n distinct sequence numbers to wait for
+* @param n                - the number of frames to wait for, at most 256
+* @param command          - wait for this command type or COMMAND_ANY
+*
+* @return   0 - everything went fine, all frames are received
+* @return  -1 - error occured, use ernno to find out what
+*/
+int32_t conbee_wait_for_frames(struct conbee_device *dev, struct conbee_frame **frames, uint8_t *sequence_numbers, uint16_t n, uint8_t command)
+{
+  // index into frames for every sequence number, -1 if not waited for
+  int16_t slot[256];
+  uint16_t missing = n;
+
+  if (n > 256)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  for(uint16_t i = 0; i < 256; i++)
+  {
+    slot[i] = -1;
+  }
+
+  for(uint16_t i = 0; i < n; i++)
+  {
+    if (slot[sequence_numbers[i]] >= 0)
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+    slot[sequence_numbers[i]] = i;
+    frames[i] = NULL;
+  }
+
+  CONBEE_PROBE2(wait__many__begin, command, n);
+
+  // lock reception queue and collect the frames as they arrive
+  pthread_mutex_lock(&dev->mutex_receive_queue);
+
+  while(missing > 0)
+  {
+    struct conbee_queue_item *item = dev->receive_queue.head;
+
+    while(item != NULL)
+    {
+      struct conbee_queue_item *next = item->next;
+      struct conbee_frame *help_frame = (struct conbee_frame *) item->contents;
+      int16_t index = slot[help_frame->sequence_number];
+
+      if (index >= 0 && frames[index] == NULL && (command == COMMAND_ANY || help_frame->command == command))
+      {
+        frames[index] = help_frame;
+        conbee_queue_delete(&dev->receive_queue, item);
+        conbee_stats_queue_depth(&dev->stats.receive_queue_depth, &dev->stats.receive_queue_high_water, -1);
+        missing--;
+      }
+
+      item = next;
+    }
+
+    if (missing > 0)
+    {
+      pthread_cond_wait(&dev->cond_receive_queue, &dev->mutex_receive_queue);
+    }
+  }
+
+  pthread_mutex_unlock(&dev->mutex_receive_queue);
+
+  for(uint16_t i = 0; i < n; i++)
+  {
+    CONBEE_PROBE_FRAME(wait__end, frames[i]);
+    conbee_timestamps_woken(dev, frames[i]);
+  }
+
+  return 0;
+}
+
+/**
+* @brief take the oldest received frame without waiting
+*
+* free the frame after processing !!!
+*
+* @param dev   - the conbee_device to read the frame from, make sure it is already connected
+* @param frame - the frame received
+*
+* @return   1 - a frame has been taken
+* @return   0 - no frame has been received
+*/
+int32_t conbee_poll_frame(struct conbee_device *dev, struct conbee_frame **frame)
+{
+  pthread_mutex_lock(&dev->mutex_receive_queue);
+  struct conbee_frame *help_frame = (struct conbee_frame *) conbee_queue_pop(&dev->receive_queue);
+  if (help_frame != NULL)
+  {
+    conbee_stats_queue_depth(&dev->stats.receive_queue_depth, &dev->stats.receive_queue_high_water, -1);
+  }
+  pthread_mutex_unlock(&dev->mutex_receive_queue);
+
+  if (help_frame == NULL)
+  {
+    return 0;
+  }
+
+  conbee_timestamps_woken(dev, help_frame);
+  *frame = help_frame;
+
+  return 1;
+}
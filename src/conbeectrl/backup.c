@@ -0,0 +1,245 @@
+#include <conbee.h>
+#include <conbeectrl/backup.h>
+#include <crc16.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <errno.h>
+#include <argparse.h>
+
+/// the largest backup, every parameter id once with its longest value
+#define BACKUP_MAX_RECORDS    (256 * (2 + PARAMETER_MAX_LENGTH))
+
+/**
+* @brief parse the file argument shared by backup and restore
+*
+* @return  0 - everything went fine
+* @return -1 - the file argument is missing
+*/
+static int backup_arguments(int argc, char **argv, char *file_name, int maxlen, const char *description)
+{
+  struct arg_parse_ctx *argparse_ctx = argparse_init();
+
+  // argument for the backup file
+  struct arg_str file_arg = {
+      {ARG_STR,1,0},
+      'f',
+      "file",
+      file_name,
+      maxlen,
+      description,
+  };
+  argparse_add_string(argparse_ctx, &file_arg);
+
+  /// parse the commandline
+  int ret=argparse_parse(argparse_ctx, argc, argv);
+
+  /// free context
+  argparse_free(argparse_ctx);
+
+  return ret < 0 || file_name[0] == 0 ? -1 : 0;
+}
+
+int backup(struct conbee_device *dev, int argc, char **argv)
+{
+  const struct conbee_parameter_descriptor *descriptors;
+  struct conbee_parameter results[256];
+  struct backup_header header;
+  uint8_t ids[256];
+  uint8_t *records;
+  uint32_t length = 0;
+  uint16_t nr_descriptors;
+  uint16_t n = 0;
+  char file_name[200] = "";
+
+  if (backup_arguments(argc, argv, file_name, 199, "the file to write the backup to") < 0)
+  {
+    return -1;
+  }
+
+  descriptors = conbee_parameter_descriptors(&nr_descriptors);
+  for(uint16_t i = 0; i < nr_descriptors; i++)
+  {
+    if (descriptors[i].flags & PARAMETER_READABLE)
+    {
+      ids[n++] = descriptors[i].id;
+    }
+  }
+
+  // the cache may hold values read before another process changed them
+  conbee_enable_parameter_cache(dev, 0);
+
+  // parameters the firmware does not support are left out, the others have to be read
+  int32_t ret = conbee_read_parameters(dev, ids, n, results);
+  if (ret < 0 && !(ret == -1 && errno == EIO))
+  {
+    fprintf(stderr, "Error: reading the parameters failed (%s)\n", ret == -2 ? "not connected" : strerror(errno));
+    return -1;
+  }
+
+  records = malloc(BACKUP_MAX_RECORDS);
+  if (records == NULL)
+  {
+    return -1;
+  }
+
+  memset(&header, 0, sizeof(header));
+  header.magic        = BACKUP_MAGIC;
+  header.version      = BACKUP_VERSION;
+  header.header_size  = sizeof(header);
+  header.created      = time(NULL);
+
+  for(uint16_t i = 0; i < n; i++)
+  {
+    if (results[i].status != STATUS_SUCCESS)
+    {
+      fprintf(stderr, "Warning: %s not supported by the stick, left out\n", conbee_parameter_descriptor(ids[i])->name);
+      continue;
+    }
+
+    records[length++] = results[i].id;
+    records[length++] = results[i].length;
+    memcpy(&records[length], results[i].value.bytes, results[i].length);
+    length += results[i].length;
+    header.nr_parameters++;
+  }
+
+  header.crc = crc16(records, length);
+
+  FILE *file = fopen(file_name, "w");
+  if (file == NULL)
+  {
+    perror("Error: creating backup failed");
+    free(records);
+    return -1;
+  }
+
+  int err = fwrite(&header, sizeof(header), 1, file) != 1 || fwrite(records, 1, length, file) != length;
+  err |= fclose(file) != 0;
+  free(records);
+
+  if (err)
+  {
+    perror("Error: writing backup failed");
+    return -1;
+  }
+
+  printf("Backup of %u parameters written to %s\n", header.nr_parameters, file_name);
+
+  return 0;
+}
+
+int restore(struct conbee_device *dev, int argc, char **argv)
+{
+  struct conbee_parameter parameters[256];
+  struct backup_header header;
+  uint8_t *records;
+  size_t length;
+  uint16_t n = 0;
+  char file_name[200] = "";
+
+  if (backup_arguments(argc, argv, file_name, 199, "the backup to restore") < 0)
+  {
+    return -1;
+  }
+
+  FILE *file = fopen(file_name, "r");
+  if (file == NULL)
+  {
+    perror("Error: opening backup failed");
+    return -1;
+  }
+
+  records = malloc(BACKUP_MAX_RECORDS + 1);
+  if (records == NULL)
+  {
+    fclose(file);
+    return -1;
+  }
+
+  // newer versions may append to the header, older readers skip it
+  if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != BACKUP_MAGIC || header.version != BACKUP_VERSION ||
+      header.header_size < sizeof(header) || fseek(file, header.header_size, SEEK_SET) != 0)
+  {
+    fprintf(stderr, "Error: %s is no valid backup\n", file_name);
+    fclose(file);
+    free(records);
+    return -1;
+  }
+
+  length = fread(records, 1, BACKUP_MAX_RECORDS + 1, file);
+  fclose(file);
+
+  if (length > BACKUP_MAX_RECORDS || crc16(records, length) != header.crc)
+  {
+    fprintf(stderr, "Error: %s is corrupted\n", file_name);
+    free(records);
+    return -1;
+  }
+
+  for(size_t index = 0, i = 0; i < header.nr_parameters; i++)
+  {
+    if (index + 2 > length || index + 2 + records[index + 1] > length)
+    {
+      fprintf(stderr, "Error: %s is truncated\n", file_name);
+      free(records);
+      return -1;
+    }
+
+    uint8_t id                                           = records[index];
+    uint8_t value_length                                 = records[index + 1];
+    const struct conbee_parameter_descriptor *descriptor = conbee_parameter_descriptor(id);
+    uint8_t *value                                       = &records[index + 2];
+
+    index += 2 + value_length;
+
+    // read only parameters like the mac address belong to the stick, the watchdog to the running application
+    if (descriptor == NULL || !(descriptor->flags & PARAMETER_WRITABLE) || id == PARAM_WATCHDOG_TTL)
+    {
+      continue;
+    }
+
+    if (value_length != descriptor->length)
+    {
+      fprintf(stderr, "Error: %s has a wrong length for %s\n", file_name, descriptor->name);
+      free(records);
+      return -1;
+    }
+
+    memset(&parameters[n], 0, sizeof(parameters[n]));
+    parameters[n].id     = id;
+    parameters[n].length = value_length;
+    memcpy(parameters[n].value.bytes, value, value_length);
+    n++;
+  }
+
+  free(records);
+
+  if (n == 0)
+  {
+    fprintf(stderr, "Error: %s holds no writable parameters\n", file_name);
+    return -1;
+  }
+
+  int32_t err = conbee_write_parameters(dev, parameters, n, WRITE_PARAMETERS_VERIFY | WRITE_PARAMETERS_ROLLBACK);
+  if (err < 0)
+  {
+    for(uint16_t i = 0; i < n; i++)
+    {
+      if (parameters[i].status != STATUS_SUCCESS)
+      {
+        fprintf(stderr, "Error: restoring %s failed (status 0x%02x)\n", conbee_parameter_descriptor(parameters[i].id)->name,
+                parameters[i].status);
+      }
+    }
+
+    fprintf(stderr, err == -3 ? "Error: rolling back failed, the configuration is partially restored\n" :
+                                "Error: restoring failed, the configuration is unchanged\n");
+    return -1;
+  }
+
+  printf("Restored and verified %u parameters from %s\n", n, file_name);
+
+  return 0;
+}
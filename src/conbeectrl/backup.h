@@ -0,0 +1,64 @@
+#ifndef __CONNBEECTRL_BACKUP_H__
+#define __CONNBEECTRL_BACKUP_H__
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file */
+#include<conbee.h>
+
+/// magic number at the start of a backup ("CBBK")
+#define BACKUP_MAGIC          0x4b424243
+
+/// version of the backup format
+#define BACKUP_VERSION        1
+
+/**
+* @brief header at the start of a backup file
+*
+* the header is followed by nr_parameters records, each one the parameter id, the
+* number of value bytes and the value as transmitted by the stick
+*/
+struct backup_header
+{
+  /// BACKUP_MAGIC
+  uint32_t magic;
+
+  /// BACKUP_VERSION
+  uint16_t version;
+
+  /// number of bytes of this header, the first record starts right after it
+  uint16_t header_size;
+
+  /// wall clock time the backup was taken in seconds since the epoch
+  uint64_t created;
+
+  /// number of parameter records
+  uint16_t nr_parameters;
+
+  /// crc16 of all records
+  uint16_t crc;
+
+  /// reserved, always 0
+  uint32_t reserved;
+};
+
+int backup(struct conbee_device *dev, int argc, char **argv);
+
+int restore(struct conbee_device *dev, int argc, char **argv);
+
+
+#endif
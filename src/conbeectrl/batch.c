@@ -0,0 +1,327 @@
+#include <conbee.h>
+#include <conbeectrl/commands.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <argparse.h>
+
+/// the longest line of a batch
+#define BATCH_MAX_LINE      4096
+
+/// the maximum number of words of one line
+#define BATCH_MAX_WORDS     128
+
+/**
+* @brief line reader which knows whether more lines are available without blocking
+*/
+struct batch_reader
+{
+  /// the file descriptor to read from
+  int fd;
+
+  /// the bytes read but not yet returned as line
+  char buffer[2 * BATCH_MAX_LINE];
+
+  /// index of the first byte not yet returned
+  size_t start;
+
+  /// number of valid bytes within buffer
+  size_t end;
+
+  /// set once the end of the input has been reached
+  uint8_t eof;
+};
+
+/**
+* @brief one line of the batch split into words
+*/
+struct batch_line
+{
+  /// the line, the words point into it
+  char text[BATCH_MAX_LINE];
+
+  /// the words of the line, terminated by NULL
+  char *words[BATCH_MAX_WORDS + 1];
+
+  /// the number of the line within the input
+  int number;
+};
+
+/**
+* @brief check if a complete line is buffered
+*/
+static uint8_t batch_line_buffered(struct batch_reader *reader)
+{
+  return memchr(&reader->buffer[reader->start], '\n', reader->end - reader->start) != NULL ||
+         (reader->eof && reader->end > reader->start);
+}
+
+/**
+* @brief check if the next line can be read without waiting for the writer of the input
+*/
+static uint8_t batch_line_available(struct batch_reader *reader)
+{
+  struct pollfd pfd = {reader->fd, POLLIN, 0};
+
+  return batch_line_buffered(reader) || (!reader->eof && poll(&pfd, 1, 0) > 0);
+}
+
+/**
+* @brief read the next line, blocking until it is complete
+*
+* @return  1 - line read, without the newline
+* @return  0 - end of the input
+* @return -1 - reading failed or the line is too long
+*/
+static int batch_read_line(struct batch_reader *reader, char *line)
+{
+  while(!batch_line_buffered(reader))
+  {
+    if (reader->eof)
+    {
+      return 0;
+    }
+
+    // keep the partial line at the start of the buffer
+    memmove(reader->buffer, &reader->buffer[reader->start], reader->end - reader->start);
+    reader->end  -= reader->start;
+    reader->start = 0;
+
+    if (reader->end == sizeof(reader->buffer))
+    {
+      fprintf(stderr, "Error: line longer than %d characters\n", BATCH_MAX_LINE - 1);
+      return -1;
+    }
+
+    ssize_t length = read(reader->fd, &reader->buffer[reader->end], sizeof(reader->buffer) - reader->end);
+    if (length < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (length < 0)
+    {
+      perror("Error: reading commands failed");
+      return -1;
+    }
+
+    reader->end += length;
+    reader->eof  = length == 0;
+  }
+
+  char *first   = &reader->buffer[reader->start];
+  char *newline = memchr(first, '\n', reader->end - reader->start);
+  size_t length = newline != NULL ? (size_t) (newline - first) : reader->end - reader->start;
+
+  if (length >= BATCH_MAX_LINE)
+  {
+    fprintf(stderr, "Error: line longer than %d characters\n", BATCH_MAX_LINE - 1);
+    return -1;
+  }
+
+  memcpy(line, first, length);
+  line[length]   = 0;
+  reader->start += length + (newline != NULL);
+
+  return 1;
+}
+
+/**
+* @brief split a line into whitespace separated words, everything after # is ignored
+*
+* @return the number of words, -1 if the line has too many words
+*/
+static int batch_split(struct batch_line *line)
+{
+  int count = 0;
+  char *saveptr;
+
+  char *comment = strchr(line->text, '#');
+  if (comment != NULL)
+  {
+    *comment = 0;
+  }
+
+  for(char *word = strtok_r(line->text, " \t\r", &saveptr); word != NULL; word = strtok_r(NULL, " \t\r", &saveptr))
+  {
+    if (count == BATCH_MAX_WORDS)
+    {
+      return -1;
+    }
+    line->words[count++] = word;
+  }
+  line->words[count] = NULL;
+
+  return count;
+}
+
+/**
+* @brief run the collected invocations and report the line of the first failing one
+*
+* @return  0 - all invocations succeeded
+* @return -1 - an invocation failed
+*/
+static int batch_execute(struct conbee_device *dev, struct conbeectrl_invocation *invocations, int *lines, int n)
+{
+  int done = conbeectrl_execute(dev, invocations, n);
+
+  // stream the results of every group as soon as it is done
+  fflush(stdout);
+
+  if (done < n)
+  {
+    fprintf(stderr, "Error: %s in line %d failed\n", invocations[done].command->name, lines[done]);
+    return -1;
+  }
+
+  return 0;
+}
+
+int batch(struct conbee_device *dev, int argc, char **argv)
+{
+  struct conbeectrl_invocation invocations[CONBEECTRL_MAX_COMMANDS];
+  struct conbeectrl_invocation parsed[CONBEECTRL_MAX_COMMANDS];
+  int lines[CONBEECTRL_MAX_COMMANDS];
+  struct batch_line *group;
+  struct batch_reader *reader;
+  char file_name[200] = "-";
+  int nr_lines        = 0;
+  int number          = 0;
+  int n               = 0;
+  int err             = 0;
+
+  struct arg_parse_ctx *argparse_ctx = argparse_init();
+
+  // argument for the command file
+  struct arg_str file_arg = {
+      {ARG_STR,0,0},
+      'f',
+      "file",
+      file_name,
+      199,
+      "the file to read the commands from, one command line per line (default: - for stdin)",
+  };
+  argparse_add_string(argparse_ctx, &file_arg);
+
+  /// parse the commandline
+  int ret=argparse_parse(argparse_ctx, argc, argv);
+
+  /// free context
+  argparse_free(argparse_ctx);
+
+  if (ret < 0)
+  {
+    return -1;
+  }
+
+  group  = malloc(CONBEECTRL_MAX_COMMANDS * sizeof(struct batch_line));
+  reader = malloc(sizeof(struct batch_reader));
+  if (group == NULL || reader == NULL)
+  {
+    free(group);
+    free(reader);
+    return -1;
+  }
+  memset(reader, 0, sizeof(struct batch_reader));
+
+  reader->fd = strcmp(file_name, "-") == 0 ? STDIN_FILENO : open(file_name, O_RDONLY);
+  if (reader->fd < 0)
+  {
+    perror("Error: opening commands failed");
+    free(group);
+    free(reader);
+    return -1;
+  }
+
+  /*
+  * lines are collected as long as more of them are available without waiting, so a file
+  * is run in large groups while interactive input is answered line by line. The reads of
+  * a group are fetched in one pipelined batch.
+  */
+  while(err == 0)
+  {
+    struct batch_line *line = &group[nr_lines];
+
+    ret = batch_read_line(reader, line->text);
+    if (ret <= 0)
+    {
+      err = ret;
+      break;
+    }
+    line->number = ++number;
+
+    int count = batch_split(line);
+    if (count < 0)
+    {
+      fprintf(stderr, "Error: line %d has more than %d words\n", line->number, BATCH_MAX_WORDS);
+      err = -1;
+      break;
+    }
+
+    int k = conbeectrl_parse(count, line->words, parsed, CONBEECTRL_MAX_COMMANDS);
+    if (k < 0)
+    {
+      fprintf(stderr, "Error: line %d is invalid\n", line->number);
+      err = -1;
+      break;
+    }
+
+    for(int i = 0; i < k && err == 0; i++)
+    {
+      if (parsed[i].command->single || parsed[i].command->direct)
+      {
+        fprintf(stderr, "Error: %s is not supported within a batch (line %d)\n", parsed[i].command->name, line->number);
+        err = -1;
+      }
+    }
+
+    // the group is full, run it and start a new one with this line
+    if (err == 0 && n + k > CONBEECTRL_MAX_COMMANDS)
+    {
+      err = batch_execute(dev, invocations, lines, n);
+      memcpy(&group[0], line, sizeof(struct batch_line));
+
+      // the words have to point into the moved line
+      for(int i = 0; i < count; i++)
+      {
+        group[0].words[i] = group[0].text + (line->words[i] - line->text);
+      }
+      line     = &group[0];
+      k        = conbeectrl_parse(count, line->words, parsed, CONBEECTRL_MAX_COMMANDS);
+      nr_lines = 0;
+      n        = 0;
+    }
+
+    for(int i = 0; i < k && err == 0; i++)
+    {
+      lines[n]         = line->number;
+      invocations[n++] = parsed[i];
+    }
+    nr_lines += k > 0;
+
+    if (err == 0 && n > 0 && (!batch_line_available(reader) || nr_lines == CONBEECTRL_MAX_COMMANDS))
+    {
+      err      = batch_execute(dev, invocations, lines, n);
+      nr_lines = 0;
+      n        = 0;
+    }
+  }
+
+  // the lines before an invalid one are run as if they were read one by one
+  if (n > 0 && batch_execute(dev, invocations, lines, n) < 0)
+  {
+    err = -1;
+  }
+
+  if (reader->fd != STDIN_FILENO)
+  {
+    close(reader->fd);
+  }
+  free(group);
+  free(reader);
+
+  return err < 0 ? -1 : 0;
+}
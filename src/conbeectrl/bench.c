@@ -0,0 +1,196 @@
+#include <conbee.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <argparse.h>
+#include <bench/bench.h>
+
+/// the deepest pipeline measured
+#define BENCH_MAX_DEPTH     255
+
+/**
+* @brief create the request of a workload
+*/
+typedef struct conbee_frame * (*bench_request_fn)(uint8_t parameter);
+
+/**
+* @brief create a parameter read request
+*/
+static struct conbee_frame * bench_read_request(uint8_t parameter)
+{
+  return conbee_read_parameter_request(parameter);
+}
+
+/**
+* @brief create a device state request
+*/
+static struct conbee_frame * bench_state_request(uint8_t parameter)
+{
+  (void) parameter;
+
+  return conbee_device_status_request();
+}
+
+/**
+* @brief count the status of a response and free it
+*/
+static void bench_response(struct bench_result *result, struct conbee_frame *frame)
+{
+  if (conbee_frame_busy(frame))
+  {
+    result->busy++;
+  }
+  else if (!conbee_frame_success(frame))
+  {
+    result->errors++;
+  }
+
+  conbee_free_frame(frame);
+}
+
+/**
+* @brief send n requests in bursts of depth requests and wait for all responses of a burst
+*
+* a depth of 1 measures back to back round trips. The latency of a request is measured
+* from enqueueing it until its waiter picked up the response.
+*
+* @return   0 - everything went fine
+* @return  -1 - out of memory, the report is full or the device got disconnected
+*/
+static int32_t bench_workload(struct bench_report *report, const char *name, struct conbee_device *dev, bench_request_fn request,
+                              uint8_t command, uint8_t parameter, uint32_t n, uint32_t depth)
+{
+  struct bench_result *result = bench_add_result(report, name);
+  uint64_t *latencies         = malloc(n * sizeof(uint64_t));
+  uint64_t started[BENCH_MAX_DEPTH];
+  uint8_t sequence_numbers[BENCH_MAX_DEPTH];
+
+  if (result == NULL || latencies == NULL)
+  {
+    free(latencies);
+    return -1;
+  }
+
+  uint64_t start = bench_now_ns();
+
+  for(uint32_t done = 0; done < n; )
+  {
+    uint32_t burst = n - done < depth ? n - done : depth;
+
+    for(uint32_t i = 0; i < burst; i++)
+    {
+      started[i]          = bench_now_ns();
+      sequence_numbers[i] = conbee_enqueue_frame(dev, request(parameter));
+    }
+
+    for(uint32_t i = 0; i < burst; i++)
+    {
+      struct conbee_frame *response;
+
+      if (conbee_wait_for_frame(dev, &response, sequence_numbers[i], command) < 0)
+      {
+        free(latencies);
+        return -1;
+      }
+      latencies[done + i] = bench_now_ns() - started[i];
+      bench_response(result, response);
+    }
+
+    done += burst;
+  }
+
+  uint64_t elapsed = bench_now_ns() - start;
+
+  // the sustained rate of the pipeline, not the inverse of the mean latency
+  bench_set_latencies(result, latencies, n);
+  result->ops_per_s = n * 1e9 / elapsed;
+
+  free(latencies);
+
+  return 0;
+}
+
+int bench(struct conbee_device *dev, int argc, char **argv)
+{
+  struct bench_report *report;
+  char workload[16] = "all";
+  char format[8]    = "json";
+  char name[64];
+  int requests      = 1000;
+  int depth         = 16;
+  int parameter     = PARAM_MAC_ADDRESS;
+  int err           = 0;
+
+  struct arg_parse_ctx *argparse_ctx = argparse_init();
+
+  struct arg_str workload_arg = {{ARG_STR,0,0}, 'w', "workload", workload, 15, "all, read, pipeline or state (default: all)"};
+  struct arg_str format_arg   = {{ARG_STR,0,0}, 'f', "format", format, 7, "output format, json or text (default: json)"};
+  argparse_add_string(argparse_ctx, &workload_arg);
+  argparse_add_string(argparse_ctx, &format_arg);
+
+  struct arg_int requests_arg  = {{ARG_INT,0,0}, 'n', "requests",  "requests per workload (default: 1000)", &requests};
+  struct arg_int depth_arg     = {{ARG_INT,0,0}, 'D', "depth",     "deepest pipeline, bursts of 1, 2, 4, ... up to it (default: 16)", &depth};
+  struct arg_int parameter_arg = {{ARG_INT,0,0}, 'p', "parameter", "parameter id read by the read workloads (default: 1, the mac address)", &parameter};
+  argparse_add_int(argparse_ctx, &requests_arg);
+  argparse_add_int(argparse_ctx, &depth_arg);
+  argparse_add_int(argparse_ctx, &parameter_arg);
+
+  /// parse the commandline
+  int ret=argparse_parse(argparse_ctx, argc, argv);
+
+  /// free context
+  argparse_free(argparse_ctx);
+
+  if (ret < 0)
+  {
+    return -1;
+  }
+
+  if (requests < 1 || depth < 1 || depth > BENCH_MAX_DEPTH || parameter < 1 || parameter > 0xFF)
+  {
+    fprintf(stderr, "Error: at least 1 request and a depth of 1 to %d are required\n", BENCH_MAX_DEPTH);
+    return -1;
+  }
+
+  report = malloc(sizeof(struct bench_report));
+  if (report == NULL)
+  {
+    return -1;
+  }
+  memset(report, 0, sizeof(struct bench_report));
+
+  // the numbers should not be answered from the cache
+  conbee_enable_parameter_cache(dev, 0);
+
+  if (strcmp(workload, "all") == 0 || strcmp(workload, "read") == 0)
+  {
+    err |= bench_workload(report, "read_parameter", dev, bench_read_request, COMMAND_READ_PARAMETER, parameter, requests, 1);
+  }
+
+  if (strcmp(workload, "all") == 0 || strcmp(workload, "pipeline") == 0)
+  {
+    for(int d = 1; d <= depth; d = d < depth && d * 2 > depth ? depth : d * 2)
+    {
+      snprintf(name, sizeof(name), "pipeline/depth-%d", d);
+      err |= bench_workload(report, name, dev, bench_read_request, COMMAND_READ_PARAMETER, parameter, requests, d);
+    }
+  }
+
+  if (strcmp(workload, "all") == 0 || strcmp(workload, "state") == 0)
+  {
+    err |= bench_workload(report, "device_state", dev, bench_state_request, COMMAND_DEVICE_STATE, 0, requests, 1);
+  }
+
+  if (strcmp(format, "text") == 0)
+  {
+    bench_print_text(report, stdout);
+  }
+  else
+  {
+    bench_print_json(report, stdout);
+  }
+
+  free(report);
+
+  return err < 0 ? -1 : 0;
+}
@@ -0,0 +1,462 @@
+#include <conbee.h>
+#include <string.h>
+#include <stdio.h>
+#include <conbeectrl/commands.h>
+#include <conbeectrl/version.h>
+#include <conbeectrl/mac.h>
+#include <conbeectrl/panid.h>
+#include <conbeectrl/nwk-address.h>
+#include <conbeectrl/nwk_ext_panid.h>
+#include <conbeectrl/network-mode.h>
+#include <conbeectrl/set-network-mode.h>
+#include <conbeectrl/channel-mask.h>
+#include <conbeectrl/set-channel-mask.h>
+#include <conbeectrl/aps_ext_panid.h>
+#include <conbeectrl/set-aps-ext-panid.h>
+#include <conbeectrl/tc-address.h>
+#include <conbeectrl/set-trust-center.h>
+#include <conbeectrl/security-mode.h>
+#include <conbeectrl/set-security-mode.h>
+#include <conbeectrl/serve.h>
+#include <conbeectrl/bench.h>
+#include <conbeectrl/monitor.h>
+#include <conbeectrl/backup.h>
+#include <conbeectrl/batch.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <glob.h>
+#include <sys/wait.h>
+
+extern char conbee_device_name[200];
+
+/// the devices selected with -d, globs already expanded
+static char *conbeectrl_devices[CONBEECTRL_MAX_DEVICES];
+
+/// the number of selected devices
+static int conbeectrl_nr_devices = 0;
+
+/// all conbeectrl commands, terminated by an entry without name
+const struct conbeectrl_command conbeectrl_commands[] = {
+  {"version",           "get firmware version",                         0,                          0, 0, 0, &print_version},
+  {"mac",               "get sticks mac address",                       PARAM_MAC_ADDRESS,          0, 0, 0, &print_mac},
+  {"panid",             "get current nwk panid",                        PARAM_NWK_PANID,            0, 0, 0, &print_panid},
+  {"nwk-addr",          "get current nwk address",                      PARAM_NWK_ADDRESS,          0, 0, 0, &print_nwk_addr},
+  {"nwk-ext-panid",     "get current nwk ext panid",                    PARAM_NWK_EXT_PANID,        0, 0, 0, &print_nwk_ext_panid},
+  {"network-mode",      "get current network mode",                     PARAM_APS_COORDINATOR,      0, 0, 0, &print_network_mode},
+  {"set-network-mode",  "set network mode",                             0,                          1, 0, 0, &set_network_mode},
+  {"channel-mask",      "print the current channel mask of the stick",  PARAM_CHANNEL_MASK,         0, 0, 0, &print_channel_mask},
+  {"set-channel-mask",  "set channel mask",                             0,                          1, 0, 0, &set_channel_mask},
+  {"aps-ext-panid",     "get aps extended panid",                       PARAM_APS_EXT_PANID,        0, 0, 0, &print_aps_ext_panid},
+  {"set-aps-ext-panid", "set aps extended panid",                       0,                          1, 0, 0, &set_aps_ext_panid},
+  {"tc-addr",           "get current trust center address",             PARAM_TRUST_CENTER_ADDRESS, 0, 0, 0, &print_tc_addr},
+  {"set-tc-addr",       "set trust center address",                     0,                          1, 0, 0, &set_trust_center},
+  {"sec-mode",          "get current security mode",                    PARAM_SECURITY_MODE,        0, 0, 0, &print_security_mode},
+  {"set-sec-mode",      "set security mode",                            0,                          1, 0, 0, &set_security_mode},
+  {"serve",             "share the stick with other processes",         0,                          0, 1, 1, &serve},
+  {"backup",            "save all parameters of the stick to a file",   0,                          0, 0, 0, &backup},
+  {"restore",           "write a backup to the stick and verify it",    0,                          1, 0, 0, &restore},
+  {"batch",             "run command lines read from stdin or a file",  0,                          0, 0, 1, &batch},
+  {"monitor",           "show the frames received from the stick",      0,                          0, 0, 0, &monitor},
+  {"bench",             "measure latency and throughput of the stick",  0,                          0, 0, 0, &bench},
+  {NULL,                NULL,                                           0,                          0, 0, 0, NULL}
+};
+
+/// directory of the default daemon sockets
+#define CONBEECTRL_SOCKET_DIR   "/tmp"
+
+/**
+* @brief find a command by its name
+*
+* @return the command, NULL if there is no such command
+*/
+static const struct conbeectrl_command * conbeectrl_lookup(const char *name)
+{
+  for(const struct conbeectrl_command *command = conbeectrl_commands; command->name != NULL; command++)
+  {
+    if (strcmp(command->name, name) == 0)
+    {
+      return command;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+* @brief split a list of commands, each followed by its own "-x value" options, into invocations
+*
+* @param count       - the number of arguments
+* @param argv        - the arguments starting at the first command
+* @param invocations - array of max invocations receiving the commands
+* @param max         - the maximum number of invocations
+*
+* @return >=0 - the number of invocations
+* @return  -1 - unknown command or too many commands, an error has been printed
+*/
+int conbeectrl_parse(int count, char **argv, struct conbeectrl_invocation *invocations, int max)
+{
+  int n = 0;
+
+  for(int i = 0; i < count; )
+  {
+    const struct conbeectrl_command *command = conbeectrl_lookup(argv[i]);
+    if (command == NULL)
+    {
+      fprintf(stderr, "%s is an unknown command\n", argv[i]);
+      return -1;
+    }
+
+    if (n == max)
+    {
+      fprintf(stderr, "at most %d commands are supported\n", max);
+      return -1;
+    }
+
+    int start = i++;
+
+    // options of the command and their values
+    while(i < count && argv[i][0] == '-')
+    {
+      i += 2;
+    }
+    if (i > count)
+    {
+      i = count;
+    }
+
+    invocations[n].command  = command;
+    invocations[n].argc     = i - start;
+    invocations[n].argv     = &argv[start];
+    n++;
+  }
+
+  return n;
+}
+
+/**
+* @brief read the parameters of all reading commands up to the next writing command in one batch
+*
+* the values end up in the parameter cache, where the commands pick them up
+*
+* @param dev         - the connected device
+* @param invocations - the invocations starting at the first one to prefetch
+* @param n           - the number of invocations left
+*/
+static void conbeectrl_prefetch(struct conbee_device *dev, struct conbeectrl_invocation *invocations, int n)
+{
+  struct conbee_parameter results[CONBEECTRL_MAX_COMMANDS];
+  uint8_t ids[CONBEECTRL_MAX_COMMANDS];
+  uint16_t count = 0;
+
+  for(int i = 0; i < n && !invocations[i].command->writes; i++)
+  {
+    uint8_t id = invocations[i].command->parameter;
+    uint8_t known = 0;
+
+    for(uint16_t k = 0; k < count; k++)
+    {
+      known |= ids[k] == id;
+    }
+
+    if (id != 0 && !known)
+    {
+      ids[count++] = id;
+    }
+  }
+
+  // a single read is no faster prefetched, failed reads are repeated and reported by the command
+  if (count > 1)
+  {
+    conbee_read_parameters(dev, ids, count, results);
+  }
+}
+
+/**
+* @brief return the default socket of the daemon serving a device
+*
+* @param device - the device name, e.g. /dev/ttyACM0
+* @param path   - buffer receiving the socket path
+* @param length - the size of the buffer
+*/
+void conbeectrl_socket_path(const char *device, char *path, size_t length)
+{
+  int used = snprintf(path, length, "%s/conbeectrl-", CONBEECTRL_SOCKET_DIR);
+
+  // e.g. /tmp/conbeectrl-dev_ttyACM0.sock
+  for(const char *c = device[0] == '/' ? device + 1 : device; *c != 0 && used + 6 < (int) length; c++)
+  {
+    path[used++] = *c == '/' ? '_' : *c;
+  }
+  snprintf(&path[used], length - used, ".sock");
+}
+
+/**
+* @brief connect to the daemon serving the device if one is running, otherwise to the device
+*
+* @return   0 - everything went fine
+* @return  -1 - the device could not be connected
+*/
+static int32_t conbeectrl_connect(struct conbee_device *dev, uint8_t direct)
+{
+  char address[128] = "unix://";
+
+  // explicit transports are used as given
+  if (!direct && strstr(conbee_device_name, "://") == NULL)
+  {
+    conbeectrl_socket_path(conbee_device_name, &address[7], sizeof(address) - 7);
+
+    // a stale socket of a crashed daemon is ignored
+    if (access(&address[7], F_OK) == 0 && conbee_connect(dev, address) == 0)
+    {
+      return 0;
+    }
+  }
+
+  return conbee_connect(dev, conbee_device_name);
+}
+
+/**
+* @brief add a device to the selected devices, names containing wildcards are expanded
+*
+* @param device - the device name or a glob like /dev/ttyACM*
+*
+* @return  0 - everything went fine
+* @return -1 - no device matches or too many devices are selected
+*/
+int conbeectrl_add_device(const char *device)
+{
+  glob_t matches;
+  int err = 0;
+
+  // explicit transports and plain names are taken as they are
+  if (strstr(device, "://") != NULL || strpbrk(device, "*?[") == NULL)
+  {
+    matches.gl_pathc = 1;
+    matches.gl_pathv = (char **) &device;
+  }
+  else if (glob(device, 0, NULL, &matches) != 0)
+  {
+    fprintf(stderr, "no device matches %s\n", device);
+    return -1;
+  }
+
+  for(size_t i = 0; i < matches.gl_pathc && err == 0; i++)
+  {
+    int known = 0;
+
+    for(int k = 0; k < conbeectrl_nr_devices; k++)
+    {
+      known |= strcmp(conbeectrl_devices[k], matches.gl_pathv[i]) == 0;
+    }
+
+    if (known)
+    {
+      continue;
+    }
+
+    if (conbeectrl_nr_devices == CONBEECTRL_MAX_DEVICES)
+    {
+      fprintf(stderr, "at most %d devices are supported\n", CONBEECTRL_MAX_DEVICES);
+      err = -1;
+      break;
+    }
+
+    conbeectrl_devices[conbeectrl_nr_devices++] = strdup(matches.gl_pathv[i]);
+  }
+
+  if (matches.gl_pathv != (char **) &device)
+  {
+    globfree(&matches);
+  }
+
+  return err;
+}
+
+/**
+* @brief run invocations in order over a connected device
+*
+* all parameters read by consecutive commands are fetched in one pipelined batch,
+* the first failing command stops the run
+*
+* @param dev         - the connected device with the parameter cache enabled
+* @param invocations - the invocations to run
+* @param n           - the number of invocations
+*
+* @return the number of invocations which succeeded, n if all of them did
+*/
+int conbeectrl_execute(struct conbee_device *dev, struct conbeectrl_invocation *invocations, int n)
+{
+  for(int i = 0; i < n; i++)
+  {
+    // prefetch at the start and after every write, the cache is invalidated by writes
+    if (i == 0 || invocations[i-1].command->writes)
+    {
+      conbeectrl_prefetch(dev, &invocations[i], n - i);
+    }
+
+    if (invocations[i].command->run(dev, invocations[i].argc, invocations[i].argv) < 0)
+    {
+      return i;
+    }
+  }
+
+  return n;
+}
+
+/**
+* @brief run the invocations against conbee_device_name over one connection
+*
+* @return  0 - all commands succeeded
+* @return -1 - a command failed or the stick could not be connected
+*/
+static int conbeectrl_run_device(struct conbeectrl_invocation *invocations, int n, uint8_t direct)
+{
+  struct conbee_device dev;
+
+  if (conbeectrl_connect(&dev, direct) < 0)
+  {
+    return -1;
+  }
+
+  conbee_enable_parameter_cache(&dev, 1);
+
+  int done = conbeectrl_execute(&dev, invocations, n);
+
+  conbee_close(&dev);
+
+  return done < n ? -1 : 0;
+}
+
+/**
+* @brief run the invocations against all selected devices at the same time
+*
+* every device is handled by its own process, so the devices do not share any state and
+* the slowest stick determines the runtime. The output of each device is collected and
+* printed in the order of the devices once all of them finished.
+*
+* @return  0 - all commands succeeded on all devices
+* @return -1 - at least one device failed
+*/
+static int conbeectrl_run_fleet(struct conbeectrl_invocation *invocations, int n)
+{
+  FILE *outputs[CONBEECTRL_MAX_DEVICES];
+  pid_t pids[CONBEECTRL_MAX_DEVICES];
+  int failed = 0;
+
+  fflush(stdout);
+  fflush(stderr);
+
+  for(int i = 0; i < conbeectrl_nr_devices; i++)
+  {
+    outputs[i] = tmpfile();
+    pids[i]    = outputs[i] == NULL ? -1 : fork();
+
+    if (pids[i] == 0)
+    {
+      dup2(fileno(outputs[i]), STDOUT_FILENO);
+      dup2(fileno(outputs[i]), STDERR_FILENO);
+      strncpy(conbee_device_name, conbeectrl_devices[i], sizeof(conbee_device_name) - 1);
+
+      int err = conbeectrl_run_device(invocations, n, 0);
+
+      fflush(stdout);
+      fflush(stderr);
+      _exit(err < 0 ? 1 : 0);
+    }
+  }
+
+  for(int i = 0; i < conbeectrl_nr_devices; i++)
+  {
+    char buffer[4096];
+    size_t length;
+    int status = 1;
+
+    if (pids[i] < 0 || waitpid(pids[i], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+      failed++;
+      status = 1;
+    }
+
+    printf("==> %s <== %s\n", conbeectrl_devices[i], status == 0 ? "ok" : "failed");
+
+    if (outputs[i] == NULL)
+    {
+      continue;
+    }
+
+    rewind(outputs[i]);
+    while((length = fread(buffer, 1, sizeof(buffer), outputs[i])) > 0)
+    {
+      fwrite(buffer, 1, length, stdout);
+    }
+    fclose(outputs[i]);
+  }
+
+  fflush(stdout);
+  if (failed > 0)
+  {
+    fprintf(stderr, "%d of %d devices failed\n", failed, conbeectrl_nr_devices);
+  }
+
+  return failed > 0 ? -1 : 0;
+}
+
+/**
+* @brief run all commands of the commandline over one connection per device
+*
+* the commandline is a list of commands, each followed by its own "-x value" options.
+* All parameters read by consecutive commands are fetched in one pipelined batch.
+* Commands are run in order, the first failing command stops the run. If a daemon
+* serves the device the commands are sent through it. If more than one device is
+* selected the commands run on all of them at the same time.
+*
+* @param argc - ignored, argv has to be terminated by NULL
+* @param argv - the commandline starting at the first command
+*
+* @return  0 - all commands succeeded
+* @return -1 - a command failed or the stick could not be connected
+*/
+int conbeectrl_run(int argc, char **argv)
+{
+  struct conbeectrl_invocation invocations[CONBEECTRL_MAX_COMMANDS];
+  int count      = 0;
+  uint8_t direct = 0;
+
+  // the argument count handed over by yaap does not match argv, count ourselves
+  (void) argc;
+  while(argv[count] != NULL)
+  {
+    count++;
+  }
+
+  // check all commands before connecting
+  int n = conbeectrl_parse(count, argv, invocations, CONBEECTRL_MAX_COMMANDS);
+  if (n < 0)
+  {
+    return -1;
+  }
+
+  for(int i = 0; i < n; i++)
+  {
+    direct |= invocations[i].command->direct;
+
+    // e.g. serve never returns, its output would never show up
+    if (conbeectrl_nr_devices > 1 && invocations[i].command->single)
+    {
+      fprintf(stderr, "%s supports a single device only\n", invocations[i].command->name);
+      return -1;
+    }
+  }
+
+  if (conbeectrl_nr_devices > 1)
+  {
+    return conbeectrl_run_fleet(invocations, n);
+  }
+
+  if (conbeectrl_nr_devices == 1)
+  {
+    strncpy(conbee_device_name, conbeectrl_devices[0], sizeof(conbee_device_name) - 1);
+  }
+
+  return conbeectrl_run_device(invocations, n, direct);
+}
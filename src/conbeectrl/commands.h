@@ -0,0 +1,147 @@
+#ifndef __CONNBEECTRL_COMMANDS_H__
+#define __CONNBEECTRL_COMMANDS_H__
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file */
+#include<conbee.h>
+
+/// the maximum number of commands of one conbeectrl call
+#define CONBEECTRL_MAX_COMMANDS   64
+
+/// the maximum number of devices of one conbeectrl call
+#define CONBEECTRL_MAX_DEVICES    32
+
+/**
+* @brief a conbeectrl command
+*/
+struct conbeectrl_command
+{
+  /// the name of the command on the commandline
+  const char *name;
+
+  /// the description of the command printed by the usage
+  const char *description;
+
+  /// the parameter (PARAM_*) read by the command, prefetched with the other reads; 0 if none
+  uint8_t parameter;
+
+  /// the command writes to the stick, reads after it are fetched again
+  uint8_t writes;
+
+  /// the command needs the stick itself, never a running daemon
+  uint8_t direct;
+
+  /// the command supports a single device only, e.g. because it reads stdin or never returns
+  uint8_t single;
+
+  /**
+  * @brief run the command
+  *
+  * @param dev  - the connected device
+  * @param argc - the number of arguments of the command including its name
+  * @param argv - the arguments of the command, argv[0] is its name
+  *
+  * @return  0 - everything went fine
+  * @return -1 - the command failed
+  */
+  int (*run)(struct conbee_device *dev, int argc, char **argv);
+};
+
+/// all conbeectrl commands, terminated by an entry without name
+extern const struct conbeectrl_command conbeectrl_commands[];
+
+/**
+* @brief one command of the commandline together with its arguments
+*/
+struct conbeectrl_invocation
+{
+  /// the command
+  const struct conbeectrl_command *command;
+
+  /// the number of arguments including the command name
+  int argc;
+
+  /// the arguments, argv[0] is the command name
+  char **argv;
+};
+
+/**
+* @brief split a list of commands, each followed by its own "-x value" options, into invocations
+*
+* @param count       - the number of arguments
+* @param argv        - the arguments starting at the first command
+* @param invocations - array of max invocations receiving the commands
+* @param max         - the maximum number of invocations
+*
+* @return >=0 - the number of invocations
+* @return  -1 - unknown command or too many commands, an error has been printed
+*/
+int conbeectrl_parse(int count, char **argv, struct conbeectrl_invocation *invocations, int max);
+
+/**
+* @brief run invocations in order over a connected device
+*
+* all parameters read by consecutive commands are fetched in one pipelined batch,
+* the first failing command stops the run
+*
+* @param dev         - the connected device with the parameter cache enabled
+* @param invocations - the invocations to run
+* @param n           - the number of invocations
+*
+* @return the number of invocations which succeeded, n if all of them did
+*/
+int conbeectrl_execute(struct conbee_device *dev, struct conbeectrl_invocation *invocations, int n);
+
+/**
+* @brief return the default socket of the daemon serving a device
+*
+* @param device - the device name, e.g. /dev/ttyACM0
+* @param path   - buffer receiving the socket path
+* @param length - the size of the buffer
+*/
+void conbeectrl_socket_path(const char *device, char *path, size_t length);
+
+/**
+* @brief add a device to the selected devices, names containing wildcards are expanded
+*
+* @param device - the device name or a glob like /dev/ttyACM*
+*
+* @return  0 - everything went fine
+* @return -1 - no device matches or too many devices are selected
+*/
+int conbeectrl_add_device(const char *device);
+
+/**
+* @brief run all commands of the commandline over one connection per device
+*
+* the commandline is a list of commands, each followed by its own "-x value" options.
+* All parameters read by consecutive commands are fetched in one pipelined batch.
+* Commands are run in order, the first failing command stops the run. If a daemon
+* serves the device the commands are sent through it. If more than one device is
+* selected the commands run on all of them at the same time.
+*
+* @param argc - ignored, argv has to be terminated by NULL
+* @param argv - the commandline starting at the first command
+*
+* @return  0 - all commands succeeded
+* @return -1 - a command failed or the stick could not be connected
+*/
+int conbeectrl_run(int argc, char **argv);
+
+
+#endif
@@ -2,21 +2,12 @@
 #include <string.h>
 #include <stdio.h>
 
-extern char conbee_device_name[200];
-
-int print_mac(int argc, char **argv)
+int print_mac(struct conbee_device *dev, int argc, char **argv)
 {
-  struct conbee_device dev;
   uint8_t mac[8];
   int32_t err;
 
-  err = conbee_connect(&dev, conbee_device_name);
-  if (err < 0)
-  {
-    return -1;
-  }
-
-  err = conbee_get_mac_address(&dev,mac);
+  err = conbee_get_mac_address(dev,mac);
   if (err < 0)
   {
     fprintf(stderr, "Error getting mac address\n");
@@ -31,7 +22,5 @@ int print_mac(int argc, char **argv)
     printf("\n");
   }
 
-  conbee_close(&dev);
-
-  return 0;
+  return err < 0 ? -1 : 0;
 }
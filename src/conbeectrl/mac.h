@@ -20,7 +20,7 @@
 /** @file */
 #include<conbee.h>
 
-int print_mac(int argc, char **argv);
+int print_mac(struct conbee_device *dev, int argc, char **argv);
 
 
 #endif
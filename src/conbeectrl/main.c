@@ -16,21 +16,7 @@
  */
 #include <stdio.h>
 #include <argparse.h>
-#include <conbeectrl/version.h>
-#include <conbeectrl/mac.h>
-#include <conbeectrl/panid.h>
-#include <conbeectrl/nwk-address.h>
-#include <conbeectrl/nwk_ext_panid.h>
-#include <conbeectrl/network-mode.h>
-#include <conbeectrl/set-network-mode.h>
-#include <conbeectrl/channel-mask.h>
-#include <conbeectrl/set-channel-mask.h>
-#include <conbeectrl/aps_ext_panid.h>
-#include <conbeectrl/set-aps-ext-panid.h>
-#include <conbeectrl/tc-address.h>
-#include <conbeectrl/set-trust-center.h>
-#include <conbeectrl/security-mode.h>
-#include <conbeectrl/set-security-mode.h>
+#include <conbeectrl/commands.h>
 #include <string.h>
 
 char conbee_device_name[200];
@@ -39,6 +25,7 @@ char conbee_device_name[200];
 int main(int argc, char **argv)
 {
   struct arg_parse_ctx *argparse_ctx = argparse_init();
+  struct arg_parse_cmd commands[CONBEECTRL_MAX_COMMANDS];
 
   strncpy(conbee_device_name,"/dev/ttyACM0",12);
 
@@ -49,193 +36,36 @@ int main(int argc, char **argv)
       "device",
       conbee_device_name,
       199,
-      "device name of the conbee stick (default: /dev/ttyACM0)"
+      "device name of the conbee stick, repeat it or use a glob like '/dev/ttyACM*' for many sticks (default: /dev/ttyACM0)"
   };
   argparse_add_string(argparse_ctx, &device_name);
 
-  // create a command argument
-  struct arg_parse_cmd version_cmd= {
-    {0,1,0},                        // 1 = mandatory element
-    0,
-    "version",                         // command name
-    "get firmware version",                  // command description
-    &print_version                          // if found call this function
-  };
-
-  /// add the argument command to context
-  argparse_add_command(argparse_ctx, &version_cmd);
-
-  // create a command argument
-  struct arg_parse_cmd mac_cmd= {
-    {0,1,0},                        // 1 = mandatory element
-    0,
-    "mac",                          // command name
-    "get sticks mac address",                  // command description
-    &print_mac                          // if found call this function
-  };
-
-  /// add the argument command to context
-  argparse_add_command(argparse_ctx, &mac_cmd);
-
-  // create a command argument
-  struct arg_parse_cmd panid_cmd= {
-    {0,1,0},                        // 1 = mandatory element
-    0,
-    "panid",                          // command name
-    "get current nwk panid",                  // command description
-    &print_panid                          // if found call this function
-  };
-
-  /// add the argument command to context
-  argparse_add_command(argparse_ctx, &panid_cmd);
-
-  // create a command argument
-  struct arg_parse_cmd nwk_addr_cmd= {
-    {0,1,0},                        // 1 = mandatory element
-    0,
-    "nwk-addr",                          // command name
-    "get current nwk address",                  // command description
-    &print_nwk_addr                          // if found call this function
-  };
-
-  /// add the argument command to context
-  argparse_add_command(argparse_ctx, &nwk_addr_cmd);
-
-  // create a command argument
-  struct arg_parse_cmd nwk_ext_panid_cmd= {
-    {0,1,0},                        // 1 = mandatory element
-    0,
-    "nwk-ext-panid",                          // command name
-    "get current nwk ext panid",                  // command description
-    &print_nwk_ext_panid                          // if found call this function
-  };
-
-  /// add the argument command to context
-  argparse_add_command(argparse_ctx, &nwk_ext_panid_cmd);
-
-  // create a command argument
-  struct arg_parse_cmd network_mode_cmd= {
-    {0,1,0},                        // 1 = mandatory element
-    0,
-    "network-mode",                          // command name
-    "get current network mode",                  // command description
-    &print_network_mode                          // if found call this function
-  };
-
-  /// add the argument command to context
-  argparse_add_command(argparse_ctx, &network_mode_cmd);
-
-  // create a command argument
-  struct arg_parse_cmd set_network_mode_cmd= {
-    {0,1,0},                        // 1 = mandatory element
-    0,
-    "set-network-mode",                          // command name
-    "set network mode",                  // command description
-    &set_network_mode                          // if found call this function
-  };
-
-  /// add the argument command to context
-  argparse_add_command(argparse_ctx, &set_network_mode_cmd);
-
-
-  // create a command argument
-  struct arg_parse_cmd get_channel_mask_cmd= {
-    {0,1,0},                        // 1 = mandatory element
-    0,
-    "channel-mask",                          // command name
-    "print the current channel mask of the stick",                  // command description
-    &print_channel_mask                          // if found call this function
-  };
-
-  /// add the argument command to context
-  argparse_add_command(argparse_ctx, &get_channel_mask_cmd);
-
-  // create a command argument
-  struct arg_parse_cmd set_channel_mask_cmd= {
-    {0,1,0},                        // 1 = mandatory element
-    0,
-    "set-channel-mask",                          // command name
-    "set channel mask",                  // command description
-    &set_channel_mask                          // if found call this function
-  };
-
-  /// add the argument command to context
-  argparse_add_command(argparse_ctx, &set_channel_mask_cmd);
-
-  // create a command argument
-  struct arg_parse_cmd get_aps_ext_panid_cmd= {
-    {0,1,0},                        // 1 = mandatory element
-    0,
-    "aps-ext-panid",                          // command name
-    "get aps extended panid",                  // command description
-    &print_aps_ext_panid                          // if found call this function
-  };
-
-  /// add the argument command to context
-  argparse_add_command(argparse_ctx, &get_aps_ext_panid_cmd);
-
-  // create a command argument
-  struct arg_parse_cmd set_aps_ext_panid_cmd= {
-    {0,1,0},                        // 1 = mandatory element
-    0,
-    "set-aps-ext-panid",                          // command name
-    "set aps extended panid",                  // command description
-    &set_aps_ext_panid                          // if found call this function
-  };
-
-  /// add the argument command to context
-  argparse_add_command(argparse_ctx, &set_aps_ext_panid_cmd);
-
-  // create a command argument
-  struct arg_parse_cmd tc_addr_cmd= {
-    {0,1,0},                        // 1 = mandatory element
-    0,
-    "tc-addr",                          // command name
-    "get current trust center address",                  // command description
-    &print_tc_addr                          // if found call this function
-  };
-
-  /// add the argument command to context
-  argparse_add_command(argparse_ctx, &tc_addr_cmd);
-
-  // create a command argument
-  struct arg_parse_cmd set_tc_addr_cmd= {
-    {0,1,0},                        // 1 = mandatory element
-    0,
-    "set-tc-addr",                          // command name
-    "set trust center address",                  // command description
-    &set_trust_center                          // if found call this function
-  };
-
-  /// add the argument command to context
-  argparse_add_command(argparse_ctx, &set_tc_addr_cmd);
-
-
-  // create a command argument
-  struct arg_parse_cmd sec_mode_cmd= {
-    {0,1,0},                        // 1 = mandatory element
-    0,
-    "sec-mode",                          // command name
-    "get current security mode",                  // command description
-    &print_security_mode                          // if found call this function
-  };
-
-  /// add the argument command to context
-  argparse_add_command(argparse_ctx, &sec_mode_cmd);
-
-
-  // create a command argument
-  struct arg_parse_cmd set_sec_mode_cmd= {
-    {0,1,0},                        // 1 = mandatory element
-    0,
-    "set-sec-mode",                          // command name
-    "set security mode",                  // command description
-    &set_security_mode                          // if found call this function
-  };
-
-  /// add the argument command to context
-  argparse_add_command(argparse_ctx, &set_sec_mode_cmd);
-
+  // yaap only keeps the last -d, collect all of them up to the first command
+  for(int i = 1; i < argc && argv[i][0] == '-'; i += 2)
+  {
+    if (strcmp(argv[i], "-d") == 0 && i + 1 < argc && conbeectrl_add_device(argv[i+1]) < 0)
+    {
+      argparse_free(argparse_ctx);
+      return 1;
+    }
+  }
+
+  // every command runs all commands following it over one connection, e.g. "mac panid channel-mask"
+  for(int i = 0; conbeectrl_commands[i].name != NULL; i++)
+  {
+    struct arg_parse_cmd command = {
+      {0,1,0},                                // 1 = mandatory element
+      0,
+      conbeectrl_commands[i].name,            // command name
+      conbeectrl_commands[i].description,     // command description
+      &conbeectrl_run                         // if found call this function
+    };
+
+    commands[i] = command;
+
+    /// add the argument command to context
+    argparse_add_command(argparse_ctx, &commands[i]);
+  }
 
   /// parse the commandline
   int ret=argparse_parse(argparse_ctx, argc, argv);
@@ -243,4 +73,5 @@ int main(int argc, char **argv)
   /// free context
   argparse_free(argparse_ctx);
 
+  return ret < 0 ? 1 : 0;
 }
@@ -0,0 +1,628 @@
+#include <conbee.h>
+#include <conbee-capture.h>
+#include <conbee-trace.h>
+#include <slip.h>
+#include <crc16.h>
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <argparse.h>
+#include <pthread.h>
+
+/// number of received frames buffered between the worker and the formatting, has to be a power of two
+#define MONITOR_RING_SIZE     4096
+
+/// number of bytes of formatted output collected before writing it
+#define MONITOR_BUFFER_SIZE   65536
+
+/// the longest formatted frame
+#define MONITOR_MAX_LINE      4096
+
+/// microseconds after which an unanswered fetch of aps indications is repeated
+#define MONITOR_FETCH_TIMEOUT 1000000
+
+/// output formats of the monitor
+enum monitor_format
+{
+  MONITOR_TEXT,
+  MONITOR_JSON,
+  MONITOR_BINARY
+};
+
+/**
+* @brief a received frame waiting to be formatted
+*/
+struct monitor_entry
+{
+  /// the frame, owned by the monitor
+  struct conbee_frame *frame;
+
+  /// wall clock time the worker handed the frame over in microseconds since the epoch
+  uint64_t realtime_us;
+};
+
+/**
+* @brief the state shared between the worker and the formatting loop
+*/
+struct monitor_state
+{
+  /// frames handed over by the worker
+  struct monitor_entry ring[MONITOR_RING_SIZE];
+
+  /// number of frames ever pushed to the ring
+  uint32_t head;
+
+  /// number of frames ever taken from the ring
+  uint32_t tail;
+
+  /// number of frames dropped because the ring was full
+  uint64_t dropped;
+
+  /// set by the device state callback whenever the stick reports new aps indications
+  uint8_t indications_pending;
+
+  /// mutex protecting the fields above
+  pthread_mutex_t mutex;
+
+  /// signalled whenever there is something to do for the formatting loop
+  pthread_cond_t cond;
+};
+
+/**
+* @brief the output of the monitor
+*/
+struct monitor_output
+{
+  /// the output format
+  enum monitor_format format;
+
+  /// the collected output
+  char buffer[MONITOR_BUFFER_SIZE];
+
+  /// number of bytes within buffer
+  uint32_t length;
+
+  /// the second the cached time prefix belongs to
+  time_t second;
+
+  /// the formatted date and time of second
+  char time_prefix[32];
+
+  /// time of the previous binary record in microseconds since the epoch
+  uint64_t last_us;
+
+  /// set if writing the output failed
+  uint8_t failed;
+};
+
+/// set by the signal handler to stop monitoring
+static volatile sig_atomic_t monitor_stop = 0;
+
+/**
+* @brief stop monitoring on SIGINT and SIGTERM
+*/
+static void monitor_signal(int signal)
+{
+  (void) signal;
+
+  monitor_stop = 1;
+}
+
+/**
+* @brief return the wall clock time in microseconds since the epoch
+*/
+static uint64_t monitor_realtime_us()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+
+  return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/**
+* @brief return a readable name for a command
+*/
+static const char * monitor_command_name(uint8_t command)
+{
+  switch(command)
+  {
+    case COMMAND_DEVICE_STATE:          return "DEVICE_STATE";
+    case COMMAND_CHANGE_NETWORK_STATE:  return "CHANGE_NETWORK_STATE";
+    case COMMAND_READ_PARAMETER:        return "READ_PARAMETER";
+    case COMMAND_WRITE_PARAMETER:       return "WRITE_PARAMETER";
+    case COMMAND_DEVICE_STATE_CHANGED:  return "DEVICE_STATE_CHANGED";
+    case COMMAND_VERSION:               return "VERSION";
+    case COMMAND_APS_DATA_REQUEST:      return "APS_DATA_REQUEST";
+    case COMMAND_APS_DATA_CONFIRM:      return "APS_DATA_CONFIRM";
+    case COMMAND_APS_DATA_INDICATION:   return "APS_DATA_INDICATION";
+    default:                            return "UNKNOWN";
+  }
+}
+
+/**
+* @brief take a received frame from the worker, must not block
+*/
+static int32_t monitor_subscriber(struct conbee_device *dev, struct conbee_frame *frame, void *userdata)
+{
+  struct monitor_state *state = (struct monitor_state *) userdata;
+  uint64_t now                = monitor_realtime_us();
+
+  (void) dev;
+
+  pthread_mutex_lock(&state->mutex);
+  if (state->head - state->tail == MONITOR_RING_SIZE)
+  {
+    state->dropped++;
+    pthread_mutex_unlock(&state->mutex);
+    conbee_free_frame(frame);
+    return 1;
+  }
+
+  state->ring[state->head % MONITOR_RING_SIZE].frame       = frame;
+  state->ring[state->head % MONITOR_RING_SIZE].realtime_us = now;
+  state->head++;
+  pthread_cond_signal(&state->cond);
+  pthread_mutex_unlock(&state->mutex);
+
+  return 1;
+}
+
+/**
+* @brief note new aps indications reported by the stick, called by the worker
+*/
+static void monitor_device_state(struct conbee_device *dev, struct conbee_device_state *device_state, void *userdata)
+{
+  struct monitor_state *state = (struct monitor_state *) userdata;
+
+  (void) dev;
+
+  if (device_state->apsde_data_indication)
+  {
+    pthread_mutex_lock(&state->mutex);
+    state->indications_pending = 1;
+    pthread_cond_signal(&state->cond);
+    pthread_mutex_unlock(&state->mutex);
+  }
+}
+
+/**
+* @brief write the collected output
+*/
+static void monitor_flush(struct monitor_output *output)
+{
+  uint32_t written = 0;
+
+  while(written < output->length && !output->failed)
+  {
+    ssize_t ret = write(STDOUT_FILENO, &output->buffer[written], output->length - written);
+
+    if (ret < 0 && errno != EINTR)
+    {
+      output->failed = 1;
+    }
+    else if (ret > 0)
+    {
+      written += ret;
+    }
+  }
+
+  output->length = 0;
+}
+
+/**
+* @brief append formatted text to the output, the text is cut at MONITOR_MAX_LINE bytes
+*/
+static void monitor_printf(struct monitor_output *output, const char *format, ...) __attribute__((format(printf, 2, 3)));
+static void monitor_printf(struct monitor_output *output, const char *format, ...)
+{
+  va_list args;
+
+  if (output->length + MONITOR_MAX_LINE > MONITOR_BUFFER_SIZE)
+  {
+    monitor_flush(output);
+  }
+
+  va_start(args, format);
+  int length = vsnprintf(&output->buffer[output->length], MONITOR_MAX_LINE, format, args);
+  va_end(args);
+
+  if (length > 0)
+  {
+    output->length += length < MONITOR_MAX_LINE ? length : MONITOR_MAX_LINE - 1;
+  }
+}
+
+/**
+* @brief append bytes as hex, separated by blanks for the text format
+*/
+static void monitor_hex(struct monitor_output *output, uint8_t *data, uint32_t length, uint8_t separated)
+{
+  static const char digits[] = "0123456789abcdef";
+
+  for(uint32_t i = 0; i < length; i++)
+  {
+    if (output->length + 3 > MONITOR_BUFFER_SIZE)
+    {
+      monitor_flush(output);
+    }
+
+    if (separated)
+    {
+      output->buffer[output->length++] = ' ';
+    }
+    output->buffer[output->length++] = digits[data[i] >> 4];
+    output->buffer[output->length++] = digits[data[i] & 0x0F];
+  }
+}
+
+/**
+* @brief append a frame as capture record, so the output can be read by conbee-replay
+*/
+static void monitor_binary(struct monitor_output *output, struct conbee_frame *frame, uint64_t realtime_us)
+{
+  uint8_t packet[5 + 65535 + sizeof(uint16_t)];
+  uint32_t length = 0;
+
+  packet[length++] = frame->command;
+  packet[length++] = frame->sequence_number;
+  packet[length++] = frame->status;
+  packet[length++] = frame->length & 0xFF;
+  packet[length++] = frame->length >> 8;
+  if (frame->payload_length > 0)
+  {
+    memcpy(&packet[length], frame->payload, frame->payload_length);
+    length += frame->payload_length;
+  }
+
+  uint16_t crc = crc16(packet, length);
+  packet[length++] = crc & 0xFF;
+  packet[length++] = crc >> 8;
+
+  // a slip encoded packet is at most twice as long plus both END bytes
+  uint32_t record_max = sizeof(struct conbee_capture_record) + 2 * length + 2;
+  if (record_max > MONITOR_BUFFER_SIZE)
+  {
+    return;
+  }
+
+  if (output->length + record_max > MONITOR_BUFFER_SIZE)
+  {
+    monitor_flush(output);
+  }
+
+  // records follow each other without padding, so the header is copied instead of stored in place
+  struct conbee_capture_record record;
+  uint8_t *wire                        = (uint8_t *) &output->buffer[output->length + sizeof(struct conbee_capture_record)];
+  uint32_t wire_length                 = 0;
+
+  wire[wire_length++] = END;
+  wire_length        += slip_encode(packet, length, &wire[wire_length]);
+  wire[wire_length++] = END;
+
+  record.delta_us   = realtime_us > output->last_us ? realtime_us - output->last_us : 0;
+  record.length     = wire_length;
+  record.direction  = CONBEE_TRACE_RX;
+  record.reserved   = 0;
+  memcpy(&output->buffer[output->length], &record, sizeof(record));
+  output->last_us   = realtime_us;
+  output->length   += sizeof(struct conbee_capture_record) + wire_length;
+}
+
+/**
+* @brief append a frame as one line of text
+*/
+static void monitor_text(struct monitor_output *output, struct conbee_frame *frame, uint64_t realtime_us)
+{
+  struct conbee_device_state state;
+  struct conbee_aps_indication indication;
+  time_t second = realtime_us / 1000000;
+
+  // formatting the date is by far the most expensive part, do it once per second
+  if (second != output->second)
+  {
+    struct tm tm;
+
+    localtime_r(&second, &tm);
+    strftime(output->time_prefix, sizeof(output->time_prefix), "%Y-%m-%d %H:%M:%S", &tm);
+    output->second = second;
+  }
+
+  monitor_printf(output, "%s.%06lu %-20s seq %3u status 0x%02x", output->time_prefix, (unsigned long) (realtime_us % 1000000),
+                 monitor_command_name(frame->command), frame->sequence_number, frame->status);
+
+  if (frame->command == COMMAND_APS_DATA_INDICATION && conbee_aps_indication_response(frame, &indication) == 0)
+  {
+    monitor_printf(output, " src 0x%04x ep %u -> %u profile 0x%04x cluster 0x%04x lqi %u rssi %d asdu", indication.src_addr,
+                   indication.src_endpoint, indication.dst_endpoint, indication.profile_id, indication.cluster_id,
+                   indication.lqi, indication.rssi);
+    monitor_hex(output, indication.asdu, indication.asdu_length, 1);
+  }
+  else if (frame->command == COMMAND_DEVICE_STATE_CHANGED && conbee_device_state_response(frame, &state) == 0)
+  {
+    monitor_printf(output, " network %u confirm %u indication %u config-changed %u free-slots %u", state.network_state,
+                   state.apsde_data_confirm, state.apsde_data_indication, state.configuration_changed,
+                   state.apsde_data_request_free_slots);
+  }
+  else
+  {
+    monitor_printf(output, " payload");
+    monitor_hex(output, frame->payload, frame->payload_length, 1);
+  }
+
+  monitor_printf(output, "\n");
+}
+
+/**
+* @brief append a frame as one json object per line
+*/
+static void monitor_json(struct monitor_output *output, struct conbee_frame *frame, uint64_t realtime_us)
+{
+  struct conbee_device_state state;
+  struct conbee_aps_indication indication;
+
+  monitor_printf(output, "{\"time_us\": %lu, \"command\": \"%s\", \"seq\": %u, \"status\": %u", (unsigned long) realtime_us,
+                 monitor_command_name(frame->command), frame->sequence_number, frame->status);
+
+  if (frame->command == COMMAND_APS_DATA_INDICATION && conbee_aps_indication_response(frame, &indication) == 0)
+  {
+    monitor_printf(output, ", \"src_addr\": %u, \"src_endpoint\": %u, \"dst_endpoint\": %u, \"profile\": %u, \"cluster\": %u, "
+                   "\"lqi\": %u, \"rssi\": %d, \"asdu\": \"", indication.src_addr, indication.src_endpoint, indication.dst_endpoint,
+                   indication.profile_id, indication.cluster_id, indication.lqi, indication.rssi);
+    monitor_hex(output, indication.asdu, indication.asdu_length, 0);
+  }
+  else if (frame->command == COMMAND_DEVICE_STATE_CHANGED && conbee_device_state_response(frame, &state) == 0)
+  {
+    monitor_printf(output, ", \"network_state\": %u, \"apsde_data_confirm\": %u, \"apsde_data_indication\": %u, "
+                   "\"configuration_changed\": %u, \"free_slots\": %u", state.network_state, state.apsde_data_confirm,
+                   state.apsde_data_indication, state.configuration_changed, state.apsde_data_request_free_slots);
+    monitor_printf(output, "}\n");
+    return;
+  }
+  else
+  {
+    monitor_printf(output, ", \"payload\": \"");
+    monitor_hex(output, frame->payload, frame->payload_length, 0);
+  }
+
+  monitor_printf(output, "\"}\n");
+}
+
+/**
+* @brief parse a comma separated list of command names or numbers
+*
+* @return >=0 - the number of commands
+* @return  -1 - unknown command
+*/
+static int32_t monitor_parse_commands(char *list, uint8_t *commands)
+{
+  int32_t nr_commands = 0;
+  char *saveptr;
+
+  for(char *token = strtok_r(list, ",", &saveptr); token != NULL && nr_commands < 256; token = strtok_r(NULL, ",", &saveptr))
+  {
+    char *end;
+    long command = strtol(token, &end, 0);
+
+    if (*end != 0)
+    {
+      for(command = 0; command < 256 && strcasecmp(token, monitor_command_name(command)) != 0; command++);
+
+      if (strcasecmp(token, "UNKNOWN") == 0)
+      {
+        command = 256;
+      }
+    }
+
+    if (command < 0 || command > 255)
+    {
+      fprintf(stderr, "Error: unknown command %s\n", token);
+      return -1;
+    }
+
+    commands[nr_commands++] = command;
+  }
+
+  return nr_commands;
+}
+
+int monitor(struct conbee_device *dev, int argc, char **argv)
+{
+  struct monitor_state *state;
+  struct monitor_output *output;
+  struct sigaction action;
+  char format[8]           = "text";
+  char command_list[256]   = "";
+  uint8_t commands[256];
+  int32_t nr_commands      = 0;
+  int cluster              = APS_MATCH_ANY;
+  int fetch                = 0;
+  int count                = 0;
+  uint64_t frames          = 0;
+  uint64_t fetched_us      = 0;
+  int32_t fetch_sequence   = -1;
+
+  struct arg_parse_ctx *argparse_ctx = argparse_init();
+
+  struct arg_str format_arg   = {{ARG_STR,0,0}, 'f', "format", format, 7, "output format, text, json (one object per line) or binary (a capture) (default: text)"};
+  struct arg_str commands_arg = {{ARG_STR,0,0}, 'c', "commands", command_list, 255, "comma separated commands to show, names or numbers (default: all)"};
+  argparse_add_string(argparse_ctx, &format_arg);
+  argparse_add_string(argparse_ctx, &commands_arg);
+
+  struct arg_int cluster_arg = {{ARG_INT,0,0}, 'C', "cluster", "only show aps indications of this cluster (default: all)", &cluster};
+  struct arg_int fetch_arg   = {{ARG_INT,0,0}, 'a', "fetch", "1 to fetch pending aps indications from the stick, only if no other application does", &fetch};
+  struct arg_int count_arg   = {{ARG_INT,0,0}, 'n', "count", "stop after this number of frames (default: never)", &count};
+  argparse_add_int(argparse_ctx, &cluster_arg);
+  argparse_add_int(argparse_ctx, &fetch_arg);
+  argparse_add_int(argparse_ctx, &count_arg);
+
+  /// parse the commandline
+  int ret=argparse_parse(argparse_ctx, argc, argv);
+
+  /// free context
+  argparse_free(argparse_ctx);
+
+  if (ret < 0)
+  {
+    return -1;
+  }
+
+  if (command_list[0] != 0)
+  {
+    nr_commands = monitor_parse_commands(command_list, commands);
+    if (nr_commands < 0)
+    {
+      return -1;
+    }
+  }
+
+  if (conbee_set_frame_subscriber_filter(dev, nr_commands > 0 ? commands : NULL, nr_commands, cluster) < 0)
+  {
+    fprintf(stderr, "Error: invalid cluster %d\n", cluster);
+    return -1;
+  }
+
+  state  = malloc(sizeof(struct monitor_state));
+  output = malloc(sizeof(struct monitor_output));
+  if (state == NULL || output == NULL)
+  {
+    free(state);
+    free(output);
+    return -1;
+  }
+  memset(state, 0, sizeof(struct monitor_state));
+  memset(output, 0, sizeof(struct monitor_output));
+  pthread_mutex_init(&state->mutex, NULL);
+  pthread_cond_init(&state->cond, NULL);
+
+  if (strcmp(format, "json") == 0)
+  {
+    output->format = MONITOR_JSON;
+  }
+  else if (strcmp(format, "binary") == 0)
+  {
+    struct conbee_capture_header header;
+
+    output->format = MONITOR_BINARY;
+    output->last_us = monitor_realtime_us();
+
+    memset(&header, 0, sizeof(header));
+    header.magic              = CONBEE_CAPTURE_MAGIC;
+    header.version            = CONBEE_CAPTURE_VERSION;
+    header.header_size        = sizeof(header);
+    header.start_realtime_ns  = output->last_us * 1000;
+    memcpy(output->buffer, &header, sizeof(header));
+    output->length = sizeof(header);
+  }
+
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = monitor_signal;
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  conbee_set_frame_subscriber(dev, monitor_subscriber, state);
+  if (fetch)
+  {
+    conbee_set_device_state_callback(dev, monitor_device_state, state);
+  }
+
+  while(!monitor_stop && !output->failed && (count == 0 || frames < (uint64_t) count))
+  {
+    struct monitor_entry batch[MONITOR_RING_SIZE];
+    struct conbee_device_state device_state;
+    struct conbee_frame *frame;
+    struct timespec timeout;
+    uint32_t nr_entries = 0;
+
+    clock_gettime(CLOCK_REALTIME, &timeout);
+    timeout.tv_nsec += 100000000;
+    if (timeout.tv_nsec >= 1000000000)
+    {
+      timeout.tv_sec++;
+      timeout.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&state->mutex);
+    if (state->head == state->tail && !state->indications_pending)
+    {
+      pthread_cond_timedwait(&state->cond, &state->mutex, &timeout);
+    }
+
+    while(state->tail != state->head)
+    {
+      batch[nr_entries++] = state->ring[state->tail++ % MONITOR_RING_SIZE];
+    }
+    state->indications_pending = 0;
+    pthread_mutex_unlock(&state->mutex);
+
+    for(uint32_t i = 0; i < nr_entries; i++)
+    {
+      frame = batch[i].frame;
+
+      if (count == 0 || frames < (uint64_t) count)
+      {
+        switch(output->format)
+        {
+          case MONITOR_TEXT:    monitor_text(output, frame, batch[i].realtime_us);    break;
+          case MONITOR_JSON:    monitor_json(output, frame, batch[i].realtime_us);    break;
+          case MONITOR_BINARY:  monitor_binary(output, frame, batch[i].realtime_us);  break;
+        }
+        frames++;
+      }
+
+      if (frame->command == COMMAND_APS_DATA_INDICATION && frame->sequence_number == fetch_sequence)
+      {
+        fetch_sequence = -1;
+      }
+
+      conbee_free_frame(frame);
+    }
+
+    // frames rejected by the filter are queued for waiters, there are none
+    while(conbee_poll_frame(dev, &frame) == 1)
+    {
+      if (frame->command == COMMAND_APS_DATA_INDICATION && frame->sequence_number == fetch_sequence)
+      {
+        fetch_sequence = -1;
+      }
+
+      conbee_free_frame(frame);
+    }
+
+    monitor_flush(output);
+
+    // fetch the next indication while the stick reports pending ones, one request at a time
+    if (fetch && conbee_device_state_snapshot(dev, &device_state) == 0 && device_state.apsde_data_indication &&
+        (fetch_sequence < 0 || monitor_realtime_us() - fetched_us > MONITOR_FETCH_TIMEOUT))
+    {
+      fetch_sequence = conbee_enqueue_frame(dev, conbee_device_get_aps_data_request());
+      fetched_us     = monitor_realtime_us();
+    }
+  }
+
+  conbee_set_device_state_callback(dev, NULL, NULL);
+  conbee_set_frame_subscriber(dev, NULL, NULL);
+  conbee_set_frame_subscriber_filter(dev, NULL, 0, APS_MATCH_ANY);
+
+  // the ring is not touched by the worker anymore
+  while(state->tail != state->head)
+  {
+    conbee_free_frame(state->ring[state->tail++ % MONITOR_RING_SIZE].frame);
+  }
+
+  fprintf(stderr, "frames %lu dropped %lu\n", (unsigned long) frames, (unsigned long) state->dropped);
+
+  pthread_cond_destroy(&state->cond);
+  pthread_mutex_destroy(&state->mutex);
+  free(state);
+  free(output);
+
+  return 0;
+}
@@ -20,7 +20,7 @@
 /** @file */
 #include<conbee.h>
 
-int print_network_mode(int argc, char **argv);
+int print_network_mode(struct conbee_device *dev, int argc, char **argv);
 
 
 #endif
@@ -2,21 +2,12 @@
 #include <string.h>
 #include <stdio.h>
 
-extern char conbee_device_name[200];
-
-int print_nwk_ext_panid(int argc, char **argv)
+int print_nwk_ext_panid(struct conbee_device *dev, int argc, char **argv)
 {
-  struct conbee_device dev;
   uint64_t panid;
   int32_t err;
 
-  err = conbee_connect(&dev, conbee_device_name);
-  if (err < 0)
-  {
-    return -1;
-  }
-
-  err = conbee_get_nwk_extended_panid(&dev, &panid);
+  err = conbee_get_nwk_extended_panid(dev, &panid);
   if (err < 0)
   {
     fprintf(stderr, "Error getting nwk panid\n");
@@ -26,7 +17,5 @@ int print_nwk_ext_panid(int argc, char **argv)
     printf("Current NWK EXT PANID: %lu(0x%.8lX)\n", panid, panid);
   }
 
-  conbee_close(&dev);
-
-  return 0;
+  return err < 0 ? -1 : 0;
 }
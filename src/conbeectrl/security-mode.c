@@ -2,21 +2,12 @@
 #include <string.h>
 #include <stdio.h>
 
-extern char conbee_device_name[200];
-
-int print_security_mode(int argc, char **argv)
+int print_security_mode(struct conbee_device *dev, int argc, char **argv)
 {
-  struct conbee_device dev;
   uint8_t mode;
   int32_t err;
 
-  err = conbee_connect(&dev, conbee_device_name);
-  if (err < 0)
-  {
-    return -1;
-  }
-
-  err = conbee_get_security_mode(&dev, &mode);
+  err = conbee_get_security_mode(dev, &mode);
   if (err < 0)
   {
     fprintf(stderr, "Error getting security mode\n");
@@ -45,7 +36,5 @@ int print_security_mode(int argc, char **argv)
     }
   }
 
-  conbee_close(&dev);
-
-  return 0;
+  return err < 0 ? -1 : 0;
 }
@@ -0,0 +1,496 @@
+#include <conbee.h>
+#include <conbee-internal.h>
+#include <slip.h>
+#include <crc16.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <argparse.h>
+#include <conbeectrl/commands.h>
+
+extern char conbee_device_name[200];
+
+/// the maximum number of clients connected at once
+#define SERVE_MAX_CLIENTS     32
+
+/// number of bytes read from a client at once
+#define SERVE_CHUNK_SIZE      512
+
+/// size of the buffer of a decoded frame, including the checksum
+#define SERVE_PACKET_SIZE     1024
+
+/**
+* @brief a connected client, it speaks the protocol of the stick
+*/
+struct serve_client
+{
+  /// socket of the client, -1 if the slot is free
+  int fd;
+
+  /// incremented whenever the slot is reused, outstanding responses of the old client are dropped
+  uint32_t generation;
+
+  /// decoder for the frames sent by the client
+  struct slip_decoder decoder;
+
+  /// buffer of the decoder
+  uint8_t packet[SERVE_PACKET_SIZE];
+};
+
+/**
+* @brief a request forwarded to the stick whose response is outstanding
+*/
+struct serve_pending
+{
+  /// the request is outstanding
+  uint8_t in_use;
+
+  /// the command of the request
+  uint8_t command;
+
+  /// the sequence number the client used
+  uint8_t sequence_number;
+
+  /// the slot of the client
+  uint8_t client;
+
+  /// the generation of the client slot
+  uint32_t generation;
+};
+
+/**
+* @brief the state of the daemon
+*/
+struct serve_state
+{
+  /// mutex protecting clients and pending, the worker routes responses while the main loop reads requests
+  pthread_mutex_t mutex;
+
+  /// the client slots
+  struct serve_client clients[SERVE_MAX_CLIENTS];
+
+  /// the outstanding requests indexed by the sequence number used towards the stick
+  struct serve_pending pending[256];
+
+  /// number of requests forwarded
+  uint64_t requests;
+
+  /// number of responses routed back
+  uint64_t responses;
+
+  /// number of unsolicited frames
+  uint64_t unsolicited;
+
+  /// number of frames dropped because a client did not keep up
+  uint64_t dropped;
+};
+
+/// set by the signal handler to stop serving
+static volatile sig_atomic_t serve_stop = 0;
+
+/**
+* @brief stop serving on SIGINT and SIGTERM
+*/
+static void serve_signal(int signal)
+{
+  (void) signal;
+  serve_stop = 1;
+}
+
+/**
+* @brief write a received frame with the given sequence number to a client
+*
+* the state has to be locked
+*/
+static void serve_send(struct serve_state *state, struct serve_client *client, struct conbee_frame *frame, uint8_t sequence_number)
+{
+  uint8_t packet[5 + SERVE_PACKET_SIZE];
+  uint8_t encoded[2 * sizeof(packet) + 2];
+  uint16_t length = 5 + frame->payload_length;
+
+  if (length + 2 > (uint16_t) sizeof(packet))
+  {
+    state->dropped++;
+    return;
+  }
+
+  packet[0] = frame->command;
+  packet[1] = sequence_number;
+  packet[2] = frame->status;
+  packet[3] = frame->length & 0xFF;
+  packet[4] = frame->length >> 8;
+  if (frame->payload_length > 0)
+  {
+    memcpy(&packet[5], frame->payload, frame->payload_length);
+  }
+
+  uint16_t crc = crc16(packet, length);
+  packet[length++] = crc & 0xFF;
+  packet[length++] = crc >> 8;
+
+  uint32_t encoded_length = 0;
+  encoded[encoded_length++] = END;
+  encoded_length += slip_encode(packet, length, &encoded[encoded_length]);
+  encoded[encoded_length++] = END;
+
+  // never block the worker, a client not reading its socket loses frames
+  if (send(client->fd, encoded, encoded_length, MSG_DONTWAIT | MSG_NOSIGNAL) != (ssize_t) encoded_length)
+  {
+    state->dropped++;
+  }
+}
+
+/**
+* @brief route a frame received from the stick to its client or to all clients
+*
+* called by the worker of the device
+*/
+static int32_t serve_route(struct conbee_device *dev, struct conbee_frame *frame, void *userdata)
+{
+  struct serve_state *state       = (struct serve_state *) userdata;
+  struct serve_pending *pending   = &state->pending[frame->sequence_number];
+
+  (void) dev;
+
+  pthread_mutex_lock(&state->mutex);
+
+  if (pending->in_use && pending->command == frame->command)
+  {
+    struct serve_client *client = &state->clients[pending->client];
+
+    pending->in_use = 0;
+    if (client->fd >= 0 && client->generation == pending->generation)
+    {
+      serve_send(state, client, frame, pending->sequence_number);
+    }
+    state->responses++;
+  }
+  else
+  {
+    // state changes, aps confirms and indications are meant for everybody
+    for(int i = 0; i < SERVE_MAX_CLIENTS; i++)
+    {
+      if (state->clients[i].fd >= 0)
+      {
+        serve_send(state, &state->clients[i], frame, frame->sequence_number);
+      }
+    }
+    state->unsolicited++;
+  }
+
+  pthread_mutex_unlock(&state->mutex);
+
+  conbee_free_frame(frame);
+
+  return 1;
+}
+
+/**
+* @brief forward a request of a client to the stick using a sequence number of the daemon
+*/
+static void serve_forward(struct conbee_device *dev, struct serve_state *state, uint8_t slot, uint8_t *packet, uint32_t length)
+{
+  // the header and the checksum at least
+  if (length < 5 + sizeof(uint16_t) || crc16(packet, length - 2) != (packet[length - 2] | (packet[length - 1] << 8)))
+  {
+    fprintf(stderr, "error: dropping invalid frame of client %u\n", slot);
+    return;
+  }
+
+  struct conbee_frame *frame = conbee_init_frame();
+  frame->wire = malloc(2 * length + 2);
+  if (frame->wire == NULL)
+  {
+    conbee_free_frame(frame);
+    return;
+  }
+
+  uint8_t sequence_number = conbee_reserve_sequence_numbers(dev, 1);
+
+  pthread_mutex_lock(&state->mutex);
+  state->pending[sequence_number].in_use          = 1;
+  state->pending[sequence_number].command         = packet[0];
+  state->pending[sequence_number].sequence_number = packet[1];
+  state->pending[sequence_number].client          = slot;
+  state->pending[sequence_number].generation      = state->clients[slot].generation;
+  state->requests++;
+  pthread_mutex_unlock(&state->mutex);
+
+  packet[1] = sequence_number;
+  uint16_t crc = crc16(packet, length - 2);
+  packet[length - 2] = crc & 0xFF;
+  packet[length - 1] = crc >> 8;
+
+  uint8_t *out = frame->wire;
+  *out++ = END;
+  out   += slip_encode(packet, length, out);
+  *out++ = END;
+
+  frame->command          = packet[0];
+  frame->sequence_number  = sequence_number;
+  frame->wire_length      = out - frame->wire;
+  frame->wire_frames      = 1;
+
+  conbee_push_frame(dev, frame);
+}
+
+/**
+* @brief read what a client sent and forward all complete frames
+*
+* @return  0 - everything went fine
+* @return -1 - the client disconnected
+*/
+static int32_t serve_read(struct conbee_device *dev, struct serve_state *state, uint8_t slot)
+{
+  struct serve_client *client = &state->clients[slot];
+  uint8_t chunk[SERVE_CHUNK_SIZE];
+
+  ssize_t length = read(client->fd, chunk, sizeof(chunk));
+  if (length < 0 && errno == EINTR)
+  {
+    return 0;
+  }
+
+  if (length <= 0)
+  {
+    return -1;
+  }
+
+  uint32_t offset = 0;
+  while(offset < (uint32_t) length)
+  {
+    uint32_t packet_length = 0;
+
+    offset += slip_decode(&client->decoder, &chunk[offset], length - offset, &packet_length);
+    if (packet_length > 0)
+    {
+      serve_forward(dev, state, slot, client->decoder.packet, packet_length);
+    }
+  }
+
+  return 0;
+}
+
+/**
+* @brief accept a new client
+*/
+static void serve_accept(struct serve_state *state, int listener)
+{
+  int fd = accept(listener, NULL, NULL);
+  if (fd < 0)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&state->mutex);
+  for(int i = 0; i < SERVE_MAX_CLIENTS; i++)
+  {
+    struct serve_client *client = &state->clients[i];
+
+    if (client->fd < 0)
+    {
+      client->fd = fd;
+      client->generation++;
+      slip_decoder_init(&client->decoder, client->packet, sizeof(client->packet));
+      pthread_mutex_unlock(&state->mutex);
+      return;
+    }
+  }
+  pthread_mutex_unlock(&state->mutex);
+
+  fprintf(stderr, "error: more than %d clients, rejecting client\n", SERVE_MAX_CLIENTS);
+  close(fd);
+}
+
+/**
+* @brief disconnect a client, its outstanding responses are dropped
+*/
+static void serve_disconnect(struct serve_state *state, uint8_t slot)
+{
+  pthread_mutex_lock(&state->mutex);
+  close(state->clients[slot].fd);
+  state->clients[slot].fd = -1;
+  pthread_mutex_unlock(&state->mutex);
+}
+
+/**
+* @brief create the listening socket, a stale socket of a crashed daemon is replaced
+*
+* @return >=0 - the listening socket
+* @return  -1 - error occured
+*/
+static int serve_listen(const char *path)
+{
+  struct sockaddr_un addr;
+
+  if (strlen(path) >= sizeof(addr.sun_path))
+  {
+    fprintf(stderr, "error: socket path %s is too long\n", path);
+    return -1;
+  }
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+  {
+    return -1;
+  }
+
+  // only remove the socket if nobody answers on it
+  if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0)
+  {
+    fprintf(stderr, "error: a daemon is already serving on %s\n", path);
+    close(fd);
+    return -1;
+  }
+  unlink(path);
+
+  if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 || listen(fd, SERVE_MAX_CLIENTS) < 0)
+  {
+    fprintf(stderr, "error: listening on %s failed (%s)\n", path, strerror(errno));
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+int serve(struct conbee_device *dev, int argc, char **argv)
+{
+  struct serve_state *state;
+  struct sigaction action;
+  sigset_t blocked, unblocked;
+  char socket_path[108] = "";
+  fd_set rfds;
+
+  struct arg_parse_ctx *argparse_ctx = argparse_init();
+
+  // argument for the socket
+  struct arg_str socket_arg = {
+      {ARG_STR,0,0},
+      's',
+      "socket",
+      socket_path,
+      107,
+      "the unix socket to serve on (default: derived from the device name)",
+  };
+  argparse_add_string(argparse_ctx, &socket_arg);
+
+  /// parse the commandline
+  int ret=argparse_parse(argparse_ctx, argc, argv);
+
+  /// free context
+  argparse_free(argparse_ctx);
+
+  if (ret < 0)
+  {
+    return -1;
+  }
+
+  if (socket_path[0] == 0)
+  {
+    conbeectrl_socket_path(conbee_device_name, socket_path, sizeof(socket_path));
+  }
+
+  state = malloc(sizeof(struct serve_state));
+  if (state == NULL)
+  {
+    return -1;
+  }
+  memset(state, 0, sizeof(struct serve_state));
+  pthread_mutex_init(&state->mutex, NULL);
+  for(int i = 0; i < SERVE_MAX_CLIENTS; i++)
+  {
+    state->clients[i].fd = -1;
+  }
+
+  int listener = serve_listen(socket_path);
+  if (listener < 0)
+  {
+    free(state);
+    return -1;
+  }
+
+  // the signals are only delivered while waiting, so serve_stop is never missed
+  sigemptyset(&blocked);
+  sigaddset(&blocked, SIGINT);
+  sigaddset(&blocked, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &blocked, &unblocked);
+  sigdelset(&unblocked, SIGINT);
+  sigdelset(&unblocked, SIGTERM);
+
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = serve_signal;
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+
+  conbee_set_frame_subscriber(dev, serve_route, state);
+
+  printf("serving %s on %s\n", conbee_device_name, socket_path);
+  fflush(stdout);
+
+  while(!serve_stop)
+  {
+    int maxfd = listener;
+
+    FD_ZERO(&rfds);
+    FD_SET(listener, &rfds);
+    for(int i = 0; i < SERVE_MAX_CLIENTS; i++)
+    {
+      // only the main loop changes the client sockets, no lock needed for reading them
+      if (state->clients[i].fd >= 0)
+      {
+        FD_SET(state->clients[i].fd, &rfds);
+        maxfd = state->clients[i].fd > maxfd ? state->clients[i].fd : maxfd;
+      }
+    }
+
+    if (pselect(maxfd + 1, &rfds, NULL, NULL, NULL, &unblocked) < 0)
+    {
+      continue;
+    }
+
+    for(int i = 0; i < SERVE_MAX_CLIENTS; i++)
+    {
+      if (state->clients[i].fd >= 0 && FD_ISSET(state->clients[i].fd, &rfds) && serve_read(dev, state, i) < 0)
+      {
+        serve_disconnect(state, i);
+      }
+    }
+
+    if (FD_ISSET(listener, &rfds))
+    {
+      serve_accept(state, listener);
+    }
+  }
+
+  // no routing after this returns, the clients can be freed
+  conbee_set_frame_subscriber(dev, NULL, NULL);
+
+  for(int i = 0; i < SERVE_MAX_CLIENTS; i++)
+  {
+    if (state->clients[i].fd >= 0)
+    {
+      close(state->clients[i].fd);
+    }
+  }
+  close(listener);
+  unlink(socket_path);
+
+  fprintf(stderr, "requests %lu responses %lu unsolicited %lu dropped %lu\n", (unsigned long) state->requests,
+          (unsigned long) state->responses, (unsigned long) state->unsolicited, (unsigned long) state->dropped);
+
+  pthread_mutex_destroy(&state->mutex);
+  free(state);
+
+  return 0;
+}
@@ -20,7 +20,7 @@
 /** @file */
 #include<conbee.h>
 
-int set_aps_ext_panid(int argc, char **argv);
+int set_aps_ext_panid(struct conbee_device *dev, int argc, char **argv);
 
 
 #endif
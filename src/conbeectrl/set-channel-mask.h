@@ -20,7 +20,7 @@
 /** @file */
 #include<conbee.h>
 
-int set_channel_mask(int argc, char **argv);
+int set_channel_mask(struct conbee_device *dev, int argc, char **argv);
 
 
 #endif
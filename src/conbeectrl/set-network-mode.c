@@ -3,11 +3,8 @@
 #include <stdio.h>
 #include <argparse.h>
 
-extern char conbee_device_name[200];
-
-int set_network_mode(int argc, char **argv)
+int set_network_mode(struct conbee_device *dev, int argc, char **argv)
 {
-  struct conbee_device dev;
   int mode;
   int32_t err;
 
@@ -25,14 +22,13 @@ int set_network_mode(int argc, char **argv)
 
   /// parse the commandline
   int ret=argparse_parse(argparse_ctx, argc, argv);
-
-  err = conbee_connect(&dev, conbee_device_name);
-  if (err < 0)
+  if (ret < 0)
   {
+    argparse_free(argparse_ctx);
     return -1;
   }
 
-  err = conbee_set_network_mode(&dev, mode);
+  err = conbee_set_network_mode(dev, mode);
   if (err < 0)
   {
     fprintf(stderr, "Error setting network mode\n");
@@ -42,10 +38,8 @@ int set_network_mode(int argc, char **argv)
     printf("Network mode set to %s\n", mode == 0 ? "Router" : "Coordinator");
   }
 
-  conbee_close(&dev);
-
   /// free context
   argparse_free(argparse_ctx);
 
-  return 0;
+  return err < 0 ? -1 : 0;
 }
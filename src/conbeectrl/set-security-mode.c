@@ -4,11 +4,8 @@
 #include <stdlib.h>
 #include <argparse.h>
 
-extern char conbee_device_name[200];
-
-int set_security_mode(int argc, char **argv)
+int set_security_mode(struct conbee_device *dev, int argc, char **argv)
 {
-  struct conbee_device dev;
   int mode;
   int32_t err;
 
@@ -26,14 +23,13 @@ int set_security_mode(int argc, char **argv)
 
   /// parse the commandline
   int ret=argparse_parse(argparse_ctx, argc, argv);
-
-  err = conbee_connect(&dev, conbee_device_name);
-  if (err < 0)
+  if (ret < 0)
   {
+    argparse_free(argparse_ctx);
     return -1;
   }
 
-  err = conbee_set_security_mode(&dev, mode);
+  err = conbee_set_security_mode(dev, mode);
   if (err < 0)
   {
     fprintf(stderr, "Error setting security mode\n");
@@ -62,10 +58,8 @@ int set_security_mode(int argc, char **argv)
     }
   }
 
-  conbee_close(&dev);
-
   /// free context
   argparse_free(argparse_ctx);
 
-  return 0;
+  return err < 0 ? -1 : 0;
 }
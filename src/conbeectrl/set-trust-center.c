@@ -4,13 +4,10 @@
 #include <stdlib.h>
 #include <argparse.h>
 
-extern char conbee_device_name[200];
-
-int set_trust_center(int argc, char **argv)
+int set_trust_center(struct conbee_device *dev, int argc, char **argv)
 {
-  struct conbee_device dev;
   uint64_t addr;
-  char str_addr[20];
+  char str_addr[20] = "";
   int32_t err;
 
   struct arg_parse_ctx *argparse_ctx = argparse_init();
@@ -28,17 +25,16 @@ int set_trust_center(int argc, char **argv)
 
   /// parse the commandline
   int ret=argparse_parse(argparse_ctx, argc, argv);
-
-  err = conbee_connect(&dev, conbee_device_name);
-  if (err < 0)
+  if (ret < 0)
   {
+    argparse_free(argparse_ctx);
     return -1;
   }
 
   // convert hex string to uint32_t
   addr=strtol(str_addr+2,NULL,16);
 
-  err = conbee_set_trust_center_addr(&dev, addr);
+  err = conbee_set_trust_center_addr(dev, addr);
   if (err < 0)
   {
     fprintf(stderr, "Error setting trust center\n");
@@ -48,10 +44,8 @@ int set_trust_center(int argc, char **argv)
     printf("Trust Center set to %s\n", str_addr);
   }
 
-  conbee_close(&dev);
-
   /// free context
   argparse_free(argparse_ctx);
 
-  return 0;
+  return err < 0 ? -1 : 0;
 }
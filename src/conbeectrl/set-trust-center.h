@@ -20,7 +20,7 @@
 /** @file */
 #include<conbee.h>
 
-int set_trust_center(int argc, char **argv);
+int set_trust_center(struct conbee_device *dev, int argc, char **argv);
 
 
 #endif
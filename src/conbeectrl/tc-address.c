@@ -2,21 +2,12 @@
 #include <string.h>
 #include <stdio.h>
 
-extern char conbee_device_name[200];
-
-int print_tc_addr(int argc, char **argv)
+int print_tc_addr(struct conbee_device *dev, int argc, char **argv)
 {
-  struct conbee_device dev;
   uint64_t addr;
   int32_t err;
 
-  err = conbee_connect(&dev, conbee_device_name);
-  if (err < 0)
-  {
-    return -1;
-  }
-
-  err = conbee_get_trust_center_addr(&dev, &addr);
+  err = conbee_get_trust_center_addr(dev, &addr);
   if (err < 0)
   {
     fprintf(stderr, "Error getting trust center address\n");
@@ -26,7 +17,5 @@ int print_tc_addr(int argc, char **argv)
     printf("Current Trust Center Address: %ld(0x%.16lX)\n", addr, addr);
   }
 
-  conbee_close(&dev);
-
-  return 0;
+  return err < 0 ? -1 : 0;
 }
@@ -20,7 +20,7 @@
 /** @file */
 #include<conbee.h>
 
-int print_tc_addr(int argc, char **argv);
+int print_tc_addr(struct conbee_device *dev, int argc, char **argv);
 
 
 #endif
@@ -20,7 +20,7 @@
 /** @file */
 #include<conbee.h>
 
-int print_version(int argc, char **argv);
+int print_version(struct conbee_device *dev, int argc, char **argv);
 
 
 #endif
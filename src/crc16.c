@@ -20,24 +20,49 @@
 #include <crc16.h>
 
 
+/**
+* @brief calculate the checksum of a conbee frame
+*
+* the checksum is the two's complement of the sum of all bytes
+*
+* @param buffer - the bytes of the frame
+* @param length - the number of bytes
+*
+* @return the checksum, to be transmitted little endian
+*/
 uint16_t crc16(uint8_t *buffer, uint32_t length)
 {
-  uint16_t crc  = 0;
-  uint8_t  crc0 = 0;
-  uint8_t  crc1 = 0;
+  return crc16_finish(crc16_update(0, buffer, length));
+}
 
+/**
+* @brief add bytes to a running checksum sum
+*
+* @param sum    - the sum so far, zero for a new checksum
+* @param buffer - the bytes to add
+* @param length - the number of bytes
+*
+* @return the new sum
+*/
+uint16_t crc16_update(uint16_t sum, uint8_t *buffer, uint32_t length)
+{
   while(length--)
   {
-    crc += *buffer;
+    sum += *buffer;
     buffer++;
   }
 
-  crc0 = (~crc + 1) & 0xFF;
-  crc1 = ((~crc + 1) >> 8) & 0xFF;
-
-  crc = crc1;
-  crc = crc << 8;
-  crc +=crc0;
+  return sum;
+}
 
-  return crc;
+/**
+* @brief turn a sum built by crc16_update into the checksum
+*
+* @param sum - the sum of all bytes of the frame
+*
+* @return the checksum, to be transmitted little endian
+*/
+uint16_t crc16_finish(uint16_t sum)
+{
+  return (uint16_t) (~sum + 1);
 }
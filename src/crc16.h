@@ -22,6 +22,39 @@
 #include <stdint.h>
 
 
+/**
+* @brief calculate the checksum of a conbee frame
+*
+* the checksum is the two's complement of the sum of all bytes
+*
+* @param buffer - the bytes of the frame
+* @param length - the number of bytes
+*
+* @return the checksum, to be transmitted little endian
+*/
 uint16_t crc16(uint8_t *buffer, uint32_t length);
 
+/**
+* @brief add bytes to a running checksum sum
+*
+* allows to build the checksum of frames which only differ in a few bytes without
+* summing up the common bytes again, finish the sum with crc16_finish
+*
+* @param sum    - the sum so far, zero for a new checksum
+* @param buffer - the bytes to add
+* @param length - the number of bytes
+*
+* @return the new sum
+*/
+uint16_t crc16_update(uint16_t sum, uint8_t *buffer, uint32_t length);
+
+/**
+* @brief turn a sum built by crc16_update into the checksum
+*
+* @param sum - the sum of all bytes of the frame
+*
+* @return the checksum, to be transmitted little endian
+*/
+uint16_t crc16_finish(uint16_t sum);
+
 #endif
@@ -0,0 +1,666 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#define _GNU_SOURCE
+#include <emulator/emulator.h>
+#include <slip.h>
+#include <crc16.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/select.h>
+
+/// size of the buffer collecting encoded frames before writing them
+#define EMULATOR_OUTPUT_SIZE          16384
+
+/// the version reported by the emulator, as a conbee II with firmware 0x26580700
+static const uint8_t emulator_version[4] = { 0x00, 0x07, 0x58, 0x26 };
+
+/**
+* @brief return the monotonic time in microseconds
+*/
+static uint64_t emulator_now_us()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return ((uint64_t) now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+* @brief store an integer parameter value in the emulator
+*/
+static void emulator_set_value(struct conbee_emulator *emulator, uint8_t id, uint64_t value)
+{
+  const struct conbee_parameter_descriptor *descriptor = conbee_parameter_descriptor(id);
+  struct conbee_parameter parameter;
+
+  conbee_parameter_encode(descriptor, value, &parameter);
+  memcpy(emulator->values[id], parameter.value.bytes, parameter.length);
+  emulator->lengths[id] = parameter.length;
+}
+
+/**
+* @brief set the parameters of a factory new coordinator
+*/
+static void emulator_init_values(struct conbee_emulator *emulator)
+{
+  memset(emulator->values, 0, sizeof(emulator->values));
+  memset(emulator->lengths, 0, sizeof(emulator->lengths));
+
+  emulator_set_value(emulator, PARAM_MAC_ADDRESS,           0x00212effff012345ULL);
+  emulator_set_value(emulator, PARAM_NWK_PANID,             0x1a62);
+  emulator_set_value(emulator, PARAM_NWK_ADDRESS,           0x0000);
+  emulator_set_value(emulator, PARAM_NWK_EXT_PANID,         0x00212effff012345ULL);
+  emulator_set_value(emulator, PARAM_APS_COORDINATOR,       NETWORK_MODE_COORDINATOR);
+  emulator_set_value(emulator, PARAM_CHANNEL_MASK,          0x02000000);
+  emulator_set_value(emulator, PARAM_APS_EXT_PANID,         0);
+  emulator_set_value(emulator, PARAM_TRUST_CENTER_ADDRESS,  0x00212effff012345ULL);
+  emulator_set_value(emulator, PARAM_SECURITY_MODE,         3);
+  emulator_set_value(emulator, PARAM_CURRENT_CHANNEL,       25);
+  emulator_set_value(emulator, PARAM_PROTOCOL_VERSION,      0x010B);
+  emulator_set_value(emulator, PARAM_NWK_UPDATE_ID,         0);
+  emulator_set_value(emulator, PARAM_WATCHDOG_TTL,          0);
+
+  for(uint8_t i = 0; i < 16; i++)
+  {
+    emulator->values[PARAM_NETWORK_KEY][i] = i + 1;
+  }
+  emulator->lengths[PARAM_NETWORK_KEY] = 16;
+}
+
+/**
+* @brief return the device state byte of the emulator
+*/
+static uint8_t emulator_state_byte(struct conbee_emulator *emulator)
+{
+  // the emulator never runs out of request slots
+  return emulator->network_state | 0x20;
+}
+
+/**
+* @brief fill in the frame length of a frame without checksum
+*/
+static uint16_t emulator_finish_frame(uint8_t *frame, uint16_t length)
+{
+  frame[3] = length & 0xFF;
+  frame[4] = length >> 8;
+
+  return length;
+}
+
+/**
+* @brief queue a frame to be sent after the configured latency
+*
+* @param emulator - the emulator
+* @param frame    - the frame without checksum
+* @param length   - the number of bytes of the frame
+* @param delayed  - 1 to apply latency and jitter, 0 to send it with the next write
+*/
+static void emulator_queue(struct conbee_emulator *emulator, uint8_t *frame, uint16_t length, uint8_t delayed)
+{
+  uint64_t due = emulator_now_us();
+
+  if (emulator->nr_pending == EMULATOR_MAX_PENDING)
+  {
+    pthread_mutex_lock(&emulator->mutex_stats);
+    emulator->stats.errors++;
+    pthread_mutex_unlock(&emulator->mutex_stats);
+    return;
+  }
+
+  if (delayed)
+  {
+    due += emulator->config.latency_us;
+    if (emulator->config.jitter_us > 0)
+    {
+      due += rand() % (emulator->config.jitter_us + 1);
+    }
+  }
+
+  // insertion sort from the back, the queue is almost always in order already
+  uint32_t i = emulator->nr_pending++;
+  while(i > 0 && emulator->pending[i-1].due_us > due)
+  {
+    emulator->pending[i] = emulator->pending[i-1];
+    i--;
+  }
+
+  emulator->pending[i].due_us = due;
+  emulator->pending[i].length = length;
+  memcpy(emulator->pending[i].frame, frame, length);
+}
+
+/**
+* @brief build an aps data indication frame
+*
+* @return the number of bytes of the frame
+*/
+static uint16_t emulator_indication(struct conbee_emulator *emulator, uint8_t sequence_number, uint8_t *frame)
+{
+  uint16_t asdu_length = emulator->config.asdu_length;
+  uint16_t index = 0;
+  uint16_t src   = 0x1000 + (emulator->stats.indications & 0xFFF);
+
+  if (asdu_length > EMULATOR_MAX_FRAME - 40)
+  {
+    asdu_length = EMULATOR_MAX_FRAME - 40;
+  }
+
+  frame[index++] = COMMAND_APS_DATA_INDICATION;
+  frame[index++] = sequence_number;
+  frame[index++] = STATUS_SUCCESS;
+  index += 4;                                   // frame and payload length
+  frame[index++] = emulator_state_byte(emulator);
+  frame[index++] = DEST_ADDR_NWK;
+  frame[index++] = 0x00;                        // to the coordinator
+  frame[index++] = 0x00;
+  frame[index++] = 0x01;                        // dst endpoint
+  frame[index++] = DEST_ADDR_NWK;
+  frame[index++] = src & 0xFF;
+  frame[index++] = src >> 8;
+  frame[index++] = 0x01;                        // src endpoint
+  frame[index++] = emulator->config.profile_id & 0xFF;
+  frame[index++] = emulator->config.profile_id >> 8;
+  frame[index++] = emulator->config.cluster_id & 0xFF;
+  frame[index++] = emulator->config.cluster_id >> 8;
+  frame[index++] = asdu_length & 0xFF;
+  frame[index++] = asdu_length >> 8;
+  for(uint16_t i = 0; i < asdu_length; i++)
+  {
+    frame[index++] = i & 0xFF;
+  }
+  frame[index++] = 0x00;                        // reserved
+  frame[index++] = 0x00;
+  frame[index++] = 0xFF;                        // lqi
+  frame[index++] = 0x00;                        // reserved
+  frame[index++] = 0x00;
+  frame[index++] = 0x00;
+  frame[index++] = 0x00;
+  frame[index++] = (uint8_t) -60;               // rssi
+
+  frame[5] = (index - 7) & 0xFF;
+  frame[6] = (index - 7) >> 8;
+
+  return emulator_finish_frame(frame, index);
+}
+
+/**
+* @brief build a DEVICE_STATE_CHANGED frame
+*
+* @return the number of bytes of the frame
+*/
+static uint16_t emulator_state_changed(struct conbee_emulator *emulator, uint8_t *frame)
+{
+  frame[0] = COMMAND_DEVICE_STATE_CHANGED;
+  frame[1] = emulator->sequence_number++;
+  frame[2] = STATUS_SUCCESS;
+  frame[5] = emulator_state_byte(emulator);
+  frame[6] = 0x00;
+
+  return emulator_finish_frame(frame, 7);
+}
+
+/**
+* @brief answer one request received from the library
+*
+* @param emulator - the emulator
+* @param packet   - the slip decoded request including checksum
+* @param length   - the number of bytes of the request
+*/
+static void emulator_request(struct conbee_emulator *emulator, uint8_t *packet, uint32_t length)
+{
+  uint8_t frame[EMULATOR_MAX_FRAME];
+  uint16_t crc;
+  uint8_t id;
+
+  // line noise between END bytes is shorter than the checksum
+  if (length >= 7)
+  {
+    memcpy(&crc, &packet[length-2], sizeof(crc));
+  }
+
+  if (length < 7 || crc16(packet, length - 2) != crc)
+  {
+    pthread_mutex_lock(&emulator->mutex_stats);
+    emulator->stats.errors++;
+    pthread_mutex_unlock(&emulator->mutex_stats);
+    return;
+  }
+  length -= 2;
+
+  pthread_mutex_lock(&emulator->mutex_stats);
+  emulator->stats.requests++;
+  pthread_mutex_unlock(&emulator->mutex_stats);
+
+  frame[0] = packet[0];
+  frame[1] = packet[1];
+  frame[2] = STATUS_SUCCESS;
+
+  switch(packet[0])
+  {
+    case COMMAND_VERSION:
+                              memcpy(&frame[5], emulator_version, sizeof(emulator_version));
+                              emulator_queue(emulator, frame, emulator_finish_frame(frame, 9), 1);
+                              break;
+
+    case COMMAND_DEVICE_STATE:
+                              frame[5] = emulator_state_byte(emulator);
+                              frame[6] = 0x00;
+                              frame[7] = 0x00;
+                              emulator_queue(emulator, frame, emulator_finish_frame(frame, 8), 1);
+                              break;
+
+    case COMMAND_CHANGE_NETWORK_STATE:
+                              if (length < 6)
+                              {
+                                frame[2] = STATUS_INVALID_VALUE;
+                              }
+                              else
+                              {
+                                // joining an emulated network succeeds immediately
+                                emulator->network_state = packet[5] == NETWORK_OFFLINE ? NETWORK_OFFLINE : NETWORK_CONNECTED;
+                              }
+                              frame[5] = emulator->network_state;
+                              emulator_queue(emulator, frame, emulator_finish_frame(frame, 6), 1);
+                              emulator_queue(emulator, frame, emulator_state_changed(emulator, frame), 1);
+                              break;
+
+    case COMMAND_READ_PARAMETER:
+                              id = length > 7 ? packet[7] : 0xFF;
+                              frame[5] = 1;
+                              frame[6] = 0;
+                              frame[7] = id;
+                              if (id >= PARAMETER_CACHE_SIZE || emulator->lengths[id] == 0)
+                              {
+                                frame[2] = STATUS_UNSUPPORTED;
+                                emulator_queue(emulator, frame, emulator_finish_frame(frame, 8), 1);
+                                break;
+                              }
+                              frame[5] += emulator->lengths[id];
+                              memcpy(&frame[8], emulator->values[id], emulator->lengths[id]);
+                              emulator_queue(emulator, frame, emulator_finish_frame(frame, 8 + emulator->lengths[id]), 1);
+                              break;
+
+    case COMMAND_WRITE_PARAMETER:
+                              id = length > 7 ? packet[7] : 0xFF;
+                              frame[5] = 1;
+                              frame[6] = 0;
+                              frame[7] = id;
+                              if (id >= PARAMETER_CACHE_SIZE || emulator->lengths[id] == 0 ||
+                                  !(conbee_parameter_descriptor(id)->flags & PARAMETER_WRITABLE))
+                              {
+                                frame[2] = STATUS_UNSUPPORTED;
+                              }
+                              else if (length - 8 != emulator->lengths[id])
+                              {
+                                frame[2] = STATUS_INVALID_VALUE;
+                              }
+                              else
+                              {
+                                memcpy(emulator->values[id], &packet[8], emulator->lengths[id]);
+                              }
+                              emulator_queue(emulator, frame, emulator_finish_frame(frame, 8), 1);
+                              break;
+
+    case COMMAND_APS_DATA_REQUEST:
+                              frame[5] = 2;
+                              frame[6] = 0;
+                              frame[7] = emulator_state_byte(emulator);
+                              frame[8] = length > 7 ? packet[7] : 0;
+                              emulator_queue(emulator, frame, emulator_finish_frame(frame, 9), 1);
+                              break;
+
+    case COMMAND_APS_DATA_INDICATION:
+                              emulator_queue(emulator, frame, emulator_indication(emulator, packet[1], frame), 1);
+                              break;
+
+    default:
+                              pthread_mutex_lock(&emulator->mutex_stats);
+                              emulator->stats.errors++;
+                              pthread_mutex_unlock(&emulator->mutex_stats);
+                              return;
+  }
+}
+
+/**
+* @brief write all bytes of a buffer to the line
+*/
+static void emulator_write(struct conbee_emulator *emulator, uint8_t *buffer, uint32_t length)
+{
+  while(length > 0)
+  {
+    ssize_t err = write(emulator->fd, buffer, length);
+
+    if (err < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      return;
+    }
+
+    buffer += err;
+    length -= err;
+  }
+}
+
+/**
+* @brief encode a frame with checksum into the output buffer
+*
+* @return the new number of bytes in the output buffer
+*/
+static uint32_t emulator_encode(uint8_t *output, uint32_t used, uint8_t *frame, uint16_t length)
+{
+  uint16_t crc = crc16(frame, length);
+
+  frame[length]   = crc & 0xFF;
+  frame[length+1] = crc >> 8;
+
+  output[used++] = END;
+  used += slip_encode(frame, length + 2, &output[used]);
+  output[used++] = END;
+
+  return used;
+}
+
+/**
+* @brief the emulator thread, answers requests and generates traffic
+*/
+static void *emulator_run(void *arg)
+{
+  struct conbee_emulator *emulator = (struct conbee_emulator *) arg;
+  uint8_t *output = malloc(EMULATOR_OUTPUT_SIZE);
+  uint8_t packet[1500];
+  uint8_t chunk[512];
+  struct slip_decoder decoder;
+  uint8_t hangup          = 0;
+  uint64_t now            = emulator_now_us();
+  uint64_t next_state     = now;
+  uint64_t next_burst     = now;
+  uint64_t state_period   = emulator->config.state_changed_rate ? 1000000 / emulator->config.state_changed_rate : 0;
+  uint64_t burst_period   = emulator->config.indication_rate ? 1000000 / emulator->config.indication_rate : 0;
+
+  slip_decoder_init(&decoder, packet, sizeof(packet));
+
+  while(1)
+  {
+    uint8_t frame[EMULATOR_MAX_FRAME + 2];
+    uint32_t used = 0;
+
+    now = emulator_now_us();
+
+    // generated traffic does not wait for any latency
+    if (state_period > 0 && now >= next_state)
+    {
+      emulator_queue(emulator, frame, emulator_state_changed(emulator, frame), 0);
+      pthread_mutex_lock(&emulator->mutex_stats);
+      emulator->stats.state_changes++;
+      pthread_mutex_unlock(&emulator->mutex_stats);
+
+      // do not try to catch up after a stall
+      next_state = next_state + state_period > now ? next_state + state_period : now + state_period;
+    }
+
+    if (burst_period > 0 && now >= next_burst)
+    {
+      for(uint32_t i = 0; i < emulator->config.burst; i++)
+      {
+        emulator_queue(emulator, frame, emulator_indication(emulator, emulator->sequence_number++, frame), 0);
+        pthread_mutex_lock(&emulator->mutex_stats);
+        emulator->stats.indications++;
+        pthread_mutex_unlock(&emulator->mutex_stats);
+      }
+
+      next_burst = next_burst + burst_period > now ? next_burst + burst_period : now + burst_period;
+    }
+
+    // send everything due with as few writes as possible
+    uint32_t sent = 0;
+    while(sent < emulator->nr_pending && emulator->pending[sent].due_us <= now)
+    {
+      if (used + 2 * EMULATOR_MAX_FRAME + 8 > EMULATOR_OUTPUT_SIZE)
+      {
+        emulator_write(emulator, output, used);
+        used = 0;
+      }
+
+      used = emulator_encode(output, used, emulator->pending[sent].frame, emulator->pending[sent].length);
+      sent++;
+    }
+
+    if (sent > 0)
+    {
+      emulator_write(emulator, output, used);
+      emulator->nr_pending -= sent;
+      memmove(emulator->pending, &emulator->pending[sent], emulator->nr_pending * sizeof(struct conbee_emulator_pending));
+
+      pthread_mutex_lock(&emulator->mutex_stats);
+      emulator->stats.responses += sent;
+      pthread_mutex_unlock(&emulator->mutex_stats);
+    }
+
+    // sleep until the next event or until a request arrives
+    uint64_t wakeup = now + 100000;
+    if (state_period > 0 && next_state < wakeup)
+    {
+      wakeup = next_state;
+    }
+    if (burst_period > 0 && next_burst < wakeup)
+    {
+      wakeup = next_burst;
+    }
+    if (emulator->nr_pending > 0 && emulator->pending[0].due_us < wakeup)
+    {
+      wakeup = emulator->pending[0].due_us;
+    }
+
+    struct timeval tv;
+    uint64_t timeout = wakeup > now ? wakeup - now : 0;
+    tv.tv_sec  = timeout / 1000000;
+    tv.tv_usec = timeout % 1000000;
+
+    // nobody listens on a hung up terminal, look for a new session every 10ms
+    if (hangup && timeout > 10000)
+    {
+      tv.tv_sec  = 0;
+      tv.tv_usec = 10000;
+    }
+
+    fd_set rfds;
+    FD_ZERO(&rfds);
+    if (!hangup)
+    {
+      FD_SET(emulator->fd, &rfds);
+    }
+    FD_SET(emulator->stop_pipe[0], &rfds);
+    int maxfd = emulator->fd > emulator->stop_pipe[0] ? emulator->fd : emulator->stop_pipe[0];
+
+    int ready = select(maxfd + 1, &rfds, NULL, NULL, &tv);
+    hangup    = 0;
+
+    if (ready <= 0)
+    {
+      continue;
+    }
+
+    if (FD_ISSET(emulator->stop_pipe[0], &rfds))
+    {
+      break;
+    }
+
+    if (FD_ISSET(emulator->fd, &rfds))
+    {
+      ssize_t length = read(emulator->fd, chunk, sizeof(chunk));
+
+      // the library closed the terminal, wait for it to be opened again
+      if (length < 0 && errno == EIO)
+      {
+        hangup = 1;
+        emulator->nr_pending = 0;
+        slip_decoder_init(&decoder, packet, sizeof(packet));
+        continue;
+      }
+
+      // the library closed the other end of the socket
+      if (length == 0)
+      {
+        break;
+      }
+
+      uint32_t offset = 0;
+      while(length > 0 && offset < (uint32_t) length)
+      {
+        uint32_t packet_length = 0;
+
+        offset += slip_decode(&decoder, &chunk[offset], length - offset, &packet_length);
+        if (packet_length > 0)
+        {
+          emulator_request(emulator, packet, packet_length);
+        }
+      }
+    }
+  }
+
+  free(output);
+
+  return NULL;
+}
+
+/**
+* @brief open a pseudo terminal for the emulator
+*
+* @param name   - buffer receiving the name of the terminal the library has to connect to
+* @param length - size of the name buffer
+*
+* @return >=0 - the master side of the terminal
+* @return  -1 - error occured, use errno to find out what
+*/
+int32_t conbee_emulator_open_pty(char *name, uint32_t length)
+{
+  struct termios tty;
+  int32_t fd = posix_openpt(O_RDWR | O_NOCTTY);
+
+  if (fd < 0)
+  {
+    fprintf(stderr,"error: opening pseudo terminal failed (%s)\n", strerror (errno));
+    return -1;
+  }
+
+  if (grantpt(fd) < 0 || unlockpt(fd) < 0 || ptsname_r(fd, name, length) != 0)
+  {
+    fprintf(stderr,"error: preparing pseudo terminal failed (%s)\n", strerror (errno));
+    close(fd);
+    return -1;
+  }
+
+  // the emulator speaks binary slip frames just like the stick
+  if (tcgetattr(fd, &tty) == 0)
+  {
+    cfmakeraw(&tty);
+    tcsetattr(fd, TCSANOW, &tty);
+  }
+
+  return fd;
+}
+
+/**
+* @brief start emulating a stick on the given file descriptor
+*
+* @param emulator - the emulator
+* @param fd       - the line to the library, owned by the emulator from now on
+* @param config   - the traffic configuration, NULL for no latency and no generated traffic
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+*/
+int32_t conbee_emulator_start(struct conbee_emulator *emulator, int32_t fd, struct conbee_emulator_config *config)
+{
+  memset(emulator, 0, sizeof(struct conbee_emulator));
+
+  if (config != NULL)
+  {
+    emulator->config = *config;
+  }
+
+  emulator->fd            = fd;
+  emulator->network_state = NETWORK_OFFLINE;
+  emulator->pending       = malloc(EMULATOR_MAX_PENDING * sizeof(struct conbee_emulator_pending));
+
+  if (emulator->pending == NULL)
+  {
+    return -1;
+  }
+
+  if (pipe(emulator->stop_pipe) < 0)
+  {
+    free(emulator->pending);
+    return -1;
+  }
+
+  emulator_init_values(emulator);
+  pthread_mutex_init(&emulator->mutex_stats, NULL);
+
+  if (pthread_create(&emulator->thread, NULL, emulator_run, emulator) != 0)
+  {
+    close(emulator->stop_pipe[0]);
+    close(emulator->stop_pipe[1]);
+    free(emulator->pending);
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+* @brief stop the emulator and close its line
+*
+* @param emulator - the emulator
+*/
+void conbee_emulator_stop(struct conbee_emulator *emulator)
+{
+  uint8_t stop = 0;
+
+  write(emulator->stop_pipe[1], &stop, 1);
+  pthread_join(emulator->thread, NULL);
+
+  close(emulator->stop_pipe[0]);
+  close(emulator->stop_pipe[1]);
+  close(emulator->fd);
+  free(emulator->pending);
+}
+
+/**
+* @brief return the counters of the emulator
+*
+* @param emulator - the emulator
+* @param stats    - the counters
+*/
+void conbee_emulator_get_stats(struct conbee_emulator *emulator, struct conbee_emulator_stats *stats)
+{
+  pthread_mutex_lock(&emulator->mutex_stats);
+  *stats = emulator->stats;
+  pthread_mutex_unlock(&emulator->mutex_stats);
+}
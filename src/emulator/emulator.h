@@ -0,0 +1,177 @@
+#ifndef __CONNBEE_EMULATOR_H__
+#define __CONNBEE_EMULATOR_H__
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file */
+#include <stdint.h>
+#include <pthread.h>
+#include <conbee.h>
+
+/// maximum number of responses waiting for their latency to pass
+#define EMULATOR_MAX_PENDING          512
+
+/// maximum number of bytes of one emulated frame without checksum
+#define EMULATOR_MAX_FRAME            200
+
+/**
+* @brief configuration of the traffic generated by the emulator
+*/
+struct conbee_emulator_config
+{
+  /// delay of every response in microseconds
+  uint32_t latency_us;
+
+  /// random additional delay of every response in microseconds, 0 to 1 * jitter_us
+  uint32_t jitter_us;
+
+  /// number of DEVICE_STATE_CHANGED frames generated per second, 0 for none
+  uint32_t state_changed_rate;
+
+  /// number of aps data indication bursts generated per second, 0 for none
+  uint32_t indication_rate;
+
+  /// number of aps data indications sent back to back per burst
+  uint32_t burst;
+
+  /// number of asdu bytes of every generated indication
+  uint16_t asdu_length;
+
+  /// profile id of the generated indications
+  uint16_t profile_id;
+
+  /// cluster id of the generated indications
+  uint16_t cluster_id;
+};
+
+/**
+* @brief counters of the emulator
+*/
+struct conbee_emulator_stats
+{
+  /// number of requests received
+  uint64_t requests;
+
+  /// number of responses sent
+  uint64_t responses;
+
+  /// number of DEVICE_STATE_CHANGED frames sent
+  uint64_t state_changes;
+
+  /// number of aps data indications sent
+  uint64_t indications;
+
+  /// number of received frames with wrong checksum or unknown command
+  uint64_t errors;
+};
+
+/**
+* @brief a response waiting for its latency to pass
+*/
+struct conbee_emulator_pending
+{
+  /// monotonic time the response is due in microseconds
+  uint64_t due_us;
+
+  /// number of bytes of the frame
+  uint16_t length;
+
+  /// the frame without checksum
+  uint8_t frame[EMULATOR_MAX_FRAME];
+};
+
+/**
+* @brief an emulated conbee stick talking to the library through a file descriptor
+*/
+struct conbee_emulator
+{
+  /// file descriptor of the line, e.g. a pty master or the peer of a loopback transport
+  int32_t fd;
+
+  /// the traffic configuration
+  struct conbee_emulator_config config;
+
+  /// the parameter values indexed by parameter id
+  uint8_t values[PARAMETER_CACHE_SIZE][PARAMETER_MAX_LENGTH];
+
+  /// the number of bytes of every parameter, 0 for unsupported parameters
+  uint8_t lengths[PARAMETER_CACHE_SIZE];
+
+  /// the current network state (NETWORK_*)
+  uint8_t network_state;
+
+  /// sequence number of the next generated frame
+  uint8_t sequence_number;
+
+  /// responses waiting for their latency to pass, sorted by due time
+  struct conbee_emulator_pending *pending;
+
+  /// number of waiting responses
+  uint32_t nr_pending;
+
+  /// the counters
+  struct conbee_emulator_stats stats;
+
+  /// mutex protecting the counters
+  pthread_mutex_t mutex_stats;
+
+  /// pipe to stop the emulator thread
+  int stop_pipe[2];
+
+  /// the emulator thread
+  pthread_t thread;
+};
+
+/**
+* @brief open a pseudo terminal for the emulator
+*
+* @param name   - buffer receiving the name of the terminal the library has to connect to
+* @param length - size of the name buffer
+*
+* @return >=0 - the master side of the terminal
+* @return  -1 - error occured, use errno to find out what
+*/
+int32_t conbee_emulator_open_pty(char *name, uint32_t length);
+
+/**
+* @brief start emulating a stick on the given file descriptor
+*
+* @param emulator - the emulator
+* @param fd       - the line to the library, owned by the emulator from now on
+* @param config   - the traffic configuration, NULL for no latency and no generated traffic
+*
+* @return   0 - everything went fine
+* @return  -1 - error occured, use errno to find out what
+*/
+int32_t conbee_emulator_start(struct conbee_emulator *emulator, int32_t fd, struct conbee_emulator_config *config);
+
+/**
+* @brief stop the emulator and close its line
+*
+* @param emulator - the emulator
+*/
+void conbee_emulator_stop(struct conbee_emulator *emulator);
+
+/**
+* @brief return the counters of the emulator
+*
+* @param emulator - the emulator
+* @param stats    - the counters
+*/
+void conbee_emulator_get_stats(struct conbee_emulator *emulator, struct conbee_emulator_stats *stats);
+
+#endif
@@ -0,0 +1,153 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <argparse.h>
+#include <emulator/emulator.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+int main(int argc, char **argv)
+{
+  struct arg_parse_ctx *argparse_ctx = argparse_init();
+  struct conbee_emulator_config config;
+  struct conbee_emulator_stats stats;
+  struct conbee_emulator emulator;
+  char link_name[200] = "";
+  char pty_name[200];
+  int latency   = 0;
+  int jitter    = 0;
+  int state     = 0;
+  int rate      = 0;
+  int burst     = 1;
+  int asdu      = 8;
+  int cluster   = 0x0006;
+  int seconds   = 0;
+
+  // argument for a symlink to the terminal
+  struct arg_str link_arg = {
+      {ARG_STR,0,0},
+      'p',
+      "path",
+      link_name,
+      199,
+      "create a symlink with this name pointing to the emulated terminal"
+  };
+  argparse_add_string(argparse_ctx, &link_arg);
+
+  struct arg_int latency_arg  = {{ARG_INT,0,0}, 'L', "latency",   "delay of every response in microseconds", &latency};
+  struct arg_int jitter_arg   = {{ARG_INT,0,0}, 'J', "jitter",    "random additional delay of every response in microseconds", &jitter};
+  struct arg_int state_arg    = {{ARG_INT,0,0}, 's', "state",     "DEVICE_STATE_CHANGED frames per second (default: 0)", &state};
+  struct arg_int rate_arg     = {{ARG_INT,0,0}, 'i', "indications", "aps data indication bursts per second (default: 0)", &rate};
+  struct arg_int burst_arg    = {{ARG_INT,0,0}, 'b', "burst",     "aps data indications per burst (default: 1)", &burst};
+  struct arg_int asdu_arg     = {{ARG_INT,0,0}, 'a', "asdu",      "asdu bytes of every aps data indication (default: 8)", &asdu};
+  struct arg_int cluster_arg  = {{ARG_INT,0,0}, 'c', "cluster",   "cluster id of the aps data indications (default: 6)", &cluster};
+  struct arg_int seconds_arg  = {{ARG_INT,0,0}, 't', "time",      "stop after this many seconds (default: run until interrupted)", &seconds};
+
+  argparse_add_int(argparse_ctx, &latency_arg);
+  argparse_add_int(argparse_ctx, &jitter_arg);
+  argparse_add_int(argparse_ctx, &state_arg);
+  argparse_add_int(argparse_ctx, &rate_arg);
+  argparse_add_int(argparse_ctx, &burst_arg);
+  argparse_add_int(argparse_ctx, &asdu_arg);
+  argparse_add_int(argparse_ctx, &cluster_arg);
+  argparse_add_int(argparse_ctx, &seconds_arg);
+
+  /// parse the commandline
+  argparse_parse(argparse_ctx, argc, argv);
+
+  memset(&config, 0, sizeof(config));
+  config.latency_us         = latency;
+  config.jitter_us          = jitter;
+  config.state_changed_rate = state;
+  config.indication_rate    = rate;
+  config.burst              = burst;
+  config.asdu_length        = asdu;
+  config.profile_id         = 0x0104;
+  config.cluster_id         = cluster;
+
+  int32_t fd = conbee_emulator_open_pty(pty_name, sizeof(pty_name));
+  if (fd < 0)
+  {
+    argparse_free(argparse_ctx);
+    return -1;
+  }
+
+  if (link_name[0] != 0)
+  {
+    unlink(link_name);
+    if (symlink(pty_name, link_name) < 0)
+    {
+      fprintf(stderr,"error: creating symlink %s failed (%s)\n", link_name, strerror (errno));
+      close(fd);
+      argparse_free(argparse_ctx);
+      return -1;
+    }
+  }
+
+  // wait for the signals in main, the emulator thread must not be interrupted by them
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+  if (conbee_emulator_start(&emulator, fd, &config) < 0)
+  {
+    fprintf(stderr,"error: starting emulator failed (%s)\n", strerror (errno));
+    close(fd);
+    argparse_free(argparse_ctx);
+    return -1;
+  }
+
+  printf("%s\n", pty_name);
+  fflush(stdout);
+
+  if (seconds > 0)
+  {
+    struct timespec timeout = { seconds, 0 };
+    sigtimedwait(&signals, NULL, &timeout);
+  }
+  else
+  {
+    int signal;
+    sigwait(&signals, &signal);
+  }
+
+  conbee_emulator_get_stats(&emulator, &stats);
+  conbee_emulator_stop(&emulator);
+
+  if (link_name[0] != 0)
+  {
+    unlink(link_name);
+  }
+
+  printf("requests:      %lu\n", stats.requests);
+  printf("responses:     %lu\n", stats.responses);
+  printf("state changes: %lu\n", stats.state_changes);
+  printf("indications:   %lu\n", stats.indications);
+  printf("errors:        %lu\n", stats.errors);
+
+  /// free context
+  argparse_free(argparse_ctx);
+
+  return 0;
+}
@@ -0,0 +1,178 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <argparse.h>
+#include <conbee.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+* @brief what has been replayed so far
+*/
+struct replay_counters
+{
+  /// number of frames taken from the receive queue
+  uint64_t frames;
+
+  /// number of aps indications dispatched
+  uint64_t indications;
+
+  /// print every decoded frame
+  int print;
+};
+
+/**
+* @brief return the monotonic time in seconds
+*/
+static double replay_now()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+* @brief handler registered for every aps indication
+*/
+static int32_t replay_indication(struct conbee_device *dev, struct conbee_aps_indication *indication, void *userdata)
+{
+  struct replay_counters *counters = (struct replay_counters *) userdata;
+
+  (void) dev;
+
+  counters->indications++;
+
+  if (counters->print)
+  {
+    printf("  indication src 0x%04x/%u dst 0x%04x/%u profile 0x%04x cluster 0x%04x lqi %u rssi %d asdu",
+           indication->src_addr, indication->src_endpoint, indication->dst_addr, indication->dst_endpoint,
+           indication->profile_id, indication->cluster_id, indication->lqi, indication->rssi);
+    for(uint16_t i = 0; i < indication->asdu_length; i++)
+    {
+      printf(" %02x", indication->asdu[i]);
+    }
+    printf("\n");
+  }
+
+  return 0;
+}
+
+/**
+* @brief print and dispatch one received frame
+*/
+static void replay_frame(struct conbee_device *dev, struct conbee_frame *frame, struct replay_counters *counters)
+{
+  counters->frames++;
+
+  if (counters->print)
+  {
+    printf("cmd 0x%02x seq %3u status 0x%02x len %4u payload", frame->command, frame->sequence_number, frame->status, frame->length);
+    for(uint16_t i = 0; i < frame->payload_length; i++)
+    {
+      printf(" %02x", frame->payload[i]);
+    }
+    printf("\n");
+  }
+
+  if (frame->command == COMMAND_APS_DATA_INDICATION)
+  {
+    conbee_dispatch_aps_indication(dev, frame);
+  }
+
+  conbee_free_frame(frame);
+}
+
+int main(int argc, char **argv)
+{
+  struct arg_parse_ctx *argparse_ctx = argparse_init();
+  struct replay_counters counters;
+  struct conbee_device dev;
+  struct conbee_frame *frame;
+  struct conbee_stats stats;
+  char file_name[200] = "";
+  char address[220];
+  int fast            = 0;
+  int print           = 0;
+
+  // argument for the capture file
+  struct arg_str file_arg = {
+      {ARG_STR,1,0},
+      'f',
+      "file",
+      file_name,
+      199,
+      "the capture to replay"
+  };
+  argparse_add_string(argparse_ctx, &file_arg);
+
+  struct arg_int fast_arg  = {{ARG_INT,0,0}, 'F', "fast",  "1 to replay as fast as possible instead of at the original timing", &fast};
+  struct arg_int print_arg = {{ARG_INT,0,0}, 'p', "print", "1 to print every decoded frame, e.g. to compare library versions", &print};
+  argparse_add_int(argparse_ctx, &fast_arg);
+  argparse_add_int(argparse_ctx, &print_arg);
+
+  /// parse the commandline
+  argparse_parse(argparse_ctx, argc, argv);
+  argparse_free(argparse_ctx);
+
+  memset(&counters, 0, sizeof(counters));
+  counters.print = print;
+
+  snprintf(address, sizeof(address), "replay://%s%s", file_name, fast ? "?fast" : "");
+
+  double start = replay_now();
+
+  if (conbee_connect(&dev, address) < 0)
+  {
+    return -1;
+  }
+
+  conbee_register_aps_handler(&dev, APS_MATCH_ANY, APS_MATCH_ANY, APS_MATCH_ANY, APS_MATCH_ANY, replay_indication, &counters);
+
+  while(1)
+  {
+    // everything read before the end of the capture is queued once it is reported
+    int32_t finished = conbee_replay_finished(&dev);
+
+    while(conbee_poll_frame(&dev, &frame))
+    {
+      replay_frame(&dev, frame, &counters);
+    }
+
+    if (finished)
+    {
+      break;
+    }
+
+    usleep(100);
+  }
+
+  double elapsed = replay_now() - start;
+
+  conbee_get_stats(&dev, &stats);
+  conbee_close(&dev);
+
+  fprintf(stderr, "frames %lu indications %lu checksum failures %lu bytes %lu\n", (unsigned long) counters.frames,
+          (unsigned long) counters.indications, (unsigned long) stats.checksum_failures, (unsigned long) stats.rx_bytes);
+  fprintf(stderr, "%.3f s, %.0f frames/s, %.2f MB/s\n", elapsed, counters.frames / elapsed, stats.rx_bytes / elapsed / 1e6);
+
+  return 0;
+}
@@ -182,3 +182,131 @@ int slip_receive_packet(struct conbee_device *dev, uint8_t *buffer, uint32_t len
 
 
 }
+
+
+/**
+* @brief slip encode binary data into a buffer without the framing END bytes
+*
+* the output buffer has to provide at least 2*length bytes, which is the worst case
+* of every byte requiring an escape sequence
+*
+* @param buffer - the data to encode
+* @param length - the number of bytes to encode
+* @param output - the buffer the encoded bytes are written to
+*
+* @return the number of bytes written to output
+*/
+uint32_t slip_encode(uint8_t *buffer, uint32_t length, uint8_t *output)
+{
+  uint8_t *start = output;
+
+  while(length--)
+  {
+    switch(*buffer)
+    {
+      case END:
+                *output++ = ESC;
+                *output++ = ESC_END;
+                break;
+
+      case ESC:
+                *output++ = ESC;
+                *output++ = ESC_ESC;
+                break;
+
+      default:
+                *output++ = *buffer;
+    };
+
+    buffer++;
+  }
+
+  return output - start;
+}
+
+/**
+* @brief initialize an incremental slip decoder
+*
+* @param decoder - the decoder
+* @param packet  - buffer receiving the decoded packets
+* @param size    - size of the packet buffer, longer packets are truncated
+*/
+void slip_decoder_init(struct slip_decoder *decoder, uint8_t *packet, uint32_t size)
+{
+  decoder->packet   = packet;
+  decoder->size     = size;
+  decoder->received = 0;
+  decoder->escaped  = 0;
+  decoder->complete = 0;
+  decoder->escapes  = 0;
+}
+
+/**
+* @brief feed received bytes into an incremental slip decoder
+*
+* decoding stops after the first complete packet, call the function again with the
+* remaining bytes. The packet stays valid until the decoder is fed again.
+*
+* @param decoder       - the decoder
+* @param input         - the received bytes
+* @param length        - the number of received bytes
+* @param packet_length - set to the length of the decoded packet, 0 if no packet is complete yet
+*
+* @return the number of bytes consumed from input
+*/
+uint32_t slip_decode(struct slip_decoder *decoder, uint8_t *input, uint32_t length, uint32_t *packet_length)
+{
+  uint32_t consumed = 0;
+
+  *packet_length = 0;
+
+  // a packet returned by the previous call is done with now
+  if (decoder->complete)
+  {
+    decoder->received = 0;
+    decoder->complete = 0;
+  }
+
+  while(consumed < length)
+  {
+    uint8_t c = input[consumed++];
+
+    if (decoder->escaped == 1)
+    {
+      // same protocol violation handling as slip_receive_packet, keep unknown bytes
+      if (c == ESC_END)
+      {
+        c = END;
+      }
+      else if (c == ESC_ESC)
+      {
+        c = ESC;
+      }
+      decoder->escaped = 0;
+    }
+    else if (c == ESC)
+    {
+      decoder->escaped = 1;
+      decoder->escapes++;
+      continue;
+    }
+    else if (c == END)
+    {
+      // empty packets are just line noise protection
+      if (decoder->received > 0)
+      {
+        *packet_length    = decoder->received;
+        decoder->complete = 1;
+        return consumed;
+      }
+      continue;
+    }
+
+    if (decoder->received < decoder->size)
+    {
+      decoder->packet[decoder->received++] = c;
+    }
+  }
+
+  return consumed;
+}
@@ -59,4 +59,66 @@ int slip_transmit_packet(struct conbee_device *dev, uint8_t *buffer, uint32_t le
 */
 int slip_receive_packet(struct conbee_device *dev, uint8_t *buffer, uint32_t length);
 
+/**
+* @brief slip encode binary data into a buffer without the framing END bytes
+*
+* the output buffer has to provide at least 2*length bytes, which is the worst case
+* of every byte requiring an escape sequence
+*
+* @param buffer - the data to encode
+* @param length - the number of bytes to encode
+* @param output - the buffer the encoded bytes are written to
+*
+* @return the number of bytes written to output
+*/
+uint32_t slip_encode(uint8_t *buffer, uint32_t length, uint8_t *output);
+
+/**
+* @brief state of an incremental slip decoder
+*/
+struct slip_decoder
+{
+  /// buffer receiving the decoded packet
+  uint8_t *packet;
+
+  /// size of the packet buffer
+  uint32_t size;
+
+  /// number of bytes of the current packet decoded so far
+  uint32_t received;
+
+  /// the last byte was an escape byte
+  uint8_t escaped;
+
+  /// the packet has been returned and is dropped on the next call
+  uint8_t complete;
+
+  /// number of escape sequences decoded, may be reset by the user
+  uint32_t escapes;
+};
+
+/**
+* @brief initialize an incremental slip decoder
+*
+* @param decoder - the decoder
+* @param packet  - buffer receiving the decoded packets
+* @param size    - size of the packet buffer, longer packets are truncated
+*/
+void slip_decoder_init(struct slip_decoder *decoder, uint8_t *packet, uint32_t size);
+
+/**
+* @brief feed received bytes into an incremental slip decoder
+*
+* decoding stops after the first complete packet, call the function again with the
+* remaining bytes. The packet stays valid until the decoder is fed again.
+*
+* @param decoder       - the decoder
+* @param input         - the received bytes
+* @param length        - the number of received bytes
+* @param packet_length - set to the length of the decoded packet, 0 if no packet is complete yet
+*
+* @return the number of bytes consumed from input
+*/
+uint32_t slip_decode(struct slip_decoder *decoder, uint8_t *input, uint32_t length, uint32_t *packet_length);
+
 #endif
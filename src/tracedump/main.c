@@ -0,0 +1,208 @@
+/*
+ * This file is part of the libconbee library distribution (https://gitcloud.federationhq.de/byterazor/libconbee)
+ * Copyright (c) 2019 Dominik Meyer <dmeyer@federationhq.de>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file */
+#include <argparse.h>
+#include <conbee.h>
+#include <conbee-trace.h>
+#include <slip.h>
+#include <crc16.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+* @brief return a readable name for a command
+*/
+static const char * tracedump_command_name(uint8_t command)
+{
+  switch(command)
+  {
+    case COMMAND_DEVICE_STATE:          return "DEVICE_STATE";
+    case COMMAND_CHANGE_NETWORK_STATE:  return "CHANGE_NETWORK_STATE";
+    case COMMAND_READ_PARAMETER:        return "READ_PARAMETER";
+    case COMMAND_WRITE_PARAMETER:       return "WRITE_PARAMETER";
+    case COMMAND_DEVICE_STATE_CHANGED:  return "DEVICE_STATE_CHANGED";
+    case COMMAND_VERSION:               return "VERSION";
+    case COMMAND_APS_DATA_REQUEST:      return "APS_DATA_REQUEST";
+    case COMMAND_APS_DATA_CONFIRM:      return "APS_DATA_CONFIRM";
+    case COMMAND_APS_DATA_INDICATION:   return "APS_DATA_INDICATION";
+    default:                            return "UNKNOWN";
+  }
+}
+
+/**
+* @brief print the wall clock time of a record timestamp
+*/
+static void tracedump_print_time(struct conbee_trace_header *header, uint64_t timestamp_ns)
+{
+  uint64_t realtime = timestamp_ns + header->realtime_offset_ns;
+  time_t seconds    = realtime / 1000000000;
+  struct tm tm;
+  char buffer[32];
+
+  localtime_r(&seconds, &tm);
+  strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm);
+  printf("%s.%06lu", buffer, (unsigned long) (realtime % 1000000000) / 1000);
+}
+
+/**
+* @brief print bytes as hex
+*/
+static void tracedump_print_hex(uint8_t *data, uint32_t length)
+{
+  for(uint32_t i = 0; i < length; i++)
+  {
+    printf(" %02x", data[i]);
+  }
+}
+
+/**
+* @brief print one decoded packet
+*/
+static void tracedump_print_packet(struct conbee_trace_header *header, uint64_t timestamp_ns, uint8_t direction,
+                                   uint8_t *packet, uint32_t length)
+{
+  tracedump_print_time(header, timestamp_ns);
+  printf(" %s", direction == CONBEE_TRACE_TX ? "TX" : "RX");
+
+  if (length < 5 + sizeof(uint16_t))
+  {
+    printf(" short packet");
+    tracedump_print_hex(packet, length);
+    printf("\n");
+    return;
+  }
+
+  uint16_t crc = packet[length - 2] | (packet[length - 1] << 8);
+
+  printf(" %-20s cmd 0x%02x seq %3u status 0x%02x len %4u crc %s  ", tracedump_command_name(packet[0]), packet[0], packet[1],
+         packet[2], packet[3] | (packet[4] << 8), crc16(packet, length - 2) == crc ? "ok " : "bad");
+  tracedump_print_hex(&packet[5], length - 5 - sizeof(uint16_t));
+  printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+  struct arg_parse_ctx *argparse_ctx = argparse_init();
+  char file_name[200] = "";
+  int raw             = 0;
+
+  // argument for the trace file
+  struct arg_str file_arg = {
+      {ARG_STR,1,0},
+      'f',
+      "file",
+      file_name,
+      199,
+      "the wire trace to decode"
+  };
+  argparse_add_string(argparse_ctx, &file_arg);
+
+  struct arg_int raw_arg = {{ARG_INT,0,0}, 'x', "raw", "1 to print the raw bytes of every record as well", &raw};
+  argparse_add_int(argparse_ctx, &raw_arg);
+
+  /// parse the commandline
+  argparse_parse(argparse_ctx, argc, argv);
+  argparse_free(argparse_ctx);
+
+  FILE *file = fopen(file_name, "r");
+  if (file == NULL)
+  {
+    perror("error: opening trace failed");
+    return -1;
+  }
+
+  struct conbee_trace_header header;
+  if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != CONBEE_TRACE_MAGIC ||
+      header.version != CONBEE_TRACE_VERSION || header.header_size != sizeof(header) ||
+      header.size < CONBEE_TRACE_MIN_SIZE || header.size % CONBEE_TRACE_ALIGN != 0 ||
+      header.tail > header.head || header.head - header.tail > header.size)
+  {
+    fprintf(stderr,"error: %s is no valid wire trace\n", file_name);
+    fclose(file);
+    return -1;
+  }
+
+  uint8_t *ring = malloc(header.size);
+  if (ring == NULL || fread(ring, header.size, 1, file) != 1)
+  {
+    fprintf(stderr,"error: %s is truncated\n", file_name);
+    free(ring);
+    fclose(file);
+    return -1;
+  }
+  fclose(file);
+
+  printf("# %lu records written, %lu bytes of %lu in the ring\n", (unsigned long) header.records,
+         (unsigned long) (header.head - header.tail), (unsigned long) header.size);
+
+  // each direction is a separate byte stream, the first packet of each may be cut off
+  uint8_t packets[2][2 * 1024];
+  struct slip_decoder decoders[2];
+  slip_decoder_init(&decoders[0], packets[0], sizeof(packets[0]));
+  slip_decoder_init(&decoders[1], packets[1], sizeof(packets[1]));
+
+  uint64_t position = header.tail;
+  while(position < header.head)
+  {
+    struct conbee_trace_record *record = (struct conbee_trace_record *) &ring[position % header.size];
+    uint64_t record_size = conbee_trace_record_size(record->length);
+
+    if (position % header.size + record_size > header.size || position + record_size > header.head)
+    {
+      fprintf(stderr,"error: corrupted record at position %lu\n", (unsigned long) position);
+      free(ring);
+      return -1;
+    }
+
+    position += record_size;
+
+    if (record->direction != CONBEE_TRACE_TX && record->direction != CONBEE_TRACE_RX)
+    {
+      continue;
+    }
+
+    uint8_t *data = (uint8_t *) record + sizeof(struct conbee_trace_record);
+
+    if (raw)
+    {
+      tracedump_print_time(&header, record->timestamp_ns);
+      printf(" %s raw", record->direction == CONBEE_TRACE_TX ? "TX" : "RX");
+      tracedump_print_hex(data, record->length);
+      printf("\n");
+    }
+
+    struct slip_decoder *decoder = &decoders[record->direction - 1];
+    uint32_t offset = 0;
+    while(offset < record->length)
+    {
+      uint32_t packet_length = 0;
+
+      offset += slip_decode(decoder, &data[offset], record->length - offset, &packet_length);
+      if (packet_length > 0)
+      {
+        tracedump_print_packet(&header, record->timestamp_ns, record->direction, decoder->packet, packet_length);
+      }
+    }
+  }
+
+  free(ring);
+
+  return 0;
+}